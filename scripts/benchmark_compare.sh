@@ -0,0 +1,44 @@
+#!/bin/sh
+# Benchmarks two builds of the program with the same options and reports the per-stage speedup of the second.
+#
+# Usage: scripts/benchmark_compare.sh <baseline program> <candidate program> [program options...]
+#
+# Speedups compare the median of every stage, above 1.00 the candidate is faster
+
+set -u
+
+if [ $# -lt 2 ]; then
+  echo "Usage: $0 <baseline program> <candidate program> [program options...]" >&2
+  exit 1
+fi
+
+baseline_program="$1"
+candidate_program="$2"
+shift 2
+
+baseline_log=$(mktemp) || exit 1
+candidate_log=$(mktemp) || exit 1
+trap 'rm -f "$baseline_log" "$candidate_log"' EXIT
+
+"$baseline_program" --benchmark "$@" > "$baseline_log" 2>&1 || { cat "$baseline_log" >&2; exit 1; }
+"$candidate_program" --benchmark "$@" > "$candidate_log" 2>&1 || { cat "$candidate_log" >&2; exit 1; }
+
+# Stage rows follow the percentile header, the median is the fourth column
+awk '
+  FNR == 1 { in_stages = 0 }
+  $1 == "stage" { in_stages = 1; next }
+  in_stages && NF == 7 {
+    if (FNR == NR) { baseline[$1] = $4; order[++stage_count] = $1 }
+    else { candidate[$1] = $4 }
+  }
+  END {
+    printf "%-10s %13s %13s %8s\n", "stage", "baseline p50", "candidate p50", "speedup"
+    for (stage_index = 1; stage_index <= stage_count; stage_index++) {
+      stage = order[stage_index]
+      if (candidate[stage] > 0)
+        printf "%-10s %13.4f %13.4f %8.2f\n", stage, baseline[stage], candidate[stage], baseline[stage] / candidate[stage]
+      else
+        printf "%-10s %13.4f %13.4f %8s\n", stage, baseline[stage], candidate[stage], "-"
+    }
+  }
+' "$baseline_log" "$candidate_log"
@@ -0,0 +1,46 @@
+#!/bin/sh
+# Benchmarks every texture upload mode on every render driver and writes one JSON report per combination.
+#
+# Usage: scripts/benchmark_upload.sh <program> [report directory] [extra program options...]
+#
+# Drivers without a texture format laid out like the client-side pixels only support the convert mode,
+# the other modes are reported as skipped for them
+
+set -u
+
+if [ $# -lt 1 ]; then
+  echo "Usage: $0 <program> [report directory] [extra program options...]" >&2
+  exit 1
+fi
+
+program="$1"
+report_directory="${2:-benchmark_upload}"
+shift
+[ $# -gt 0 ] && shift
+
+mkdir -p "$report_directory" || exit 1
+
+# List the drivers headless as well, so servers without a display do not end up benchmarking nothing
+drivers=$("$program" --list-renderers --headless | grep -v '^ ' | cut -d ' ' -f 1)
+if [ -z "$drivers" ]; then
+  echo "No render drivers found, see $program --list-renderers --headless" >&2
+  exit 1
+fi
+
+failures=0
+
+for driver in $drivers; do
+  for upload_mode in convert bulk rows update; do
+    report_path="$report_directory/${driver}_${upload_mode}.json"
+    printf '%-12s %-8s ' "$driver" "$upload_mode"
+    if "$program" --headless --renderer "$driver" --upload "$upload_mode" --benchmark-report "$report_path" "$@" > "$report_directory/${driver}_${upload_mode}.log" 2>&1; then
+      # The median of the stages between filling the client-side pixels and clearing the renderer
+      awk '$1 == "lock" || $1 == "convert" || $1 == "unlock" { median += $4 } END { printf "upload median %.4f ms\n", median }' "$report_directory/${driver}_${upload_mode}.log"
+    else
+      echo "skipped, see $report_directory/${driver}_${upload_mode}.log"
+      failures=$((failures + 1))
+    fi
+  done
+done
+
+[ "$failures" -eq 0 ]
@@ -0,0 +1,338 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <SDL.h>
+#include "benchmark.h"
+
+/* Constants */
+static const char * const BENCHMARK_STAGE_NAMES[BENCHMARK_STAGE_COUNT] = {
+  "events", "fill", "lock", "convert", "unlock", "clear", "copy", "capture", "present", "frame"
+};
+static const uint64_t BENCHMARK_INITIAL_CAPACITY = 1024;
+
+/* Datatypes */
+typedef struct {
+  double min_ms;
+  double mean_ms;
+  double p50_ms;
+  double p95_ms;
+  double p99_ms;
+  double max_ms;
+} benchmark_statistics_ts;
+
+static int compare_samples(const void * p_first, const void * p_second)
+{
+  const uint64_t first = *(const uint64_t *)p_first;
+  const uint64_t second = *(const uint64_t *)p_second;
+  return (first > second) - (first < second);
+}
+
+/* Nearest-rank percentile of sorted samples */
+static uint64_t sorted_percentile(const uint64_t * p_sorted_samples, uint64_t sample_count, unsigned int percentile)
+{
+  uint64_t rank = ((sample_count * percentile) + 99) / 100;
+  if (rank == 0)
+    rank = 1;
+  return p_sorted_samples[rank - 1];
+}
+
+static int benchmark_statistics(const benchmark_ts * p_benchmark, benchmark_stage_te stage, benchmark_statistics_ts * p_statistics)
+{
+  SDL_memset(p_statistics, 0, sizeof(*p_statistics));
+  const uint64_t sample_count = p_benchmark->frames_recorded;
+  if (sample_count == 0)
+    return 0;
+
+  uint64_t * const p_sorted_samples = malloc(sizeof(uint64_t) * sample_count);
+  if (p_sorted_samples == NULL)
+  {
+    fprintf(stderr, "\nCould not allocate benchmark statistics buffer - Error: Malloc failed");
+    return -1;
+  }
+  SDL_memcpy(p_sorted_samples, p_benchmark->p_samples[stage], sizeof(uint64_t) * sample_count);
+  qsort(p_sorted_samples, sample_count, sizeof(uint64_t), compare_samples);
+
+  double sample_sum = 0.0;
+  for (uint64_t sample_index = 0; sample_index < sample_count; sample_index++)
+  {
+    sample_sum += (double)p_sorted_samples[sample_index];
+  }
+
+  const double millis_per_tick = 1000.0 / (double)p_benchmark->counter_frequency;
+  p_statistics->min_ms = (double)p_sorted_samples[0] * millis_per_tick;
+  p_statistics->mean_ms = (sample_sum / (double)sample_count) * millis_per_tick;
+  p_statistics->p50_ms = (double)sorted_percentile(p_sorted_samples, sample_count, 50) * millis_per_tick;
+  p_statistics->p95_ms = (double)sorted_percentile(p_sorted_samples, sample_count, 95) * millis_per_tick;
+  p_statistics->p99_ms = (double)sorted_percentile(p_sorted_samples, sample_count, 99) * millis_per_tick;
+  p_statistics->max_ms = (double)p_sorted_samples[sample_count - 1] * millis_per_tick;
+
+  free(p_sorted_samples);
+  return 0;
+}
+
+static int benchmark_reserve(benchmark_ts * p_benchmark, uint64_t frames_required)
+{
+  if (frames_required <= p_benchmark->frames_capacity)
+    return 0;
+
+  uint64_t frames_capacity = (p_benchmark->frames_capacity != 0) ? p_benchmark->frames_capacity : BENCHMARK_INITIAL_CAPACITY;
+  while (frames_capacity < frames_required)
+  {
+    frames_capacity *= 2;
+  }
+
+  for (int stage = 0; stage < BENCHMARK_STAGE_COUNT; stage++)
+  {
+    uint64_t * const p_samples = realloc(p_benchmark->p_samples[stage], sizeof(uint64_t) * frames_capacity);
+    if (p_samples == NULL)
+    {
+      fprintf(stderr, "\nCould not grow benchmark sample buffer - Error: Realloc failed");
+      return -1;
+    }
+    p_benchmark->p_samples[stage] = p_samples;
+  }
+
+  p_benchmark->frames_capacity = frames_capacity;
+  return 0;
+}
+
+static void write_json_string(FILE * p_stream, const char * p_string)
+{
+  fputc('"', p_stream);
+  for (; *p_string != '\0'; p_string++)
+  {
+    if (*p_string == '"' || *p_string == '\\')
+      fputc('\\', p_stream);
+    fputc(*p_string, p_stream);
+  }
+  fputc('"', p_stream);
+}
+
+/* Function definitions */
+int benchmark_init(benchmark_ts * p_benchmark, uint64_t frames_expected, uint64_t warmup_frames)
+{
+  SDL_memset(p_benchmark, 0, sizeof(*p_benchmark));
+  p_benchmark->enabled = 1;
+  p_benchmark->frames_to_skip = warmup_frames;
+  p_benchmark->counter_frequency = SDL_GetPerformanceFrequency();
+
+  /* Reserve all samples up front when the frame count is known, so recording never allocates mid-run */
+  return benchmark_reserve(p_benchmark, (frames_expected != 0) ? frames_expected : BENCHMARK_INITIAL_CAPACITY);
+}
+
+void benchmark_free(benchmark_ts * p_benchmark)
+{
+  for (int stage = 0; stage < BENCHMARK_STAGE_COUNT; stage++)
+  {
+    free(p_benchmark->p_samples[stage]);
+    p_benchmark->p_samples[stage] = NULL;
+  }
+  p_benchmark->frames_capacity = 0;
+  p_benchmark->frames_recorded = 0;
+  p_benchmark->enabled = 0;
+}
+
+void benchmark_set_property(benchmark_ts * p_benchmark, const char * p_key, const char * p_value_format, ...)
+{
+  /* Replace the value of an existing key, otherwise append the key if there is room left */
+  int property_index = 0;
+  while (property_index < p_benchmark->property_count && SDL_strcmp(p_benchmark->properties[property_index].p_key, p_key) != 0)
+  {
+    property_index++;
+  }
+
+  if (property_index == BENCHMARK_MAX_PROPERTIES)
+    return;
+
+  if (property_index == p_benchmark->property_count)
+    p_benchmark->property_count++;
+
+  benchmark_property_ts * const p_property = &p_benchmark->properties[property_index];
+  p_property->p_key = p_key;
+
+  va_list value_arguments;
+  va_start(value_arguments, p_value_format);
+  vsnprintf(p_property->value, sizeof(p_property->value), p_value_format, value_arguments);
+  va_end(value_arguments);
+}
+
+void benchmark_begin_frame(benchmark_ts * p_benchmark)
+{
+  if (!p_benchmark->enabled)
+    return;
+
+  const uint64_t counter_now = SDL_GetPerformanceCounter();
+  p_benchmark->frame_started = counter_now;
+  p_benchmark->stage_started = counter_now;
+  p_benchmark->recording = 0;
+
+  /* Warmup frames run through every stage but are not recorded */
+  if (p_benchmark->frames_to_skip > 0)
+  {
+    p_benchmark->frames_to_skip--;
+    return;
+  }
+
+  if (benchmark_reserve(p_benchmark, p_benchmark->frames_recorded + 1) != 0)
+    return;
+
+  for (int stage = 0; stage < BENCHMARK_STAGE_COUNT; stage++)
+  {
+    p_benchmark->p_samples[stage][p_benchmark->frames_recorded] = 0;
+  }
+  p_benchmark->recording = 1;
+}
+
+void benchmark_mark(benchmark_ts * p_benchmark, benchmark_stage_te stage)
+{
+  if (!p_benchmark->enabled)
+    return;
+
+  const uint64_t counter_now = SDL_GetPerformanceCounter();
+
+  /* Accumulate, so a stage running several times per frame reports its total frame time */
+  if (p_benchmark->recording)
+    p_benchmark->p_samples[stage][p_benchmark->frames_recorded] += counter_now - p_benchmark->stage_started;
+
+  p_benchmark->stage_started = counter_now;
+}
+
+void benchmark_end_frame(benchmark_ts * p_benchmark)
+{
+  if (!p_benchmark->recording)
+    return;
+
+  p_benchmark->p_samples[BENCHMARK_STAGE_FRAME][p_benchmark->frames_recorded] = SDL_GetPerformanceCounter() - p_benchmark->frame_started;
+  p_benchmark->frames_recorded++;
+  p_benchmark->recording = 0;
+}
+
+const char * benchmark_stage_name(benchmark_stage_te stage)
+{
+  return ((int)stage >= 0 && stage < BENCHMARK_STAGE_COUNT) ? BENCHMARK_STAGE_NAMES[stage] : "unknown";
+}
+
+void benchmark_print_summary(const benchmark_ts * p_benchmark, FILE * p_stream)
+{
+  for (int property_index = 0; property_index < p_benchmark->property_count; property_index++)
+  {
+    fprintf(p_stream, "%-12s %s\n", p_benchmark->properties[property_index].p_key, p_benchmark->properties[property_index].value);
+  }
+  fprintf(p_stream, "%-12s %llu\n\n", "frames", (unsigned long long)p_benchmark->frames_recorded);
+
+  fprintf(p_stream, "%-10s %10s %10s %10s %10s %10s %10s\n", "stage [ms]", "min", "mean", "p50", "p95", "p99", "max");
+  for (int stage = 0; stage < BENCHMARK_STAGE_COUNT; stage++)
+  {
+    benchmark_statistics_ts statistics;
+    if (benchmark_statistics(p_benchmark, (benchmark_stage_te)stage, &statistics) != 0)
+      return;
+
+    fprintf(
+      p_stream,
+      "%-10s %10.4f %10.4f %10.4f %10.4f %10.4f %10.4f\n",
+      BENCHMARK_STAGE_NAMES[stage],
+      statistics.min_ms,
+      statistics.mean_ms,
+      statistics.p50_ms,
+      statistics.p95_ms,
+      statistics.p99_ms,
+      statistics.max_ms
+    );
+  }
+}
+
+/* Writes a CSV report for paths ending in .csv and a JSON report otherwise */
+int benchmark_write_report(const benchmark_ts * p_benchmark, const char * p_report_path)
+{
+  const size_t path_length = strlen(p_report_path);
+  const int write_csv = (path_length >= 4) && (SDL_strcmp(p_report_path + path_length - 4, ".csv") == 0);
+
+  FILE * const p_report = fopen(p_report_path, "w");
+  if (p_report == NULL)
+  {
+    fprintf(stderr, "\nBenchmark report '%s' could not be opened for writing", p_report_path);
+    return -1;
+  }
+
+  if (write_csv)
+  {
+    fprintf(p_report, "stage,frames,min_ms,mean_ms,p50_ms,p95_ms,p99_ms,max_ms");
+    for (int property_index = 0; property_index < p_benchmark->property_count; property_index++)
+    {
+      fprintf(p_report, ",%s", p_benchmark->properties[property_index].p_key);
+    }
+    fprintf(p_report, "\n");
+  }
+  else
+  {
+    fprintf(p_report, "{\n  \"frames\": %llu,\n  \"properties\": {", (unsigned long long)p_benchmark->frames_recorded);
+    for (int property_index = 0; property_index < p_benchmark->property_count; property_index++)
+    {
+      fprintf(p_report, "%s\n    ", (property_index == 0) ? "" : ",");
+      write_json_string(p_report, p_benchmark->properties[property_index].p_key);
+      fprintf(p_report, ": ");
+      write_json_string(p_report, p_benchmark->properties[property_index].value);
+    }
+    fprintf(p_report, "\n  },\n  \"stages\": {");
+  }
+
+  int report_status = 0;
+  for (int stage = 0; stage < BENCHMARK_STAGE_COUNT; stage++)
+  {
+    benchmark_statistics_ts statistics;
+    if (benchmark_statistics(p_benchmark, (benchmark_stage_te)stage, &statistics) != 0)
+    {
+      report_status = -1;
+      break;
+    }
+
+    if (write_csv)
+    {
+      fprintf(
+        p_report,
+        "%s,%llu,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f",
+        BENCHMARK_STAGE_NAMES[stage],
+        (unsigned long long)p_benchmark->frames_recorded,
+        statistics.min_ms,
+        statistics.mean_ms,
+        statistics.p50_ms,
+        statistics.p95_ms,
+        statistics.p99_ms,
+        statistics.max_ms
+      );
+      for (int property_index = 0; property_index < p_benchmark->property_count; property_index++)
+      {
+        fprintf(p_report, ",%s", p_benchmark->properties[property_index].value);
+      }
+      fprintf(p_report, "\n");
+    }
+    else
+    {
+      fprintf(
+        p_report,
+        "%s\n    \"%s\": { \"min_ms\": %.6f, \"mean_ms\": %.6f, \"p50_ms\": %.6f, \"p95_ms\": %.6f, \"p99_ms\": %.6f, \"max_ms\": %.6f }",
+        (stage == 0) ? "" : ",",
+        BENCHMARK_STAGE_NAMES[stage],
+        statistics.min_ms,
+        statistics.mean_ms,
+        statistics.p50_ms,
+        statistics.p95_ms,
+        statistics.p99_ms,
+        statistics.max_ms
+      );
+    }
+  }
+
+  if (!write_csv)
+    fprintf(p_report, "\n  }\n}\n");
+
+  if (fclose(p_report) != 0)
+  {
+    fprintf(stderr, "\nBenchmark report '%s' could not be written", p_report_path);
+    report_status = -1;
+  }
+
+  return report_status;
+}
@@ -0,0 +1,60 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+/* Defines */
+#define BENCHMARK_MAX_PROPERTIES (32)
+
+/* Datatypes */
+typedef enum {
+  BENCHMARK_STAGE_EVENTS = 0,
+  BENCHMARK_STAGE_FILL,
+  BENCHMARK_STAGE_LOCK,
+  BENCHMARK_STAGE_CONVERT,
+  BENCHMARK_STAGE_UNLOCK,
+  BENCHMARK_STAGE_CLEAR,
+  BENCHMARK_STAGE_COPY,
+  BENCHMARK_STAGE_CAPTURE,
+  BENCHMARK_STAGE_PRESENT,
+  BENCHMARK_STAGE_FRAME,
+  BENCHMARK_STAGE_COUNT
+} benchmark_stage_te;
+
+typedef struct {
+  const char * p_key;
+  char value[64];
+} benchmark_property_ts;
+
+/*
+    Per-frame stage timings in performance counter ticks.
+    A stage lasts from the previous mark of the frame, or the frame start, up to its own mark.
+    All functions are no-ops on a zero-initialized benchmark that was never initialized
+*/
+typedef struct {
+  int enabled;
+  uint64_t * p_samples[BENCHMARK_STAGE_COUNT];
+  uint64_t frames_recorded;
+  uint64_t frames_capacity;
+  uint64_t frames_to_skip;
+  uint64_t frame_started;
+  uint64_t stage_started;
+  uint64_t counter_frequency;
+  int recording;
+  benchmark_property_ts properties[BENCHMARK_MAX_PROPERTIES];
+  int property_count;
+} benchmark_ts;
+
+/* Function prototypes */
+int benchmark_init(benchmark_ts * p_benchmark, uint64_t frames_expected, uint64_t warmup_frames);
+void benchmark_free(benchmark_ts * p_benchmark);
+void benchmark_set_property(benchmark_ts * p_benchmark, const char * p_key, const char * p_value_format, ...);
+void benchmark_begin_frame(benchmark_ts * p_benchmark);
+void benchmark_mark(benchmark_ts * p_benchmark, benchmark_stage_te stage);
+void benchmark_end_frame(benchmark_ts * p_benchmark);
+const char * benchmark_stage_name(benchmark_stage_te stage);
+void benchmark_print_summary(const benchmark_ts * p_benchmark, FILE * p_stream);
+int benchmark_write_report(const benchmark_ts * p_benchmark, const char * p_report_path);
+
+#endif
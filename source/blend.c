@@ -0,0 +1,576 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <SDL.h>
+#include "blend.h"
+#include "blit.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BLEND_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+/* Constants */
+static const char * const BLEND_MODE_NAMES[BLEND_MODE_COUNT] = { "source-over", "additive", "multiply" };
+
+/*
+    Blend modes on premultiplied pixels, applied alike to the color channels and the alpha channel:
+
+      source-over  result = source + destination * (255 - source alpha) / 255
+      additive     result = source + destination, saturated
+      multiply     result = (source * destination + source * (255 - destination alpha) + destination * (255 - source alpha)) / 255
+
+    Every division by 255 rounds to the nearest integer. The multiply sum never exceeds 255 * 255 for
+    premultiplied pixels, which keeps it within the 16-bit lanes of the vectorized kernels
+*/
+static uint8_t blend_div255(uint32_t value)
+{
+  value += 128;
+  return (uint8_t)((value + (value >> 8)) >> 8);
+}
+
+static void blend_row_source_over(client_pixel_rgba_ts * p_destination_row, const client_pixel_rgba_ts * p_source_row, int pixel_count)
+{
+  for (int pixel_x = 0; pixel_x < pixel_count; pixel_x++)
+  {
+    const client_pixel_rgba_ts source = p_source_row[pixel_x];
+    client_pixel_rgba_ts * const p_destination = &p_destination_row[pixel_x];
+    const uint32_t destination_weight = 255u - source.alpha;
+    p_destination->red = (uint8_t)SDL_min(255u, source.red + blend_div255(p_destination->red * destination_weight));
+    p_destination->green = (uint8_t)SDL_min(255u, source.green + blend_div255(p_destination->green * destination_weight));
+    p_destination->blue = (uint8_t)SDL_min(255u, source.blue + blend_div255(p_destination->blue * destination_weight));
+    p_destination->alpha = (uint8_t)SDL_min(255u, source.alpha + blend_div255(p_destination->alpha * destination_weight));
+  }
+}
+
+static void blend_row_additive(client_pixel_rgba_ts * p_destination_row, const client_pixel_rgba_ts * p_source_row, int pixel_count)
+{
+  for (int pixel_x = 0; pixel_x < pixel_count; pixel_x++)
+  {
+    const client_pixel_rgba_ts source = p_source_row[pixel_x];
+    client_pixel_rgba_ts * const p_destination = &p_destination_row[pixel_x];
+    p_destination->red = (uint8_t)SDL_min(255u, (uint32_t)source.red + p_destination->red);
+    p_destination->green = (uint8_t)SDL_min(255u, (uint32_t)source.green + p_destination->green);
+    p_destination->blue = (uint8_t)SDL_min(255u, (uint32_t)source.blue + p_destination->blue);
+    p_destination->alpha = (uint8_t)SDL_min(255u, (uint32_t)source.alpha + p_destination->alpha);
+  }
+}
+
+static uint8_t blend_multiply_channel(uint32_t source, uint32_t destination, uint32_t source_alpha, uint32_t destination_alpha)
+{
+  return blend_div255((source * (destination + 255u - destination_alpha)) + (destination * (255u - source_alpha)));
+}
+
+static void blend_row_multiply(client_pixel_rgba_ts * p_destination_row, const client_pixel_rgba_ts * p_source_row, int pixel_count)
+{
+  for (int pixel_x = 0; pixel_x < pixel_count; pixel_x++)
+  {
+    const client_pixel_rgba_ts source = p_source_row[pixel_x];
+    const client_pixel_rgba_ts destination = p_destination_row[pixel_x];
+    client_pixel_rgba_ts * const p_destination = &p_destination_row[pixel_x];
+    p_destination->red = blend_multiply_channel(source.red, destination.red, source.alpha, destination.alpha);
+    p_destination->green = blend_multiply_channel(source.green, destination.green, source.alpha, destination.alpha);
+    p_destination->blue = blend_multiply_channel(source.blue, destination.blue, source.alpha, destination.alpha);
+    p_destination->alpha = blend_multiply_channel(source.alpha, destination.alpha, source.alpha, destination.alpha);
+  }
+}
+
+#ifdef BLEND_X86_KERNELS
+/*
+    Vectorized kernels widen the pixels to 16-bit lanes, two pixels per 128-bit lane, where the alpha
+    of each pixel is its fourth lane and is broadcast to the other three lanes of the same pixel
+*/
+__attribute__((target("sse2")))
+static __m128i blend_div255_sse2(__m128i values)
+{
+  values = _mm_add_epi16(values, _mm_set1_epi16(128));
+  return _mm_srli_epi16(_mm_add_epi16(values, _mm_srli_epi16(values, 8)), 8);
+}
+
+__attribute__((target("sse2")))
+static __m128i blend_broadcast_alpha_sse2(__m128i pixels)
+{
+  return _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+__attribute__((target("sse2")))
+static __m128i blend_source_over_sse2(__m128i source, __m128i destination)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i full = _mm_set1_epi16(255);
+  const __m128i weight_low = _mm_sub_epi16(full, blend_broadcast_alpha_sse2(_mm_unpacklo_epi8(source, zero)));
+  const __m128i weight_high = _mm_sub_epi16(full, blend_broadcast_alpha_sse2(_mm_unpackhi_epi8(source, zero)));
+  const __m128i destination_low = blend_div255_sse2(_mm_mullo_epi16(_mm_unpacklo_epi8(destination, zero), weight_low));
+  const __m128i destination_high = blend_div255_sse2(_mm_mullo_epi16(_mm_unpackhi_epi8(destination, zero), weight_high));
+  return _mm_adds_epu8(source, _mm_packus_epi16(destination_low, destination_high));
+}
+
+__attribute__((target("sse2")))
+static __m128i blend_multiply_sse2(__m128i source, __m128i destination)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i full = _mm_set1_epi16(255);
+  const __m128i source_low = _mm_unpacklo_epi8(source, zero);
+  const __m128i source_high = _mm_unpackhi_epi8(source, zero);
+  const __m128i destination_low = _mm_unpacklo_epi8(destination, zero);
+  const __m128i destination_high = _mm_unpackhi_epi8(destination, zero);
+
+  const __m128i result_low = blend_div255_sse2(_mm_add_epi16(
+    _mm_mullo_epi16(source_low, _mm_add_epi16(destination_low, _mm_sub_epi16(full, blend_broadcast_alpha_sse2(destination_low)))),
+    _mm_mullo_epi16(destination_low, _mm_sub_epi16(full, blend_broadcast_alpha_sse2(source_low)))
+  ));
+  const __m128i result_high = blend_div255_sse2(_mm_add_epi16(
+    _mm_mullo_epi16(source_high, _mm_add_epi16(destination_high, _mm_sub_epi16(full, blend_broadcast_alpha_sse2(destination_high)))),
+    _mm_mullo_epi16(destination_high, _mm_sub_epi16(full, blend_broadcast_alpha_sse2(source_high)))
+  ));
+  return _mm_packus_epi16(result_low, result_high);
+}
+
+/* Four pixels at a time, which are skipped when fully transparent and copied when fully opaque */
+__attribute__((target("sse2")))
+static void blend_row_source_over_sse2(client_pixel_rgba_ts * p_destination_row, const client_pixel_rgba_ts * p_source_row, int pixel_count)
+{
+  const __m128i alpha_mask = _mm_set1_epi32((int)0xFF000000u);
+  int pixel_x = 0;
+  for (; pixel_x + 4 <= pixel_count; pixel_x += 4)
+  {
+    const __m128i source = _mm_loadu_si128((const __m128i *)(p_source_row + pixel_x));
+    const __m128i source_alpha = _mm_and_si128(source, alpha_mask);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(source_alpha, _mm_setzero_si128())) == 0xFFFF)
+      continue;
+
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(source_alpha, alpha_mask)) == 0xFFFF)
+    {
+      _mm_storeu_si128((__m128i *)(p_destination_row + pixel_x), source);
+      continue;
+    }
+
+    const __m128i destination = _mm_loadu_si128((const __m128i *)(p_destination_row + pixel_x));
+    _mm_storeu_si128((__m128i *)(p_destination_row + pixel_x), blend_source_over_sse2(source, destination));
+  }
+  blend_row_source_over(p_destination_row + pixel_x, p_source_row + pixel_x, pixel_count - pixel_x);
+}
+
+__attribute__((target("sse2")))
+static void blend_row_additive_sse2(client_pixel_rgba_ts * p_destination_row, const client_pixel_rgba_ts * p_source_row, int pixel_count)
+{
+  int pixel_x = 0;
+  for (; pixel_x + 4 <= pixel_count; pixel_x += 4)
+  {
+    const __m128i source = _mm_loadu_si128((const __m128i *)(p_source_row + pixel_x));
+    const __m128i destination = _mm_loadu_si128((const __m128i *)(p_destination_row + pixel_x));
+    _mm_storeu_si128((__m128i *)(p_destination_row + pixel_x), _mm_adds_epu8(source, destination));
+  }
+  blend_row_additive(p_destination_row + pixel_x, p_source_row + pixel_x, pixel_count - pixel_x);
+}
+
+__attribute__((target("sse2")))
+static void blend_row_multiply_sse2(client_pixel_rgba_ts * p_destination_row, const client_pixel_rgba_ts * p_source_row, int pixel_count)
+{
+  int pixel_x = 0;
+  for (; pixel_x + 4 <= pixel_count; pixel_x += 4)
+  {
+    const __m128i source = _mm_loadu_si128((const __m128i *)(p_source_row + pixel_x));
+    const __m128i destination = _mm_loadu_si128((const __m128i *)(p_destination_row + pixel_x));
+    _mm_storeu_si128((__m128i *)(p_destination_row + pixel_x), blend_multiply_sse2(source, destination));
+  }
+  blend_row_multiply(p_destination_row + pixel_x, p_source_row + pixel_x, pixel_count - pixel_x);
+}
+
+/* The AVX2 kernels process eight pixels at a time, unpacking and packing within each 128-bit lane */
+__attribute__((target("avx2")))
+static __m256i blend_div255_avx2(__m256i values)
+{
+  values = _mm256_add_epi16(values, _mm256_set1_epi16(128));
+  return _mm256_srli_epi16(_mm256_add_epi16(values, _mm256_srli_epi16(values, 8)), 8);
+}
+
+__attribute__((target("avx2")))
+static __m256i blend_broadcast_alpha_avx2(__m256i pixels)
+{
+  return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+__attribute__((target("avx2")))
+static __m256i blend_source_over_avx2(__m256i source, __m256i destination)
+{
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i full = _mm256_set1_epi16(255);
+  const __m256i weight_low = _mm256_sub_epi16(full, blend_broadcast_alpha_avx2(_mm256_unpacklo_epi8(source, zero)));
+  const __m256i weight_high = _mm256_sub_epi16(full, blend_broadcast_alpha_avx2(_mm256_unpackhi_epi8(source, zero)));
+  const __m256i destination_low = blend_div255_avx2(_mm256_mullo_epi16(_mm256_unpacklo_epi8(destination, zero), weight_low));
+  const __m256i destination_high = blend_div255_avx2(_mm256_mullo_epi16(_mm256_unpackhi_epi8(destination, zero), weight_high));
+  return _mm256_adds_epu8(source, _mm256_packus_epi16(destination_low, destination_high));
+}
+
+__attribute__((target("avx2")))
+static __m256i blend_multiply_avx2(__m256i source, __m256i destination)
+{
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i full = _mm256_set1_epi16(255);
+  const __m256i source_low = _mm256_unpacklo_epi8(source, zero);
+  const __m256i source_high = _mm256_unpackhi_epi8(source, zero);
+  const __m256i destination_low = _mm256_unpacklo_epi8(destination, zero);
+  const __m256i destination_high = _mm256_unpackhi_epi8(destination, zero);
+
+  const __m256i result_low = blend_div255_avx2(_mm256_add_epi16(
+    _mm256_mullo_epi16(source_low, _mm256_add_epi16(destination_low, _mm256_sub_epi16(full, blend_broadcast_alpha_avx2(destination_low)))),
+    _mm256_mullo_epi16(destination_low, _mm256_sub_epi16(full, blend_broadcast_alpha_avx2(source_low)))
+  ));
+  const __m256i result_high = blend_div255_avx2(_mm256_add_epi16(
+    _mm256_mullo_epi16(source_high, _mm256_add_epi16(destination_high, _mm256_sub_epi16(full, blend_broadcast_alpha_avx2(destination_high)))),
+    _mm256_mullo_epi16(destination_high, _mm256_sub_epi16(full, blend_broadcast_alpha_avx2(source_high)))
+  ));
+  return _mm256_packus_epi16(result_low, result_high);
+}
+
+__attribute__((target("avx2")))
+static void blend_row_source_over_avx2(client_pixel_rgba_ts * p_destination_row, const client_pixel_rgba_ts * p_source_row, int pixel_count)
+{
+  const __m256i alpha_mask = _mm256_set1_epi32((int)0xFF000000u);
+  int pixel_x = 0;
+  for (; pixel_x + 8 <= pixel_count; pixel_x += 8)
+  {
+    const __m256i source = _mm256_loadu_si256((const __m256i *)(p_source_row + pixel_x));
+    const __m256i source_alpha = _mm256_and_si256(source, alpha_mask);
+    if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(source_alpha, _mm256_setzero_si256())) == -1)
+      continue;
+
+    if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(source_alpha, alpha_mask)) == -1)
+    {
+      _mm256_storeu_si256((__m256i *)(p_destination_row + pixel_x), source);
+      continue;
+    }
+
+    const __m256i destination = _mm256_loadu_si256((const __m256i *)(p_destination_row + pixel_x));
+    _mm256_storeu_si256((__m256i *)(p_destination_row + pixel_x), blend_source_over_avx2(source, destination));
+  }
+  blend_row_source_over(p_destination_row + pixel_x, p_source_row + pixel_x, pixel_count - pixel_x);
+}
+
+__attribute__((target("avx2")))
+static void blend_row_additive_avx2(client_pixel_rgba_ts * p_destination_row, const client_pixel_rgba_ts * p_source_row, int pixel_count)
+{
+  int pixel_x = 0;
+  for (; pixel_x + 8 <= pixel_count; pixel_x += 8)
+  {
+    const __m256i source = _mm256_loadu_si256((const __m256i *)(p_source_row + pixel_x));
+    const __m256i destination = _mm256_loadu_si256((const __m256i *)(p_destination_row + pixel_x));
+    _mm256_storeu_si256((__m256i *)(p_destination_row + pixel_x), _mm256_adds_epu8(source, destination));
+  }
+  blend_row_additive(p_destination_row + pixel_x, p_source_row + pixel_x, pixel_count - pixel_x);
+}
+
+__attribute__((target("avx2")))
+static void blend_row_multiply_avx2(client_pixel_rgba_ts * p_destination_row, const client_pixel_rgba_ts * p_source_row, int pixel_count)
+{
+  int pixel_x = 0;
+  for (; pixel_x + 8 <= pixel_count; pixel_x += 8)
+  {
+    const __m256i source = _mm256_loadu_si256((const __m256i *)(p_source_row + pixel_x));
+    const __m256i destination = _mm256_loadu_si256((const __m256i *)(p_destination_row + pixel_x));
+    _mm256_storeu_si256((__m256i *)(p_destination_row + pixel_x), blend_multiply_avx2(source, destination));
+  }
+  blend_row_multiply(p_destination_row + pixel_x, p_source_row + pixel_x, pixel_count - pixel_x);
+}
+#endif
+
+static void blend_blit_row(const void * p_context, void * p_destination_row, const void * p_source_row, int texel_count)
+{
+  const blender_ts * const p_blender = (const blender_ts *)p_context;
+  p_blender->blend_row((client_pixel_rgba_ts *)p_destination_row, (const client_pixel_rgba_ts *)p_source_row, texel_count);
+}
+
+/* Blends one premultiplied pixel with the formulas evaluated with exact rounding, the reference of the verification */
+static client_pixel_rgba_ts blend_reference_pixel(blend_mode_te mode, const client_pixel_rgba_ts * p_source, const client_pixel_rgba_ts * p_destination)
+{
+  client_pixel_rgba_ts reference;
+  const uint8_t * const p_source_channels = &p_source->red;
+  const uint8_t * const p_destination_channels = &p_destination->red;
+  uint8_t * const p_reference_channels = &reference.red;
+  const uint32_t source_alpha = p_source->alpha;
+  const uint32_t destination_alpha = p_destination->alpha;
+  for (int channel = 0; channel < 4; channel++)
+  {
+    const uint32_t source = p_source_channels[channel];
+    const uint32_t destination = p_destination_channels[channel];
+    uint32_t product_sum = 0;
+    if (mode == BLEND_MODE_SOURCE_OVER)
+      product_sum = (source * 255u) + (destination * (255u - source_alpha));
+    else if (mode == BLEND_MODE_ADDITIVE)
+      product_sum = (source + destination) * 255u;
+    else
+      product_sum = (source * destination) + (source * (255u - destination_alpha)) + (destination * (255u - source_alpha));
+    p_reference_channels[channel] = (uint8_t)SDL_min(255u, ((2u * product_sum) + 255u) / 510u);
+  }
+  return reference;
+}
+
+/* Function definitions */
+void blender_init(blender_ts * p_blender, blend_mode_te mode)
+{
+  /* Dispatch to the widest kernel the CPU supports, the scalar kernel supports all blend modes */
+  const pixel_kernel_te kernel_preference[] = { PIXEL_KERNEL_AVX2, PIXEL_KERNEL_SSE2, PIXEL_KERNEL_SCALAR };
+  for (size_t kernel_index = 0; kernel_index < SDL_arraysize(kernel_preference); kernel_index++)
+  {
+    if (blender_init_kernel(p_blender, mode, kernel_preference[kernel_index]) == 0)
+      return;
+  }
+}
+
+int blender_init_kernel(blender_ts * p_blender, blend_mode_te mode, pixel_kernel_te kernel)
+{
+  if (!pixel_kernel_available(kernel) || (int)mode < 0 || mode >= BLEND_MODE_COUNT)
+    return -1;
+
+  p_blender->mode = mode;
+  p_blender->kernel = kernel;
+  p_blender->p_name = NULL;
+  p_blender->blend_row = NULL;
+
+  switch (kernel)
+  {
+    case PIXEL_KERNEL_SCALAR:
+    {
+      const blend_row_tf blend_rows[BLEND_MODE_COUNT] = { blend_row_source_over, blend_row_additive, blend_row_multiply };
+      p_blender->blend_row = blend_rows[mode];
+      break;
+    }
+#ifdef BLEND_X86_KERNELS
+    case PIXEL_KERNEL_SSE2:
+    {
+      const blend_row_tf blend_rows[BLEND_MODE_COUNT] = { blend_row_source_over_sse2, blend_row_additive_sse2, blend_row_multiply_sse2 };
+      p_blender->blend_row = blend_rows[mode];
+      break;
+    }
+    case PIXEL_KERNEL_AVX2:
+    {
+      const blend_row_tf blend_rows[BLEND_MODE_COUNT] = { blend_row_source_over_avx2, blend_row_additive_avx2, blend_row_multiply_avx2 };
+      p_blender->blend_row = blend_rows[mode];
+      break;
+    }
+#endif
+    default:
+      break;
+  }
+
+  if (p_blender->blend_row == NULL)
+    return -1;
+
+  p_blender->p_name = BLEND_MODE_NAMES[mode];
+  return 0;
+}
+
+/* Blends the whole source with its top-left pixel at (x, y) of the target, limited to the clip rectangle of the target */
+void blend_framebuffer(const blender_ts * p_blender, const raster_target_ts * p_target, int x, int y, const client_framebuffer_ts * p_source)
+{
+  const SDL_Rect source_rect = { x, y, p_source->width, p_source->height };
+  SDL_Rect blend_rect;
+  if (!SDL_IntersectRect(&source_rect, &p_target->clip_rect, &blend_rect))
+    return;
+
+  blit_rows(
+    client_framebuffer_row(&p_target->framebuffer, blend_rect.y) + blend_rect.x,
+    p_target->framebuffer.pitch,
+    client_framebuffer_row(p_source, blend_rect.y - y) + (blend_rect.x - x),
+    p_source->pitch,
+    blend_rect.h,
+    blend_rect.w,
+    blend_blit_row,
+    p_blender
+  );
+}
+
+/* Converts pixels with straight alpha into the premultiplied pixels the blend modes expect */
+void blend_premultiply_row(client_pixel_rgba_ts * p_row, int pixel_count)
+{
+  for (int pixel_x = 0; pixel_x < pixel_count; pixel_x++)
+  {
+    client_pixel_rgba_ts * const p_pixel = &p_row[pixel_x];
+    p_pixel->red = blend_div255((uint32_t)p_pixel->red * p_pixel->alpha);
+    p_pixel->green = blend_div255((uint32_t)p_pixel->green * p_pixel->alpha);
+    p_pixel->blue = blend_div255((uint32_t)p_pixel->blue * p_pixel->alpha);
+  }
+}
+
+const char * blend_mode_name(blend_mode_te mode)
+{
+  return ((int)mode >= 0 && mode < BLEND_MODE_COUNT) ? BLEND_MODE_NAMES[mode] : "unknown";
+}
+
+int blend_mode_from_name(const char * p_mode_name, blend_mode_te * p_mode)
+{
+  for (int mode = 0; mode < BLEND_MODE_COUNT; mode++)
+  {
+    if (SDL_strcmp(p_mode_name, BLEND_MODE_NAMES[mode]) == 0)
+    {
+      *p_mode = (blend_mode_te)mode;
+      return 0;
+    }
+  }
+  return -1;
+}
+
+/*
+    Compares every kernel available on this CPU against the blend formulas evaluated with exact rounding,
+    for premultiplied pixels that favor the fully transparent and fully opaque special cases and a range
+    of row lengths that exercise the vector loop tails. Every combination also blends a framebuffer at positions clipped
+    by every edge of the target and of a clip rectangle, and premultiplying is checked for every channel and alpha value.
+    Returns the number of failed kernel and mode combinations, and of failed premultiply checks
+*/
+int blend_verify_kernels(void)
+{
+  enum { VERIFY_ROW_LENGTH_MAX = 133 };
+  static client_pixel_rgba_ts source_row[VERIFY_ROW_LENGTH_MAX];
+  static client_pixel_rgba_ts destination_row[VERIFY_ROW_LENGTH_MAX];
+  static client_pixel_rgba_ts blended_row[VERIFY_ROW_LENGTH_MAX + 1];
+  static client_pixel_rgba_ts reference_row[VERIFY_ROW_LENGTH_MAX + 1];
+  enum { VERIFY_SOURCE_WIDTH = 11, VERIFY_SOURCE_HEIGHT = 6, VERIFY_SOURCE_PITCH = 13 };
+  enum { VERIFY_TARGET_WIDTH = 23, VERIFY_TARGET_HEIGHT = 17, VERIFY_TARGET_PITCH = 25 };
+  enum { VERIFY_POSITION_COUNT = VERIFY_TARGET_WIDTH + VERIFY_SOURCE_WIDTH + 3 };
+  static client_pixel_rgba_ts source_pixels[VERIFY_SOURCE_PITCH * VERIFY_SOURCE_HEIGHT];
+  static client_pixel_rgba_ts target_pixels[VERIFY_TARGET_PITCH * VERIFY_TARGET_HEIGHT];
+  static client_pixel_rgba_ts reference_target_pixels[VERIFY_TARGET_PITCH * VERIFY_TARGET_HEIGHT];
+  const client_framebuffer_ts source_framebuffer = { source_pixels, VERIFY_SOURCE_WIDTH, VERIFY_SOURCE_HEIGHT, (int)sizeof(client_pixel_rgba_ts) * VERIFY_SOURCE_PITCH };
+  const client_framebuffer_ts target_framebuffer = { target_pixels, VERIFY_TARGET_WIDTH, VERIFY_TARGET_HEIGHT, (int)sizeof(client_pixel_rgba_ts) * VERIFY_TARGET_PITCH };
+  const SDL_Rect inner_clip_rect = { 3, 2, VERIFY_TARGET_WIDTH - 7, VERIFY_TARGET_HEIGHT - 5 };
+
+  /* Deterministic pseudo-random premultiplied pixels, in runs so whole vectors share the special cases */
+  uint32_t random_state = 0x2545F491u;
+  for (int pixel_x = 0; pixel_x < VERIFY_ROW_LENGTH_MAX; pixel_x++)
+  {
+    for (int row = 0; row < 2; row++)
+    {
+      client_pixel_rgba_ts * const p_pixel = (row == 0) ? &source_row[pixel_x] : &destination_row[pixel_x];
+      random_state = (random_state * 1664525u) + 1013904223u;
+      const uint32_t alpha_class = ((uint32_t)pixel_x / 8u + random_state) % 4u;
+      p_pixel->alpha = (alpha_class == 0) ? 0x00 : (alpha_class == 1) ? 0xFF : (uint8_t)(random_state >> 24);
+      p_pixel->red = (uint8_t)(((random_state >> 16) & 0xFFu) * p_pixel->alpha / 255u);
+      p_pixel->green = (uint8_t)(((random_state >> 8) & 0xFFu) * p_pixel->alpha / 255u);
+      p_pixel->blue = (uint8_t)((random_state & 0xFFu) * p_pixel->alpha / 255u);
+    }
+  }
+
+  /* The source framebuffer takes the source pixels row by row, its padding holds pixels that must never be blended */
+  for (int pixel = 0; pixel < VERIFY_SOURCE_PITCH * VERIFY_SOURCE_HEIGHT; pixel++)
+  {
+    source_pixels[pixel] = source_row[pixel % VERIFY_ROW_LENGTH_MAX];
+    if (pixel % VERIFY_SOURCE_PITCH >= VERIFY_SOURCE_WIDTH)
+      SDL_memset(&source_pixels[pixel], 0xFF, sizeof(client_pixel_rgba_ts));
+  }
+
+  int failures = 0;
+  for (int mode = 0; mode < BLEND_MODE_COUNT; mode++)
+  {
+    for (int kernel = 0; kernel < PIXEL_KERNEL_COUNT; kernel++)
+    {
+      blender_ts blender;
+      if (blender_init_kernel(&blender, (blend_mode_te)mode, (pixel_kernel_te)kernel) != 0)
+        continue;
+
+      int kernel_passed = 1;
+      for (int row_length = 0; row_length <= VERIFY_ROW_LENGTH_MAX && kernel_passed; row_length += (row_length < 67) ? 1 : 33)
+      {
+        /* Build the reference row pixel by pixel and poison one pixel past the end of both rows */
+        for (int pixel_x = 0; pixel_x < row_length; pixel_x++)
+        {
+          reference_row[pixel_x] = blend_reference_pixel((blend_mode_te)mode, &source_row[pixel_x], &destination_row[pixel_x]);
+        }
+        SDL_memcpy(blended_row, destination_row, sizeof(client_pixel_rgba_ts) * (size_t)row_length);
+        SDL_memset(&blended_row[row_length], 0xA5, sizeof(client_pixel_rgba_ts));
+        SDL_memset(&reference_row[row_length], 0xA5, sizeof(client_pixel_rgba_ts));
+
+        blender.blend_row(blended_row, source_row, row_length);
+        if (SDL_memcmp(blended_row, reference_row, sizeof(client_pixel_rgba_ts) * (size_t)(row_length + 1)) != 0)
+        {
+          fprintf(stdout, "FAIL  blend %-20s %-8s row length %d\n", blender.p_name, pixel_kernel_name(blender.kernel), row_length);
+          kernel_passed = 0;
+          failures++;
+        }
+      }
+
+      /*
+          Blend a source framebuffer at every position from fully off the left and top edges to fully off the right
+          and bottom edges, into a target with and without an inner clip rectangle. Both framebuffers have padding
+          past every row, which the comparison of the whole target covers as well
+      */
+      for (int position = 0; position < VERIFY_POSITION_COUNT * VERIFY_POSITION_COUNT * 2 && kernel_passed; position++)
+      {
+        const int x = (position % VERIFY_POSITION_COUNT) - VERIFY_SOURCE_WIDTH - 1;
+        const int y = ((position / VERIFY_POSITION_COUNT) % VERIFY_POSITION_COUNT) - VERIFY_SOURCE_HEIGHT - 1;
+        raster_target_ts target;
+        raster_target_init(&target, &target_framebuffer);
+        if (position >= VERIFY_POSITION_COUNT * VERIFY_POSITION_COUNT)
+          raster_target_set_clip(&target, &inner_clip_rect);
+
+        for (int pixel = 0; pixel < VERIFY_TARGET_PITCH * VERIFY_TARGET_HEIGHT; pixel++)
+        {
+          target_pixels[pixel] = destination_row[pixel % VERIFY_ROW_LENGTH_MAX];
+          reference_target_pixels[pixel] = target_pixels[pixel];
+        }
+        for (int source_y = 0; source_y < VERIFY_SOURCE_HEIGHT; source_y++)
+        {
+          for (int source_x = 0; source_x < VERIFY_SOURCE_WIDTH; source_x++)
+          {
+            const int target_x = x + source_x;
+            const int target_y = y + source_y;
+            if (target_x < target.clip_rect.x || target_x >= target.clip_rect.x + target.clip_rect.w ||
+                target_y < target.clip_rect.y || target_y >= target.clip_rect.y + target.clip_rect.h)
+              continue;
+
+            client_pixel_rgba_ts * const p_reference = &reference_target_pixels[(target_y * VERIFY_TARGET_PITCH) + target_x];
+            *p_reference = blend_reference_pixel((blend_mode_te)mode, client_framebuffer_row(&source_framebuffer, source_y) + source_x, p_reference);
+          }
+        }
+
+        blend_framebuffer(&blender, &target, x, y, &source_framebuffer);
+        if (SDL_memcmp(target_pixels, reference_target_pixels, sizeof(target_pixels)) != 0)
+        {
+          fprintf(stdout, "FAIL  blend %-20s %-8s position %d,%d%s\n", blender.p_name, pixel_kernel_name(blender.kernel), x, y, (position >= VERIFY_POSITION_COUNT * VERIFY_POSITION_COUNT) ? " clipped" : "");
+          kernel_passed = 0;
+          failures++;
+        }
+      }
+
+      if (kernel_passed)
+        fprintf(stdout, "PASS  blend %-20s %s\n", blender.p_name, pixel_kernel_name(blender.kernel));
+    }
+  }
+
+  /* Premultiply every color channel value with every alpha value */
+  int premultiply_passed = 1;
+  for (uint32_t alpha = 0; alpha <= 255u && premultiply_passed; alpha++)
+  {
+    client_pixel_rgba_ts premultiplied_row[256 + 1];
+    for (uint32_t channel = 0; channel <= 255u; channel++)
+    {
+      premultiplied_row[channel].red = (uint8_t)channel;
+      premultiplied_row[channel].green = (uint8_t)(255u - channel);
+      premultiplied_row[channel].blue = (uint8_t)(channel ^ 0x5Au);
+      premultiplied_row[channel].alpha = (uint8_t)alpha;
+    }
+    SDL_memset(&premultiplied_row[256], 0xA5, sizeof(client_pixel_rgba_ts));
+
+    blend_premultiply_row(premultiplied_row, 256);
+    for (uint32_t channel = 0; channel <= 255u; channel++)
+    {
+      const client_pixel_rgba_ts * const p_pixel = &premultiplied_row[channel];
+      if (p_pixel->red != (uint8_t)(((2u * channel * alpha) + 255u) / 510u) ||
+          p_pixel->green != (uint8_t)(((2u * (255u - channel) * alpha) + 255u) / 510u) ||
+          p_pixel->blue != (uint8_t)(((2u * (channel ^ 0x5Au) * alpha) + 255u) / 510u) ||
+          p_pixel->alpha != alpha)
+        premultiply_passed = 0;
+    }
+    if (premultiplied_row[256].red != 0xA5 || premultiplied_row[256].alpha != 0xA5)
+      premultiply_passed = 0;
+
+    if (!premultiply_passed)
+    {
+      fprintf(stdout, "FAIL  blend premultiply alpha %u\n", (unsigned int)alpha);
+      failures++;
+    }
+  }
+  if (premultiply_passed)
+    fprintf(stdout, "PASS  blend premultiply\n");
+
+  return failures;
+}
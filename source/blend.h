@@ -0,0 +1,40 @@
+#ifndef BLEND_H
+#define BLEND_H
+
+#include <SDL.h>
+#include "client_pixels.h"
+#include "pixel_convert.h"
+#include "raster.h"
+
+/* Datatypes */
+typedef enum {
+  BLEND_MODE_SOURCE_OVER = 0,
+  BLEND_MODE_ADDITIVE,
+  BLEND_MODE_MULTIPLY,
+  BLEND_MODE_COUNT
+} blend_mode_te;
+
+/*
+    Blends a row of premultiplied source pixels into a row of premultiplied destination pixels.
+    Premultiplied pixels never have a color channel above their alpha, the result of blending
+    other pixels depends on the kernel
+*/
+typedef void (* blend_row_tf)(client_pixel_rgba_ts * p_destination_row, const client_pixel_rgba_ts * p_source_row, int pixel_count);
+
+typedef struct {
+  const char * p_name;
+  blend_mode_te mode;
+  pixel_kernel_te kernel;
+  blend_row_tf blend_row;
+} blender_ts;
+
+/* Function prototypes */
+void blender_init(blender_ts * p_blender, blend_mode_te mode);
+int blender_init_kernel(blender_ts * p_blender, blend_mode_te mode, pixel_kernel_te kernel);
+void blend_framebuffer(const blender_ts * p_blender, const raster_target_ts * p_target, int x, int y, const client_framebuffer_ts * p_source);
+void blend_premultiply_row(client_pixel_rgba_ts * p_row, int pixel_count);
+const char * blend_mode_name(blend_mode_te mode);
+int blend_mode_from_name(const char * p_mode_name, blend_mode_te * p_mode);
+int blend_verify_kernels(void);
+
+#endif
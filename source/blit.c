@@ -0,0 +1,53 @@
+#include <SDL.h>
+#include "blit.h"
+
+/*
+    Row transfer primitives shared by every path that moves pixels between buffers.
+
+    Both buffers are addressed by the pointer to their first row and their pitch in bytes, and only the
+    row pointers advance from one row to the next, so no texel index is recomputed inside a row
+*/
+
+/* Function definitions */
+void blit_rows(
+  void * p_destination,
+  ptrdiff_t destination_pitch,
+  const void * p_source,
+  ptrdiff_t source_pitch,
+  int row_count,
+  int texel_count,
+  blit_row_tf blit_row,
+  const void * p_context
+)
+{
+  uint8_t * p_destination_row = (uint8_t *)p_destination;
+  const uint8_t * p_source_row = (const uint8_t *)p_source;
+  for (int row = 0; row < row_count; row++)
+  {
+    blit_row(p_context, p_destination_row, p_source_row, texel_count);
+    p_destination_row += destination_pitch;
+    p_source_row += source_pitch;
+  }
+}
+
+/* Copies row_size bytes of every row, for buffers with the same pixel layout */
+void blit_rows_copy(void * p_destination, ptrdiff_t destination_pitch, const void * p_source, ptrdiff_t source_pitch, int row_count, size_t row_size)
+{
+  uint8_t * p_destination_row = (uint8_t *)p_destination;
+  const uint8_t * p_source_row = (const uint8_t *)p_source;
+  for (int row = 0; row < row_count; row++)
+  {
+    SDL_memcpy(p_destination_row, p_source_row, row_size);
+    p_destination_row += destination_pitch;
+    p_source_row += source_pitch;
+  }
+}
+
+/* Copies the rows with a single copy when they are contiguous in both buffers, and one copy per row otherwise */
+void blit_rows_copy_bulk(void * p_destination, ptrdiff_t destination_pitch, const void * p_source, ptrdiff_t source_pitch, int row_count, size_t row_size)
+{
+  if (row_count > 0 && destination_pitch == (ptrdiff_t)row_size && source_pitch == (ptrdiff_t)row_size)
+    SDL_memcpy(p_destination, p_source, row_size * (size_t)row_count);
+  else
+    blit_rows_copy(p_destination, destination_pitch, p_source, source_pitch, row_count, row_size);
+}
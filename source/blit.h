@@ -0,0 +1,26 @@
+#ifndef BLIT_H
+#define BLIT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Datatypes */
+
+/* Transfers texel_count texels from a source row into a destination row, converting them as the context requires */
+typedef void (* blit_row_tf)(const void * p_context, void * p_destination_row, const void * p_source_row, int texel_count);
+
+/* Function prototypes */
+void blit_rows(
+  void * p_destination,
+  ptrdiff_t destination_pitch,
+  const void * p_source,
+  ptrdiff_t source_pitch,
+  int row_count,
+  int texel_count,
+  blit_row_tf blit_row,
+  const void * p_context
+);
+void blit_rows_copy(void * p_destination, ptrdiff_t destination_pitch, const void * p_source, ptrdiff_t source_pitch, int row_count, size_t row_size);
+void blit_rows_copy_bulk(void * p_destination, ptrdiff_t destination_pitch, const void * p_source, ptrdiff_t source_pitch, int row_count, size_t row_size);
+
+#endif
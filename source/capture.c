@@ -0,0 +1,475 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL.h>
+#include "capture.h"
+#include "blit.h"
+
+/* Defines */
+#define CAPTURE_PNG_STORED_BLOCK_SIZE (65535)
+#define CAPTURE_ADLER_MODULUS (65521u)
+#define CAPTURE_ADLER_CHUNK_SIZE (5552)
+
+/* Constants */
+static const uint8_t CAPTURE_PNG_SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+/* Datatypes */
+
+/*
+    PNG file being written front to back. Every byte of a chunk passes through the chunk CRC, and the
+    pixel rows additionally through the Adler-32 checksum of the zlib stream, which splits them into
+    stored deflate blocks. Storing instead of compressing keeps encoding as cheap as writing a PPM
+*/
+typedef struct {
+  FILE * p_stream;
+  uint32_t chunk_crc;
+  uint32_t adler_low;
+  uint32_t adler_high;
+  size_t deflate_remaining;
+  size_t block_remaining;
+  int failed;
+} capture_png_ts;
+
+/* CRC-32 of PNG chunks, the table is filled once before the first I/O thread starts */
+static uint32_t capture_crc_table[256];
+
+static void capture_init_crc_table(void)
+{
+  for (uint32_t table_index = 0; table_index < 256; table_index++)
+  {
+    uint32_t crc = table_index;
+    for (int bit = 0; bit < 8; bit++)
+    {
+      crc = (crc & 0x1u) ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+    }
+    capture_crc_table[table_index] = crc;
+  }
+}
+
+static void capture_png_write(capture_png_ts * p_png, const void * p_data, size_t size)
+{
+  const uint8_t * const p_bytes = (const uint8_t *)p_data;
+  uint32_t crc = p_png->chunk_crc;
+  for (size_t byte_index = 0; byte_index < size; byte_index++)
+  {
+    crc = capture_crc_table[(crc ^ p_bytes[byte_index]) & 0xFFu] ^ (crc >> 8);
+  }
+  p_png->chunk_crc = crc;
+
+  if (fwrite(p_data, 1, size, p_png->p_stream) != size)
+    p_png->failed = 1;
+}
+
+static void capture_png_write_u32(capture_png_ts * p_png, uint32_t value)
+{
+  const uint8_t bytes[4] = { (uint8_t)(value >> 24), (uint8_t)(value >> 16), (uint8_t)(value >> 8), (uint8_t)value };
+  capture_png_write(p_png, bytes, sizeof(bytes));
+}
+
+/* The length precedes the chunk CRC, which starts over at the chunk type */
+static void capture_png_begin_chunk(capture_png_ts * p_png, const char * p_type, uint32_t length)
+{
+  capture_png_write_u32(p_png, length);
+  p_png->chunk_crc = 0xFFFFFFFFu;
+  capture_png_write(p_png, p_type, 4);
+}
+
+static void capture_png_end_chunk(capture_png_ts * p_png)
+{
+  capture_png_write_u32(p_png, p_png->chunk_crc ^ 0xFFFFFFFFu);
+}
+
+/* Appends bytes to the zlib stream, starting a new stored block whenever the current one is full */
+static void capture_png_deflate(capture_png_ts * p_png, const uint8_t * p_bytes, size_t size)
+{
+  while (size > 0)
+  {
+    if (p_png->block_remaining == 0)
+    {
+      const size_t block_size = SDL_min((size_t)CAPTURE_PNG_STORED_BLOCK_SIZE, p_png->deflate_remaining);
+      const uint8_t block_header[5] = {
+        (uint8_t)((block_size == p_png->deflate_remaining) ? 0x01 : 0x00),
+        (uint8_t)block_size,
+        (uint8_t)(block_size >> 8),
+        (uint8_t)~block_size,
+        (uint8_t)(~block_size >> 8)
+      };
+      capture_png_write(p_png, block_header, sizeof(block_header));
+      p_png->block_remaining = block_size;
+    }
+
+    const size_t write_size = SDL_min(size, p_png->block_remaining);
+    capture_png_write(p_png, p_bytes, write_size);
+
+    /* Deferring the modulo to every few thousand bytes cannot overflow the sums */
+    for (size_t chunk_begin = 0; chunk_begin < write_size; chunk_begin += CAPTURE_ADLER_CHUNK_SIZE)
+    {
+      const size_t chunk_end = SDL_min(write_size, chunk_begin + CAPTURE_ADLER_CHUNK_SIZE);
+      for (size_t byte_index = chunk_begin; byte_index < chunk_end; byte_index++)
+      {
+        p_png->adler_low += p_bytes[byte_index];
+        p_png->adler_high += p_png->adler_low;
+      }
+      p_png->adler_low %= CAPTURE_ADLER_MODULUS;
+      p_png->adler_high %= CAPTURE_ADLER_MODULUS;
+    }
+
+    p_bytes += write_size;
+    size -= write_size;
+    p_png->block_remaining -= write_size;
+    p_png->deflate_remaining -= write_size;
+  }
+}
+
+static int capture_write_png(FILE * p_stream, const client_framebuffer_ts * p_framebuffer)
+{
+  capture_png_ts png = { p_stream, 0, 1, 0, 0, 0, 0 };
+  const size_t row_size = 1 + (sizeof(client_pixel_rgba_ts) * (size_t)p_framebuffer->width);
+  png.deflate_remaining = row_size * (size_t)p_framebuffer->height;
+
+  /* Zlib header, stored blocks with their headers, then the Adler-32 checksum */
+  const size_t block_count = SDL_max((size_t)1, (png.deflate_remaining + CAPTURE_PNG_STORED_BLOCK_SIZE - 1) / CAPTURE_PNG_STORED_BLOCK_SIZE);
+  const size_t idat_length = 2 + (block_count * 5) + png.deflate_remaining + 4;
+  if (idat_length > 0x7FFFFFFFu)
+    return -1;
+
+  capture_png_write(&png, CAPTURE_PNG_SIGNATURE, sizeof(CAPTURE_PNG_SIGNATURE));
+
+  /* 8-bit RGBA, without interlacing */
+  const uint8_t header_tail[5] = { 8, 6, 0, 0, 0 };
+  capture_png_begin_chunk(&png, "IHDR", 13);
+  capture_png_write_u32(&png, (uint32_t)p_framebuffer->width);
+  capture_png_write_u32(&png, (uint32_t)p_framebuffer->height);
+  capture_png_write(&png, header_tail, sizeof(header_tail));
+  capture_png_end_chunk(&png);
+
+  const uint8_t zlib_header[2] = { 0x78, 0x01 };
+  capture_png_begin_chunk(&png, "IDAT", (uint32_t)idat_length);
+  capture_png_write(&png, zlib_header, sizeof(zlib_header));
+  if (png.deflate_remaining == 0)
+  {
+    const uint8_t empty_block[5] = { 0x01, 0x00, 0x00, 0xFF, 0xFF };
+    capture_png_write(&png, empty_block, sizeof(empty_block));
+  }
+
+  /* Every row starts with filter type 0, the pixels follow unfiltered */
+  const uint8_t row_filter = 0;
+  for (int row = 0; row < p_framebuffer->height; row++)
+  {
+    capture_png_deflate(&png, &row_filter, 1);
+    capture_png_deflate(&png, (const uint8_t *)client_framebuffer_row(p_framebuffer, row), row_size - 1);
+  }
+  capture_png_write_u32(&png, (png.adler_high << 16) | png.adler_low);
+  capture_png_end_chunk(&png);
+
+  capture_png_begin_chunk(&png, "IEND", 0);
+  capture_png_end_chunk(&png);
+  return png.failed ? -1 : 0;
+}
+
+static int capture_write_ppm(FILE * p_stream, const client_framebuffer_ts * p_framebuffer, uint8_t * p_row_buffer)
+{
+  if (fprintf(p_stream, "P6\n%d %d\n255\n", p_framebuffer->width, p_framebuffer->height) < 0)
+    return -1;
+
+  /* PPM has no alpha channel, so every row is packed into RGB triplets first */
+  for (int row = 0; row < p_framebuffer->height; row++)
+  {
+    const client_pixel_rgba_ts * const p_row = client_framebuffer_row(p_framebuffer, row);
+    for (int pixel_x = 0; pixel_x < p_framebuffer->width; pixel_x++)
+    {
+      p_row_buffer[(pixel_x * 3) + 0] = p_row[pixel_x].red;
+      p_row_buffer[(pixel_x * 3) + 1] = p_row[pixel_x].green;
+      p_row_buffer[(pixel_x * 3) + 2] = p_row[pixel_x].blue;
+    }
+
+    const size_t row_size = (size_t)p_framebuffer->width * 3;
+    if (fwrite(p_row_buffer, 1, row_size, p_stream) != row_size)
+      return -1;
+  }
+  return 0;
+}
+
+/* Writes the path of one frame, which is the capture path with the frame index inserted before the extension */
+static void capture_format_frame_path(const capture_ts * p_capture, uint64_t frame_index)
+{
+  const char * p_file_name = p_capture->p_path;
+  for (const char * p_character = p_capture->p_path; *p_character != '\0'; p_character++)
+  {
+    if (*p_character == '/' || *p_character == '\\')
+      p_file_name = p_character + 1;
+  }
+
+  const char * p_extension = strrchr(p_file_name, '.');
+  if (p_extension == NULL)
+    p_extension = p_file_name + strlen(p_file_name);
+
+  sprintf(
+    p_capture->p_frame_path,
+    "%.*s_%06llu%s",
+    (int)(p_extension - p_capture->p_path),
+    p_capture->p_path,
+    (unsigned long long)frame_index,
+    p_extension
+  );
+}
+
+static int capture_write_frame(capture_ts * p_capture, const capture_frame_ts * p_frame)
+{
+  const client_framebuffer_ts * const p_framebuffer = &p_frame->framebuffer;
+  if (p_capture->format == CAPTURE_FORMAT_RAW)
+  {
+    const size_t frame_size = sizeof(client_pixel_rgba_ts) * (size_t)p_framebuffer->width * (size_t)p_framebuffer->height;
+    return (fwrite(p_framebuffer->p_pixels, 1, frame_size, p_capture->p_raw_stream) == frame_size) ? 0 : -1;
+  }
+
+  capture_format_frame_path(p_capture, p_frame->frame_index);
+  FILE * const p_stream = fopen(p_capture->p_frame_path, "wb");
+  if (p_stream == NULL)
+    return -1;
+
+  const int write_result = (p_capture->format == CAPTURE_FORMAT_PNG)
+    ? capture_write_png(p_stream, p_framebuffer)
+    : capture_write_ppm(p_stream, p_framebuffer, p_capture->p_row_buffer);
+  const int close_result = fclose(p_stream);
+  return (write_result == 0 && close_result == 0) ? 0 : -1;
+}
+
+/*
+    Writes the queued frames in order. Every frame is preceded by its own post of the queued frame semaphore,
+    so a post without a queued frame can only be the final one from capture_destroy, after every frame was written
+*/
+static int capture_io_thread(void * p_thread_data)
+{
+  capture_ts * const p_capture = (capture_ts *)p_thread_data;
+  for (;;)
+  {
+    SDL_SemWait(p_capture->p_queued_frames);
+    if (SDL_AtomicGet(&p_capture->frames_queued) == 0)
+      break;
+
+    const capture_frame_ts * const p_frame = &p_capture->p_frames[p_capture->read_index];
+    if (capture_write_frame(p_capture, p_frame) == 0)
+    {
+      SDL_AtomicIncRef(&p_capture->frames_written);
+    }
+    else
+    {
+      fprintf(stderr, "\nCould not write captured frame %llu to '%s'", (unsigned long long)p_frame->frame_index, p_capture->p_path);
+      SDL_AtomicIncRef(&p_capture->frames_failed);
+    }
+
+    p_capture->read_index = (p_capture->read_index + 1) % p_capture->queue_length;
+    SDL_AtomicAdd(&p_capture->frames_queued, -1);
+    SDL_SemPost(p_capture->p_free_frames);
+  }
+
+  return 0;
+}
+
+/* Function definitions */
+
+/*
+    Starts the I/O thread of a capture with queue_length frames of the given dimensions. The path must
+    outlive the capture. Returns NULL on failure
+*/
+capture_ts * capture_create(const char * p_path, capture_format_te format, int width, int height, int queue_length)
+{
+  capture_ts * const p_capture = calloc(1, sizeof(capture_ts));
+  if (p_capture == NULL)
+  {
+    fprintf(stderr, "\nCould not allocate capture - Error: Calloc failed");
+    return NULL;
+  }
+
+  p_capture->format = format;
+  p_capture->p_path = p_path;
+  p_capture->queue_length = SDL_max(CAPTURE_MIN_QUEUE_LENGTH, SDL_min(queue_length, CAPTURE_MAX_QUEUE_LENGTH));
+  p_capture->p_frames = calloc((size_t)p_capture->queue_length, sizeof(capture_frame_ts));
+  p_capture->p_row_buffer = malloc((size_t)SDL_max(1, width) * 3);
+  p_capture->p_frame_path = malloc(strlen(p_path) + 32);
+  if (p_capture->p_frames == NULL || p_capture->p_row_buffer == NULL || p_capture->p_frame_path == NULL)
+  {
+    fprintf(stderr, "\nCould not allocate capture queue - Error: Malloc failed");
+    capture_destroy(p_capture);
+    return NULL;
+  }
+
+  for (int frame_index = 0; frame_index < p_capture->queue_length; frame_index++)
+  {
+    client_framebuffer_ts * const p_framebuffer = &p_capture->p_frames[frame_index].framebuffer;
+    p_framebuffer->p_pixels = malloc(sizeof(client_pixel_rgba_ts) * (size_t)width * (size_t)height);
+    p_framebuffer->width = width;
+    p_framebuffer->height = height;
+    p_framebuffer->pitch = (int)sizeof(client_pixel_rgba_ts) * width;
+    if (p_framebuffer->p_pixels == NULL)
+    {
+      fprintf(stderr, "\nCould not allocate capture frame - Error: Malloc failed");
+      capture_destroy(p_capture);
+      return NULL;
+    }
+  }
+
+  /* Raw frames all go into a single stream, which fails early if it cannot be created */
+  if (format == CAPTURE_FORMAT_RAW)
+  {
+    p_capture->p_raw_stream = fopen(p_path, "wb");
+    if (p_capture->p_raw_stream == NULL)
+    {
+      fprintf(stderr, "\nCould not create capture file '%s'", p_path);
+      capture_destroy(p_capture);
+      return NULL;
+    }
+  }
+
+  p_capture->p_free_frames = SDL_CreateSemaphore((Uint32)p_capture->queue_length);
+  p_capture->p_queued_frames = SDL_CreateSemaphore(0);
+  if (p_capture->p_free_frames == NULL || p_capture->p_queued_frames == NULL)
+  {
+    fprintf(stderr, "\nCapture semaphores could not be created - Error: %s", SDL_GetError());
+    capture_destroy(p_capture);
+    return NULL;
+  }
+
+  capture_init_crc_table();
+  p_capture->p_io_thread = SDL_CreateThread(capture_io_thread, "capture", p_capture);
+  if (p_capture->p_io_thread == NULL)
+  {
+    fprintf(stderr, "\nCapture thread could not be created - Error: %s", SDL_GetError());
+    capture_destroy(p_capture);
+    return NULL;
+  }
+
+  return p_capture;
+}
+
+/* Writes every frame still queued before stopping the I/O thread */
+void capture_destroy(capture_ts * p_capture)
+{
+  if (p_capture == NULL)
+    return;
+
+  if (p_capture->p_io_thread != NULL)
+  {
+    SDL_SemPost(p_capture->p_queued_frames);
+    SDL_WaitThread(p_capture->p_io_thread, NULL);
+  }
+
+  if (p_capture->p_queued_frames != NULL)
+    SDL_DestroySemaphore(p_capture->p_queued_frames);
+  if (p_capture->p_free_frames != NULL)
+    SDL_DestroySemaphore(p_capture->p_free_frames);
+
+  if (p_capture->p_raw_stream != NULL && fclose(p_capture->p_raw_stream) != 0)
+    fprintf(stderr, "\nCould not finish capture file '%s'", p_capture->p_path);
+
+  if (p_capture->p_frames != NULL)
+  {
+    for (int frame_index = 0; frame_index < p_capture->queue_length; frame_index++)
+    {
+      free(p_capture->p_frames[frame_index].framebuffer.p_pixels);
+    }
+  }
+  free(p_capture->p_frames);
+  free(p_capture->p_row_buffer);
+  free(p_capture->p_frame_path);
+  free(p_capture);
+}
+
+/*
+    Returns the framebuffer of the next free queue slot to capture a frame into, followed by either
+    capture_commit_frame or capture_cancel_frame. Returns NULL and counts the frame as dropped if the queue is full
+*/
+client_framebuffer_ts * capture_begin_frame(capture_ts * p_capture, uint64_t frame_index)
+{
+  if (SDL_SemTryWait(p_capture->p_free_frames) != 0)
+  {
+    p_capture->frames_dropped++;
+    return NULL;
+  }
+
+  capture_frame_ts * const p_frame = &p_capture->p_frames[p_capture->write_index];
+  p_frame->frame_index = frame_index;
+  return &p_frame->framebuffer;
+}
+
+/* Hands the frame over to the I/O thread */
+void capture_commit_frame(capture_ts * p_capture)
+{
+  p_capture->write_index = (p_capture->write_index + 1) % p_capture->queue_length;
+  p_capture->frames_captured++;
+  SDL_AtomicIncRef(&p_capture->frames_queued);
+  SDL_SemPost(p_capture->p_queued_frames);
+}
+
+/* Returns the slot of a frame that could not be captured after all */
+void capture_cancel_frame(capture_ts * p_capture)
+{
+  SDL_SemPost(p_capture->p_free_frames);
+}
+
+/* Queues a copy of the framebuffer, which must have the capture dimensions. Returns 0 if queued and -1 if dropped */
+int capture_frame(capture_ts * p_capture, const client_framebuffer_ts * p_framebuffer, uint64_t frame_index)
+{
+  client_framebuffer_ts * const p_capture_framebuffer = capture_begin_frame(p_capture, frame_index);
+  if (p_capture_framebuffer == NULL)
+    return -1;
+
+  blit_rows_copy_bulk(
+    p_capture_framebuffer->p_pixels,
+    p_capture_framebuffer->pitch,
+    p_framebuffer->p_pixels,
+    p_framebuffer->pitch,
+    p_capture_framebuffer->height,
+    sizeof(client_pixel_rgba_ts) * (size_t)p_capture_framebuffer->width
+  );
+  capture_commit_frame(p_capture);
+  return 0;
+}
+
+/* Frames handed over to the I/O thread so far, written or not */
+uint64_t capture_frames_captured(const capture_ts * p_capture)
+{
+  return p_capture->frames_captured;
+}
+
+uint64_t capture_frames_written(capture_ts * p_capture)
+{
+  return (uint64_t)SDL_AtomicGet(&p_capture->frames_written);
+}
+
+uint64_t capture_frames_dropped(const capture_ts * p_capture)
+{
+  return p_capture->frames_dropped;
+}
+
+uint64_t capture_frames_failed(capture_ts * p_capture)
+{
+  return (uint64_t)SDL_AtomicGet(&p_capture->frames_failed);
+}
+
+/* Chooses the format by file extension, paths without a known image extension capture a raw RGBA stream */
+capture_format_te capture_format_from_path(const char * p_path)
+{
+  const char * const p_extension = strrchr(p_path, '.');
+  if (p_extension != NULL && SDL_strcasecmp(p_extension, ".png") == 0)
+    return CAPTURE_FORMAT_PNG;
+  if (p_extension != NULL && SDL_strcasecmp(p_extension, ".ppm") == 0)
+    return CAPTURE_FORMAT_PPM;
+  return CAPTURE_FORMAT_RAW;
+}
+
+const char * capture_format_name(capture_format_te format)
+{
+  switch (format)
+  {
+    case CAPTURE_FORMAT_RAW:
+      return "raw";
+    case CAPTURE_FORMAT_PPM:
+      return "ppm";
+    case CAPTURE_FORMAT_PNG:
+      return "png";
+    default:
+      return "unknown";
+  }
+}
@@ -0,0 +1,69 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <SDL.h>
+#include "client_pixels.h"
+
+/* Defines */
+#define CAPTURE_MIN_QUEUE_LENGTH (1)
+#define CAPTURE_MAX_QUEUE_LENGTH (64)
+
+/* Datatypes */
+typedef enum {
+  CAPTURE_FORMAT_RAW = 0,
+  CAPTURE_FORMAT_PPM,
+  CAPTURE_FORMAT_PNG
+} capture_format_te;
+
+/* One queued frame, tightly packed RGBA pixels in client pixel order */
+typedef struct {
+  client_framebuffer_ts framebuffer;
+  uint64_t frame_index;
+} capture_frame_ts;
+
+/*
+    Bounded single-producer, single-consumer queue of frames, written to disk by an I/O thread.
+
+    The render loop copies a frame into the next free queue slot and never waits for the I/O thread.
+    Without a free slot, the frame is dropped and counted instead. Raw captures append every frame to
+    one stream, while PPM and PNG captures write one file per frame, numbered by frame index
+*/
+typedef struct {
+  capture_format_te format;
+  const char * p_path;
+  capture_frame_ts * p_frames;
+  int queue_length;
+  int write_index;
+  int read_index;
+  SDL_sem * p_free_frames;
+  SDL_sem * p_queued_frames;
+  SDL_atomic_t frames_queued;
+  uint64_t frames_captured;
+  uint64_t frames_dropped;
+  SDL_atomic_t frames_written;
+  SDL_atomic_t frames_failed;
+
+  /* I/O thread state, owned by the I/O thread once it runs */
+  SDL_Thread * p_io_thread;
+  FILE * p_raw_stream;
+  uint8_t * p_row_buffer;
+  char * p_frame_path;
+} capture_ts;
+
+/* Function prototypes */
+capture_ts * capture_create(const char * p_path, capture_format_te format, int width, int height, int queue_length);
+void capture_destroy(capture_ts * p_capture);
+client_framebuffer_ts * capture_begin_frame(capture_ts * p_capture, uint64_t frame_index);
+void capture_commit_frame(capture_ts * p_capture);
+void capture_cancel_frame(capture_ts * p_capture);
+int capture_frame(capture_ts * p_capture, const client_framebuffer_ts * p_framebuffer, uint64_t frame_index);
+uint64_t capture_frames_captured(const capture_ts * p_capture);
+uint64_t capture_frames_written(capture_ts * p_capture);
+uint64_t capture_frames_dropped(const capture_ts * p_capture);
+uint64_t capture_frames_failed(capture_ts * p_capture);
+capture_format_te capture_format_from_path(const char * p_path);
+const char * capture_format_name(capture_format_te format);
+
+#endif
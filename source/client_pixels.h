@@ -0,0 +1,45 @@
+#ifndef CLIENT_PIXELS_H
+#define CLIENT_PIXELS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Datatypes */
+typedef struct {
+  uint8_t red;
+  uint8_t green;
+  uint8_t blue;
+  uint8_t alpha;
+} client_pixel_rgba_ts;
+
+/*
+    Client-side pixels to render into, which are either a client-side pixel buffer or the
+    locked pixels of a texture whose memory layout matches client_pixel_rgba_ts
+*/
+typedef struct {
+  client_pixel_rgba_ts * p_pixels;
+  int width;
+  int height;
+  int pitch;
+} client_framebuffer_ts;
+
+/* Client-side palette indices to render into, which the palette expands into texels */
+typedef struct {
+  uint8_t * p_indices;
+  int width;
+  int height;
+  int pitch;
+} client_framebuffer_indexed_ts;
+
+/* Function definitions */
+static inline client_pixel_rgba_ts * client_framebuffer_row(const client_framebuffer_ts * p_framebuffer, int row)
+{
+  return (client_pixel_rgba_ts *)((uint8_t *)p_framebuffer->p_pixels + ((size_t)p_framebuffer->pitch * row));
+}
+
+static inline uint8_t * client_framebuffer_indexed_row(const client_framebuffer_indexed_ts * p_framebuffer, int row)
+{
+  return p_framebuffer->p_indices + ((size_t)p_framebuffer->pitch * row);
+}
+
+#endif
@@ -0,0 +1,119 @@
+#include <SDL.h>
+#include "damage.h"
+
+static long long rect_area(const SDL_Rect * p_rect)
+{
+  return (long long)p_rect->w * p_rect->h;
+}
+
+static SDL_Rect rect_union(const SDL_Rect * p_first, const SDL_Rect * p_second)
+{
+  const int left = SDL_min(p_first->x, p_second->x);
+  const int top = SDL_min(p_first->y, p_second->y);
+  const int right = SDL_max(p_first->x + p_first->w, p_second->x + p_second->w);
+  const int bottom = SDL_max(p_first->y + p_first->h, p_second->y + p_second->h);
+  const SDL_Rect union_rect = { left, top, right - left, bottom - top };
+  return union_rect;
+}
+
+/*
+    Rectangles are merged when their bounding box wastes little area compared to keeping them apart,
+    which also merges all overlapping and touching rectangles of similar extent
+*/
+static int rects_worth_merging(const SDL_Rect * p_first, const SDL_Rect * p_second)
+{
+  const SDL_Rect union_rect = rect_union(p_first, p_second);
+  return rect_area(&union_rect) <= ((rect_area(p_first) + rect_area(p_second)) * 5) / 4;
+}
+
+static void damage_remove(damage_tracker_ts * p_damage, int rect_index)
+{
+  p_damage->rect_count--;
+  p_damage->rects[rect_index] = p_damage->rects[p_damage->rect_count];
+}
+
+/* Function definitions */
+void damage_init(damage_tracker_ts * p_damage, int width, int height)
+{
+  p_damage->width = width;
+  p_damage->height = height;
+  damage_clear(p_damage);
+}
+
+void damage_clear(damage_tracker_ts * p_damage)
+{
+  p_damage->rect_count = 0;
+}
+
+void damage_add(damage_tracker_ts * p_damage, const SDL_Rect * p_rect)
+{
+  /* Clip against the tracked area and drop rectangles without any pixels */
+  const SDL_Rect bounds = { 0, 0, p_damage->width, p_damage->height };
+  SDL_Rect damaged_rect;
+  if (!SDL_IntersectRect(p_rect, &bounds, &damaged_rect))
+    return;
+
+  /* Absorb every rectangle worth merging, which may make further rectangles worth merging */
+  int rect_index = 0;
+  while (rect_index < p_damage->rect_count)
+  {
+    if (rects_worth_merging(&p_damage->rects[rect_index], &damaged_rect))
+    {
+      damaged_rect = rect_union(&p_damage->rects[rect_index], &damaged_rect);
+      damage_remove(p_damage, rect_index);
+      rect_index = 0;
+    }
+    else
+    {
+      rect_index++;
+    }
+  }
+
+  /* Without a free slot, grow the rectangle whose area grows the least */
+  if (p_damage->rect_count == DAMAGE_MAX_RECTS)
+  {
+    int cheapest_index = 0;
+    long long cheapest_growth = -1;
+    for (int candidate_index = 0; candidate_index < p_damage->rect_count; candidate_index++)
+    {
+      const SDL_Rect union_rect = rect_union(&p_damage->rects[candidate_index], &damaged_rect);
+      const long long growth = rect_area(&union_rect) - rect_area(&p_damage->rects[candidate_index]);
+      if (cheapest_growth < 0 || growth < cheapest_growth)
+      {
+        cheapest_index = candidate_index;
+        cheapest_growth = growth;
+      }
+    }
+
+    damaged_rect = rect_union(&p_damage->rects[cheapest_index], &damaged_rect);
+    damage_remove(p_damage, cheapest_index);
+    damage_add(p_damage, &damaged_rect);
+    return;
+  }
+
+  p_damage->rects[p_damage->rect_count] = damaged_rect;
+  p_damage->rect_count++;
+
+  /* Once most of the area is damaged, a single lock and upload of the bounding box is cheaper than many */
+  if (p_damage->rect_count > 1 && damage_area(p_damage) * 4 >= (long long)p_damage->width * p_damage->height * 3)
+    damage_add_all(p_damage);
+}
+
+void damage_add_all(damage_tracker_ts * p_damage)
+{
+  p_damage->rects[0].x = 0;
+  p_damage->rects[0].y = 0;
+  p_damage->rects[0].w = p_damage->width;
+  p_damage->rects[0].h = p_damage->height;
+  p_damage->rect_count = (p_damage->width > 0 && p_damage->height > 0) ? 1 : 0;
+}
+
+long long damage_area(const damage_tracker_ts * p_damage)
+{
+  long long area = 0;
+  for (int rect_index = 0; rect_index < p_damage->rect_count; rect_index++)
+  {
+    area += rect_area(&p_damage->rects[rect_index]);
+  }
+  return area;
+}
@@ -0,0 +1,24 @@
+#ifndef DAMAGE_H
+#define DAMAGE_H
+
+#include <SDL.h>
+
+/* Defines */
+#define DAMAGE_MAX_RECTS (16)
+
+/* Datatypes */
+typedef struct {
+  SDL_Rect rects[DAMAGE_MAX_RECTS];
+  int rect_count;
+  int width;
+  int height;
+} damage_tracker_ts;
+
+/* Function prototypes */
+void damage_init(damage_tracker_ts * p_damage, int width, int height);
+void damage_clear(damage_tracker_ts * p_damage);
+void damage_add(damage_tracker_ts * p_damage, const SDL_Rect * p_rect);
+void damage_add_all(damage_tracker_ts * p_damage);
+long long damage_area(const damage_tracker_ts * p_damage);
+
+#endif
@@ -0,0 +1,341 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <SDL.h>
+#include "frame_pipeline.h"
+#include "render_stages.h"
+
+/*
+    Sleeps until the counterpart wakes the waiter, unless the awaited condition holds after announcing the sleep.
+    Announcing before checking and checking before waking are both full barriers, so either the sleeping thread
+    sees the condition or the waking thread sees the announcement, and no wakeup is ever lost
+*/
+static void frame_pipeline_sleep(frame_pipeline_waiter_ts * p_waiter, frame_pipeline_ts * p_pipeline, int (* condition)(frame_pipeline_ts *))
+{
+  SDL_AtomicCAS(&p_waiter->sleeping, 0, 1);
+  if (condition(p_pipeline) && SDL_AtomicCAS(&p_waiter->sleeping, 1, 0))
+    return;
+
+  /* Either the condition does not hold yet or the counterpart already claimed the announcement and wakes us */
+  SDL_SemWait(p_waiter->p_wakeup);
+}
+
+static void frame_pipeline_wake(frame_pipeline_waiter_ts * p_waiter)
+{
+  if (SDL_AtomicCAS(&p_waiter->sleeping, 1, 0))
+    SDL_SemPost(p_waiter->p_wakeup);
+}
+
+static int frame_pipeline_slot_free(frame_pipeline_ts * p_pipeline)
+{
+  return SDL_AtomicGet(&p_pipeline->frames_queued) < p_pipeline->buffer_count || SDL_AtomicGet(&p_pipeline->quit_requested);
+}
+
+static int frame_pipeline_frame_queued(frame_pipeline_ts * p_pipeline)
+{
+  return SDL_AtomicGet(&p_pipeline->frames_queued) > 0;
+}
+
+static int frame_pipeline_mailbox_filled(frame_pipeline_ts * p_pipeline)
+{
+  return SDL_AtomicGet(&p_pipeline->mailbox_slot) != FRAME_PIPELINE_NO_SLOT;
+}
+
+/* Takes any slot out of the free slot mask, or returns FRAME_PIPELINE_NO_SLOT without a free slot */
+static int frame_pipeline_take_free_slot(frame_pipeline_ts * p_pipeline)
+{
+  for (;;)
+  {
+    const int free_slots = SDL_AtomicGet(&p_pipeline->free_slots);
+    if (free_slots == 0)
+      return FRAME_PIPELINE_NO_SLOT;
+
+    const int slot_bit = free_slots & -free_slots;
+    if (SDL_AtomicCAS(&p_pipeline->free_slots, free_slots, free_slots & ~slot_bit))
+    {
+      int slot_index = 0;
+      while ((slot_bit >> slot_index) != 1)
+      {
+        slot_index++;
+      }
+      return slot_index;
+    }
+  }
+}
+
+static void frame_pipeline_put_free_slot(frame_pipeline_ts * p_pipeline, int slot_index)
+{
+  for (;;)
+  {
+    const int free_slots = SDL_AtomicGet(&p_pipeline->free_slots);
+    if (SDL_AtomicCAS(&p_pipeline->free_slots, free_slots, free_slots | (1 << slot_index)))
+      return;
+  }
+}
+
+/*
+    Returns the slot to render the next frame into, or NULL if the render thread has to check for quitting first.
+    First in, first out waits for the presenting thread to free a slot. The mailbox never waits, since one slot
+    is presented, one holds the mailbox frame and the remaining slots are free for rendering
+*/
+static frame_slot_ts * frame_pipeline_claim_slot(frame_pipeline_ts * p_pipeline)
+{
+  if (p_pipeline->present_policy == FRAME_PRESENT_POLICY_FIFO)
+  {
+    if (!frame_pipeline_slot_free(p_pipeline))
+    {
+      frame_pipeline_sleep(&p_pipeline->renderer_waiter, p_pipeline, frame_pipeline_slot_free);
+      return NULL;
+    }
+    SDL_MemoryBarrierAcquire();
+    return &p_pipeline->slots[p_pipeline->write_index];
+  }
+
+  /* No slot is only ever free for a moment, while the presenting thread swaps the mailbox frame in and frees its previous slot */
+  const int slot_index = frame_pipeline_take_free_slot(p_pipeline);
+  if (slot_index == FRAME_PIPELINE_NO_SLOT)
+    return NULL;
+  SDL_MemoryBarrierAcquire();
+
+  p_pipeline->write_index = slot_index;
+  return &p_pipeline->slots[slot_index];
+}
+
+static void frame_pipeline_publish_slot(frame_pipeline_ts * p_pipeline)
+{
+  /* The release barrier orders the frame contents before the slot hand-off */
+  SDL_MemoryBarrierRelease();
+  if (p_pipeline->present_policy == FRAME_PRESENT_POLICY_FIFO)
+  {
+    p_pipeline->write_index = (p_pipeline->write_index + 1) % p_pipeline->buffer_count;
+    SDL_AtomicIncRef(&p_pipeline->frames_queued);
+  }
+  else
+  {
+    /* Replace the mailbox frame, a frame the presenting thread did not take in time is dropped */
+    const int replaced_slot_index = SDL_AtomicSet(&p_pipeline->mailbox_slot, p_pipeline->write_index);
+    if (replaced_slot_index != FRAME_PIPELINE_NO_SLOT)
+    {
+      SDL_AtomicIncRef(&p_pipeline->frames_dropped);
+      frame_pipeline_put_free_slot(p_pipeline, replaced_slot_index);
+    }
+  }
+  frame_pipeline_wake(&p_pipeline->presenter_waiter);
+}
+
+static int frame_pipeline_render_thread(void * p_thread_data)
+{
+  frame_pipeline_ts * const p_pipeline = (frame_pipeline_ts *)p_thread_data;
+  uint64_t frame_index = 0;
+
+  while (!SDL_AtomicGet(&p_pipeline->quit_requested))
+  {
+    frame_slot_ts * const p_slot = frame_pipeline_claim_slot(p_pipeline);
+    if (p_slot == NULL)
+      continue;
+
+    /* Render the complete next frame into the claimed slot, together with its damage against the frame before */
+    pixel_generator_begin_frame(p_pipeline->p_generator, frame_index, p_slot->framebuffer.width, p_slot->framebuffer.height);
+    damage_clear(&p_slot->damage);
+    pixel_generator_collect_damage(p_pipeline->p_generator, &p_slot->damage);
+    if (p_pipeline->indexed)
+      render_stage_fill_indexed(p_pipeline->p_pool, p_pipeline->p_generator, &p_slot->indexed_framebuffer);
+    else
+      render_stage_fill(p_pipeline->p_pool, p_pipeline->p_generator, &p_slot->framebuffer);
+    p_slot->frame_index = frame_index;
+    frame_index++;
+
+    frame_pipeline_publish_slot(p_pipeline);
+  }
+
+  return 0;
+}
+
+/* Function definitions */
+frame_pipeline_ts * frame_pipeline_create(
+  int buffer_count,
+  frame_present_policy_te present_policy,
+  int width,
+  int height,
+  int indexed,
+  pixel_generator_ts * p_generator,
+  worker_pool_ts * p_pool
+)
+{
+  frame_pipeline_ts * const p_pipeline = calloc(1, sizeof(frame_pipeline_ts));
+  if (p_pipeline == NULL)
+  {
+    fprintf(stderr, "\nCould not allocate frame pipeline - Error: Calloc failed");
+    return NULL;
+  }
+
+  const int min_buffer_count = (present_policy == FRAME_PRESENT_POLICY_MAILBOX) ? FRAME_PIPELINE_MIN_MAILBOX_BUFFERS : FRAME_PIPELINE_MIN_BUFFERS;
+  p_pipeline->buffer_count = SDL_max(min_buffer_count, SDL_min(buffer_count, FRAME_PIPELINE_MAX_BUFFERS));
+  p_pipeline->present_policy = present_policy;
+  p_pipeline->indexed = indexed;
+  p_pipeline->p_generator = p_generator;
+  p_pipeline->p_pool = p_pool;
+
+  /*
+      Every slot only needs either palette indices or client-side pixels.
+      Slots always hold complete frames, since each one skips the frames rendered into the other slots
+  */
+  for (int slot_index = 0; slot_index < p_pipeline->buffer_count; slot_index++)
+  {
+    frame_slot_ts * const p_slot = &p_pipeline->slots[slot_index];
+    damage_init(&p_slot->damage, width, height);
+    if (indexed)
+    {
+      p_slot->indexed_framebuffer.p_indices = malloc((size_t)width * (size_t)height);
+      p_slot->indexed_framebuffer.width = width;
+      p_slot->indexed_framebuffer.height = height;
+      p_slot->indexed_framebuffer.pitch = width;
+    }
+    else
+    {
+      p_slot->framebuffer.p_pixels = malloc(sizeof(client_pixel_rgba_ts) * (size_t)width * (size_t)height);
+      p_slot->framebuffer.width = width;
+      p_slot->framebuffer.height = height;
+      p_slot->framebuffer.pitch = (int)sizeof(client_pixel_rgba_ts) * width;
+    }
+
+    if (p_slot->indexed_framebuffer.p_indices == NULL && p_slot->framebuffer.p_pixels == NULL)
+    {
+      fprintf(stderr, "\nCould not allocate client-side frame pipeline buffer - Error: Malloc failed");
+      frame_pipeline_destroy(p_pipeline);
+      return NULL;
+    }
+  }
+
+  /* The mailbox starts out empty, with every slot free and none presented yet */
+  SDL_AtomicSet(&p_pipeline->mailbox_slot, FRAME_PIPELINE_NO_SLOT);
+  SDL_AtomicSet(&p_pipeline->free_slots, (1 << p_pipeline->buffer_count) - 1);
+  if (present_policy == FRAME_PRESENT_POLICY_MAILBOX)
+    p_pipeline->read_index = FRAME_PIPELINE_NO_SLOT;
+
+  p_pipeline->presenter_waiter.p_wakeup = SDL_CreateSemaphore(0);
+  p_pipeline->renderer_waiter.p_wakeup = SDL_CreateSemaphore(0);
+  if (p_pipeline->presenter_waiter.p_wakeup == NULL || p_pipeline->renderer_waiter.p_wakeup == NULL)
+  {
+    fprintf(stderr, "\nFrame pipeline semaphores could not be created - Error: %s", SDL_GetError());
+    frame_pipeline_destroy(p_pipeline);
+    return NULL;
+  }
+
+  p_pipeline->p_render_thread = SDL_CreateThread(frame_pipeline_render_thread, "render", p_pipeline);
+  if (p_pipeline->p_render_thread == NULL)
+  {
+    fprintf(stderr, "\nRender thread could not be created - Error: %s", SDL_GetError());
+    frame_pipeline_destroy(p_pipeline);
+    return NULL;
+  }
+
+  return p_pipeline;
+}
+
+void frame_pipeline_destroy(frame_pipeline_ts * p_pipeline)
+{
+  if (p_pipeline == NULL)
+    return;
+
+  if (p_pipeline->p_render_thread != NULL)
+  {
+    SDL_AtomicSet(&p_pipeline->quit_requested, 1);
+    frame_pipeline_wake(&p_pipeline->renderer_waiter);
+    SDL_WaitThread(p_pipeline->p_render_thread, NULL);
+  }
+
+  if (p_pipeline->renderer_waiter.p_wakeup != NULL)
+    SDL_DestroySemaphore(p_pipeline->renderer_waiter.p_wakeup);
+  if (p_pipeline->presenter_waiter.p_wakeup != NULL)
+    SDL_DestroySemaphore(p_pipeline->presenter_waiter.p_wakeup);
+
+  for (int slot_index = 0; slot_index < p_pipeline->buffer_count; slot_index++)
+  {
+    free(p_pipeline->slots[slot_index].indexed_framebuffer.p_indices);
+    free(p_pipeline->slots[slot_index].framebuffer.p_pixels);
+  }
+  free(p_pipeline);
+}
+
+/*
+    Returns the frame to present, which is the oldest rendered frame first in, first out and the newest rendered
+    frame with the mailbox. First in, first out waits for the render thread if no frame is queued, while the
+    mailbox presents the previous frame again instead. The slot stays valid and unchanged until it is released
+*/
+const frame_slot_ts * frame_pipeline_acquire(frame_pipeline_ts * p_pipeline)
+{
+  if (p_pipeline->present_policy == FRAME_PRESENT_POLICY_FIFO)
+  {
+    while (!frame_pipeline_frame_queued(p_pipeline))
+    {
+      frame_pipeline_sleep(&p_pipeline->presenter_waiter, p_pipeline, frame_pipeline_frame_queued);
+    }
+    SDL_MemoryBarrierAcquire();
+
+    return &p_pipeline->slots[p_pipeline->read_index];
+  }
+
+  /* Only the very first frame is waited for, there is nothing to present again before it */
+  while (p_pipeline->read_index == FRAME_PIPELINE_NO_SLOT && !frame_pipeline_mailbox_filled(p_pipeline))
+  {
+    frame_pipeline_sleep(&p_pipeline->presenter_waiter, p_pipeline, frame_pipeline_mailbox_filled);
+  }
+
+  const int mailbox_slot_index = SDL_AtomicSet(&p_pipeline->mailbox_slot, FRAME_PIPELINE_NO_SLOT);
+  SDL_MemoryBarrierAcquire();
+  if (mailbox_slot_index == FRAME_PIPELINE_NO_SLOT)
+  {
+    p_pipeline->frames_repeated++;
+  }
+  else
+  {
+    if (p_pipeline->read_index != FRAME_PIPELINE_NO_SLOT)
+      frame_pipeline_put_free_slot(p_pipeline, p_pipeline->read_index);
+    p_pipeline->read_index = mailbox_slot_index;
+  }
+
+  return &p_pipeline->slots[p_pipeline->read_index];
+}
+
+/* Hands the acquired slot back to the render thread, the mailbox keeps it until a newer frame replaces it */
+void frame_pipeline_release(frame_pipeline_ts * p_pipeline)
+{
+  if (p_pipeline->present_policy != FRAME_PRESENT_POLICY_FIFO)
+    return;
+
+  p_pipeline->read_index = (p_pipeline->read_index + 1) % p_pipeline->buffer_count;
+  SDL_MemoryBarrierRelease();
+  SDL_AtomicAdd(&p_pipeline->frames_queued, -1);
+  frame_pipeline_wake(&p_pipeline->renderer_waiter);
+}
+
+int frame_pipeline_frames_queued(frame_pipeline_ts * p_pipeline)
+{
+  return SDL_AtomicGet(&p_pipeline->frames_queued);
+}
+
+uint64_t frame_pipeline_frames_dropped(frame_pipeline_ts * p_pipeline)
+{
+  return (uint64_t)(uint32_t)SDL_AtomicGet(&p_pipeline->frames_dropped);
+}
+
+uint64_t frame_pipeline_frames_repeated(const frame_pipeline_ts * p_pipeline)
+{
+  return p_pipeline->frames_repeated;
+}
+
+const char * frame_present_policy_name(frame_present_policy_te present_policy)
+{
+  return (present_policy == FRAME_PRESENT_POLICY_MAILBOX) ? "mailbox" : "fifo";
+}
+
+int frame_present_policy_from_name(const char * p_policy_name, frame_present_policy_te * p_present_policy)
+{
+  if (SDL_strcmp(p_policy_name, "fifo") == 0)
+    *p_present_policy = FRAME_PRESENT_POLICY_FIFO;
+  else if (SDL_strcmp(p_policy_name, "mailbox") == 0)
+    *p_present_policy = FRAME_PRESENT_POLICY_MAILBOX;
+  else
+    return -1;
+  return 0;
+}
@@ -0,0 +1,91 @@
+#ifndef FRAME_PIPELINE_H
+#define FRAME_PIPELINE_H
+
+#include <stdint.h>
+#include <SDL.h>
+#include "client_pixels.h"
+#include "damage.h"
+#include "pixel_generator.h"
+#include "worker_pool.h"
+
+/* Defines */
+#define FRAME_PIPELINE_MIN_BUFFERS (2)
+#define FRAME_PIPELINE_MIN_MAILBOX_BUFFERS (3)
+#define FRAME_PIPELINE_MAX_BUFFERS (4)
+#define FRAME_PIPELINE_NO_SLOT (-1)
+
+/* Datatypes */
+typedef enum {
+  FRAME_PRESENT_POLICY_FIFO = 0,
+  FRAME_PRESENT_POLICY_MAILBOX
+} frame_present_policy_te;
+
+/* One client-side buffer of the ring, holding a complete frame together with its damage against the frame before it */
+typedef struct {
+  client_framebuffer_ts framebuffer;
+  client_framebuffer_indexed_ts indexed_framebuffer;
+  damage_tracker_ts damage;
+  uint64_t frame_index;
+} frame_slot_ts;
+
+/* Lets one thread sleep until its counterpart makes progress, without either of them taking a lock */
+typedef struct {
+  SDL_atomic_t sleeping;
+  SDL_sem * p_wakeup;
+} frame_pipeline_waiter_ts;
+
+/*
+    Single-producer, single-consumer ring of client-side buffers.
+
+    The render thread fills the slot at its write index and publishes it by incrementing the number of
+    queued frames, the presenting thread reads the slot at its read index and frees it by decrementing
+    the number of queued frames. Each index is private to its thread, so the atomic count together with
+    the memory barriers around it is the entire hand-off. The waiters only let an idle side sleep.
+
+    With the mailbox policy the render thread never waits. It renders into any free slot and swaps the
+    finished slot into the mailbox, while the presenting thread swaps the newest finished slot out of the
+    mailbox and keeps presenting it until a newer one arrives. Slots outside of the mailbox that are not
+    presented are tracked in an atomic bit mask
+*/
+typedef struct {
+  frame_slot_ts slots[FRAME_PIPELINE_MAX_BUFFERS];
+  int buffer_count;
+  frame_present_policy_te present_policy;
+  int indexed;
+  SDL_atomic_t frames_queued;
+  SDL_atomic_t mailbox_slot;
+  SDL_atomic_t free_slots;
+  SDL_atomic_t frames_dropped;
+  uint64_t frames_repeated;
+  SDL_atomic_t quit_requested;
+  int write_index;
+  int read_index;
+  frame_pipeline_waiter_ts presenter_waiter;
+  frame_pipeline_waiter_ts renderer_waiter;
+
+  /* Render thread state, owned by the render thread once it runs */
+  SDL_Thread * p_render_thread;
+  pixel_generator_ts * p_generator;
+  worker_pool_ts * p_pool;
+} frame_pipeline_ts;
+
+/* Function prototypes */
+frame_pipeline_ts * frame_pipeline_create(
+  int buffer_count,
+  frame_present_policy_te present_policy,
+  int width,
+  int height,
+  int indexed,
+  pixel_generator_ts * p_generator,
+  worker_pool_ts * p_pool
+);
+void frame_pipeline_destroy(frame_pipeline_ts * p_pipeline);
+const frame_slot_ts * frame_pipeline_acquire(frame_pipeline_ts * p_pipeline);
+void frame_pipeline_release(frame_pipeline_ts * p_pipeline);
+int frame_pipeline_frames_queued(frame_pipeline_ts * p_pipeline);
+uint64_t frame_pipeline_frames_dropped(frame_pipeline_ts * p_pipeline);
+uint64_t frame_pipeline_frames_repeated(const frame_pipeline_ts * p_pipeline);
+const char * frame_present_policy_name(frame_present_policy_te present_policy);
+int frame_present_policy_from_name(const char * p_policy_name, frame_present_policy_te * p_present_policy);
+
+#endif
@@ -0,0 +1,149 @@
+#include <stdio.h>
+#include <SDL.h>
+#include "frame_scheduler.h"
+
+/* Constants */
+static const double FRAME_SCHEDULER_SPIN_SECONDS = 0.002;
+static const int FRAME_SCHEDULER_MAX_STEPS_PER_FRAME = 8;
+
+static uint64_t frame_scheduler_period(uint64_t counter_frequency, double rate)
+{
+  return (rate > 0.0) ? (uint64_t)((double)counter_frequency / rate + 0.5) : 0;
+}
+
+static double frame_scheduler_ticks_to_ms(const frame_scheduler_ts * p_scheduler, double ticks)
+{
+  return (ticks * 1000.0) / (double)p_scheduler->counter_frequency;
+}
+
+/* Function definitions */
+void frame_scheduler_init(frame_scheduler_ts * p_scheduler, double frame_rate, double step_rate)
+{
+  SDL_memset(p_scheduler, 0, sizeof(frame_scheduler_ts));
+  p_scheduler->counter_frequency = SDL_GetPerformanceFrequency();
+  p_scheduler->frame_period = frame_scheduler_period(p_scheduler->counter_frequency, frame_rate);
+  p_scheduler->step_period = frame_scheduler_period(p_scheduler->counter_frequency, step_rate);
+  p_scheduler->spin_period = frame_scheduler_period(p_scheduler->counter_frequency, 1.0 / FRAME_SCHEDULER_SPIN_SECONDS);
+
+  const uint64_t now = SDL_GetPerformanceCounter();
+  p_scheduler->next_frame_deadline = now + p_scheduler->frame_period;
+  p_scheduler->previous_step_counter = now;
+}
+
+/*
+    Returns the number of fixed simulation steps the frame advances by, which is the time accumulated since
+    the previous frame in whole steps. After a long stall the excess steps are dropped instead of being
+    simulated all at once, so a slow frame cannot cause an ever-growing backlog of steps
+*/
+int frame_scheduler_begin_frame(frame_scheduler_ts * p_scheduler)
+{
+  if (p_scheduler->step_period == 0)
+    return 1;
+
+  const uint64_t now = SDL_GetPerformanceCounter();
+  p_scheduler->step_accumulator += now - p_scheduler->previous_step_counter;
+  p_scheduler->previous_step_counter = now;
+
+  uint64_t step_count = p_scheduler->step_accumulator / p_scheduler->step_period;
+  p_scheduler->step_accumulator -= step_count * p_scheduler->step_period;
+  if (step_count > (uint64_t)FRAME_SCHEDULER_MAX_STEPS_PER_FRAME)
+  {
+    p_scheduler->steps_dropped += step_count - FRAME_SCHEDULER_MAX_STEPS_PER_FRAME;
+    step_count = FRAME_SCHEDULER_MAX_STEPS_PER_FRAME;
+  }
+  return (int)step_count;
+}
+
+/*
+    Waits for the deadline of the next frame. Most of the wait sleeps, which gives the CPU away but may
+    oversleep by the scheduler granularity, and only the last moments before the deadline are spent spinning
+    on the performance counter. Deadlines advance by whole frame periods, so a late frame does not shift
+    every following frame, unless it missed its deadline by more than a full period
+*/
+void frame_scheduler_wait(frame_scheduler_ts * p_scheduler)
+{
+  if (p_scheduler->frame_period == 0)
+    return;
+
+  const uint64_t deadline = p_scheduler->next_frame_deadline;
+  uint64_t now = SDL_GetPerformanceCounter();
+  const int frame_late = (now >= deadline);
+  if (!frame_late)
+  {
+    if (deadline - now > p_scheduler->spin_period)
+    {
+      const uint64_t sleep_ticks = deadline - now - p_scheduler->spin_period;
+      SDL_Delay((Uint32)((sleep_ticks * 1000) / p_scheduler->counter_frequency));
+    }
+
+    do
+    {
+      now = SDL_GetPerformanceCounter();
+    } while (now < deadline);
+  }
+
+  p_scheduler->next_frame_deadline = deadline + p_scheduler->frame_period;
+  if (now > p_scheduler->next_frame_deadline)
+    p_scheduler->next_frame_deadline = now + p_scheduler->frame_period;
+
+  /*
+      Pacing jitter is the deviation of the intervals between wakeups from the frame period. The first wakeup
+      has no interval before it, so late frames are counted from the second one on, like paced frames
+  */
+  if (p_scheduler->previous_wake_counter != 0)
+  {
+    if (frame_late)
+      p_scheduler->frames_late++;
+
+    const uint64_t interval = now - p_scheduler->previous_wake_counter;
+    const uint64_t deviation = (interval > p_scheduler->frame_period) ? interval - p_scheduler->frame_period : p_scheduler->frame_period - interval;
+    p_scheduler->frames_paced++;
+    p_scheduler->interval_sum += (double)interval;
+    p_scheduler->interval_square_sum += (double)interval * (double)interval;
+    p_scheduler->interval_deviation_max = SDL_max(p_scheduler->interval_deviation_max, deviation);
+  }
+  p_scheduler->previous_wake_counter = now;
+}
+
+double frame_scheduler_interval_mean_ms(const frame_scheduler_ts * p_scheduler)
+{
+  if (p_scheduler->frames_paced == 0)
+    return 0.0;
+
+  return frame_scheduler_ticks_to_ms(p_scheduler, p_scheduler->interval_sum / (double)p_scheduler->frames_paced);
+}
+
+/* Standard deviation of the intervals between frames */
+double frame_scheduler_jitter_ms(const frame_scheduler_ts * p_scheduler)
+{
+  if (p_scheduler->frames_paced == 0)
+    return 0.0;
+
+  const double interval_mean = p_scheduler->interval_sum / (double)p_scheduler->frames_paced;
+  const double interval_variance = (p_scheduler->interval_square_sum / (double)p_scheduler->frames_paced) - (interval_mean * interval_mean);
+  return frame_scheduler_ticks_to_ms(p_scheduler, SDL_sqrt(SDL_max(interval_variance, 0.0)));
+}
+
+/* Largest deviation of an interval between frames from the frame period */
+double frame_scheduler_jitter_max_ms(const frame_scheduler_ts * p_scheduler)
+{
+  return frame_scheduler_ticks_to_ms(p_scheduler, (double)p_scheduler->interval_deviation_max);
+}
+
+void frame_scheduler_print_summary(const frame_scheduler_ts * p_scheduler, FILE * p_stream)
+{
+  if (p_scheduler->frame_period == 0)
+    return;
+
+  fprintf(
+    p_stream,
+    "Frame pacing: target %.3f ms, mean %.3f ms, jitter %.3f ms, max deviation %.3f ms, %llu of %llu frames late, %llu steps dropped\n",
+    frame_scheduler_ticks_to_ms(p_scheduler, (double)p_scheduler->frame_period),
+    frame_scheduler_interval_mean_ms(p_scheduler),
+    frame_scheduler_jitter_ms(p_scheduler),
+    frame_scheduler_jitter_max_ms(p_scheduler),
+    (unsigned long long)p_scheduler->frames_late,
+    (unsigned long long)p_scheduler->frames_paced,
+    (unsigned long long)p_scheduler->steps_dropped
+  );
+}
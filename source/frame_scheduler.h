@@ -0,0 +1,43 @@
+#ifndef FRAME_SCHEDULER_H
+#define FRAME_SCHEDULER_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+/* Datatypes */
+
+/*
+    Paces frames to a target rate on the performance counter and splits the elapsed time into fixed simulation steps.
+    A zero frame period leaves frames unthrottled and a zero step period makes every frame exactly one step
+*/
+typedef struct {
+  uint64_t counter_frequency;
+  uint64_t frame_period;
+  uint64_t step_period;
+  uint64_t spin_period;
+  uint64_t next_frame_deadline;
+
+  /* Fixed timestep state */
+  uint64_t previous_step_counter;
+  uint64_t step_accumulator;
+  uint64_t steps_dropped;
+
+  /* Pacing statistics, in performance counter ticks */
+  uint64_t previous_wake_counter;
+  uint64_t frames_paced;
+  uint64_t frames_late;
+  double interval_sum;
+  double interval_square_sum;
+  uint64_t interval_deviation_max;
+} frame_scheduler_ts;
+
+/* Function prototypes */
+void frame_scheduler_init(frame_scheduler_ts * p_scheduler, double frame_rate, double step_rate);
+int frame_scheduler_begin_frame(frame_scheduler_ts * p_scheduler);
+void frame_scheduler_wait(frame_scheduler_ts * p_scheduler);
+double frame_scheduler_interval_mean_ms(const frame_scheduler_ts * p_scheduler);
+double frame_scheduler_jitter_ms(const frame_scheduler_ts * p_scheduler);
+double frame_scheduler_jitter_max_ms(const frame_scheduler_ts * p_scheduler);
+void frame_scheduler_print_summary(const frame_scheduler_ts * p_scheduler, FILE * p_stream);
+
+#endif
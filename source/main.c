@@ -1,6 +1,23 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <SDL.h>
+#include "client_pixels.h"
+#include "pixel_convert.h"
+#include "options.h"
+#include "pixel_generator.h"
+#include "benchmark.h"
+#include "worker_pool.h"
+#include "render_stages.h"
+#include "damage.h"
+#include "palette.h"
+#include "blend.h"
+#include "raster.h"
+#include "sprite.h"
+#include "tilemap.h"
+#include "frame_pipeline.h"
+#include "frame_scheduler.h"
+#include "capture.h"
+#include "video_stream.h"
 
 /* Defines */
 #define MAX_FPS_TITLE_LENGTH (128)
@@ -8,22 +25,11 @@
 /* Constants */
 const int OS_FAILURE_RETURN_CODE = -1;
 const char WINDOW_TITLE[] = "SDL2 rendering pixels without graphics API";
-const int WINDOW_WIDTH = 800;
-const int WINDOW_HEIGHT = 600;
-const int WINDOW_WIDTH_VIRTUAL = 160;
-const int WINDOW_HEIGHT_VIRTUAL = 144;
-const int WINDOW_PIXELS_TOTAL_VIRTUAL = WINDOW_WIDTH_VIRTUAL * WINDOW_HEIGHT_VIRTUAL;
-
-/* Datatypes */
-typedef struct {
-  uint8_t red;
-  uint8_t green;
-  uint8_t blue;
-  uint8_t alpha;
-} client_pixel_rgba_ts;
 
 /* Function prototypes */
 void cleanup(int report_status);
+int find_render_driver(const char * p_driver_name);
+void list_render_drivers(void);
 
 /* Resource related state */
 SDL_Window * p_window = NULL;
@@ -31,98 +37,419 @@ SDL_Renderer * p_renderer = NULL;
 SDL_Texture * p_window_texture = NULL;
 SDL_PixelFormat * p_texture_pixel_format = NULL;
 client_pixel_rgba_ts * p_client_pixels_rgba = NULL;
+uint8_t * p_client_pixels_indexed = NULL;
+benchmark_ts frame_benchmark;
+worker_pool_ts * p_worker_pool = NULL;
+frame_pipeline_ts * p_frame_pipeline = NULL;
+pixel_generator_ts pixel_generator;
+capture_ts * p_capture = NULL;
+video_stream_ts * p_video_stream = NULL;
 
 /* Entry point */
 int main(int argc, char * argv[])
 {
-  /* Initialize SDL2 video and events subsystems */
-  if (SDL_Init(SDL_INIT_VIDEO) != 0)
+  /* Parse the command-line options before touching any SDL2 subsystem */
+  program_options_ts options;
+  if (options_parse(&options, argc, argv) != 0)
   {
-    fprintf(stderr, "\nRequired SDL2 subsystems could not be initialized - Error: %s", SDL_GetError());
+    fprintf(stderr, "\n");
+    options_print_usage(stderr, argv[0]);
     cleanup(OS_FAILURE_RETURN_CODE);
   }
 
-  /* Video and events subsystems initialized successfully - Now create the window */
-  p_window = SDL_CreateWindow(
-    WINDOW_TITLE,
-    SDL_WINDOWPOS_CENTERED,
-    SDL_WINDOWPOS_CENTERED,
-    WINDOW_WIDTH,
-    WINDOW_HEIGHT,
-    SDL_WINDOW_SHOWN
-  );
-
-  if (p_window == NULL)
+  if (options.show_help)
   {
-    fprintf(stderr, "\nSDL2 window could not be created - Error: %s", SDL_GetError());
-    cleanup(OS_FAILURE_RETURN_CODE);
+    options_print_usage(stdout, argv[0]);
+    cleanup(0);
   }
 
-  /* SDL2 window created successfully - Now create the renderer */
-  p_renderer = SDL_CreateRenderer(p_window, -1, SDL_RENDERER_ACCELERATED);
-  if (p_renderer == NULL)
+  /* Verify the pixel conversion kernels against SDL2 instead of rendering, if requested, which needs no video subsystem */
+  if (options.verify_conversion)
   {
-    fprintf(stderr, "\nSDL2 renderer could not be created - Error: %s", SDL_GetError());
-    cleanup(OS_FAILURE_RETURN_CODE);
+    const int verification_failures = pixel_convert_verify_kernels() + palette_verify_kernels() + blend_verify_kernels();
+    cleanup((verification_failures == 0) ? 0 : OS_FAILURE_RETURN_CODE);
   }
 
-  /* SDL2 renderer created successfully - Now setup the texture to act as window pixel color buffer */
-  p_window_texture = SDL_CreateTexture(
-    p_renderer,
-    SDL_PIXELFORMAT_RGBA8888,
-    SDL_TEXTUREACCESS_STREAMING,
-    WINDOW_WIDTH_VIRTUAL,
-    WINDOW_HEIGHT_VIRTUAL
-  );
+  if (options.verify_generators)
+  {
+    const int verification_failures = pixel_generator_verify_kernels();
+    cleanup((verification_failures == 0) ? 0 : OS_FAILURE_RETURN_CODE);
+  }
 
-  if (p_window_texture == NULL)
+  if (options.verify_rendering)
   {
-    fprintf(stderr, "\nSDL2 texture could not be created - Error: %s", SDL_GetError());
-    cleanup(OS_FAILURE_RETURN_CODE);
+    const int verification_failures = raster_verify_primitives() + sprite_verify_blits() + tilemap_verify_rendering();
+    cleanup((verification_failures == 0) ? 0 : OS_FAILURE_RETURN_CODE);
   }
 
-  /* SDL2 window texture created successfully - Now extract the created texture attributes for robust, per-pixel texture manipulation */
-  uint32_t window_texture_format;
-  const int query_texture_successful = SDL_QueryTexture(p_window_texture, &window_texture_format, NULL, NULL, NULL);
-  if (query_texture_successful != 0)
+  /*
+      Initialize SDL2 video and events subsystems.
+      Headless rendering runs on a video driver that needs neither a display nor a GPU, preferring the
+      offscreen driver and falling back to the dummy driver for SDL2 builds without offscreen support
+  */
+  if (options.headless)
   {
-    fprintf(stderr, "\nSDL2 texture attributes could not be queried - Error: %s", SDL_GetError());
-    cleanup(OS_FAILURE_RETURN_CODE);
+    SDL_SetHint(SDL_HINT_VIDEODRIVER, "offscreen");
   }
 
-  /* Extract the pixel format of the texture so we can set texture pixel color values robustly */
-  p_texture_pixel_format = SDL_AllocFormat(window_texture_format);
-  if (p_texture_pixel_format == NULL)
+  int sdl_initialized = (SDL_Init(SDL_INIT_VIDEO) == 0);
+  if (!sdl_initialized && options.headless)
   {
-    fprintf(stderr, "\nSDL2 texture pixel format could not be determined - Error: %s", SDL_GetError());
-    cleanup(OS_FAILURE_RETURN_CODE);
+    SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+    sdl_initialized = (SDL_Init(SDL_INIT_VIDEO) == 0);
   }
 
-  /* SDL2 texture attributes determined successfully - Now configure the renderer for fixed-ration rendering */
-  const int logical_size_set = SDL_RenderSetLogicalSize(p_renderer, WINDOW_WIDTH_VIRTUAL, WINDOW_HEIGHT_VIRTUAL);
-  if (logical_size_set != 0)
+  if (!sdl_initialized)
   {
-    fprintf(stderr, "\nSDL2 logical render size could not be set - Error: %s", SDL_GetError());
+    fprintf(stderr, "\nRequired SDL2 subsystems could not be initialized - Error: %s", SDL_GetError());
     cleanup(OS_FAILURE_RETURN_CODE);
   }
 
-  /* Set renderer draw and clear color in case the renderer is to be cleared */
-  const int set_render_draw_color_successful = SDL_SetRenderDrawColor(p_renderer, 0x20 ,0x20, 0x20, 0xFF);
-  if (set_render_draw_color_successful != 0)
+  if (options.list_renderers)
+  {
+    list_render_drivers();
+    cleanup(0);
+  }
+
+  /*
+      Setup the window, renderer and texture that frames are presented through. Without presentation the frames end
+      with the client-side pixels, so none of them are created and SDL2 only provides its timers and events
+  */
+  SDL_RendererInfo renderer_info;
+  uint32_t window_texture_format = SDL_PIXELFORMAT_UNKNOWN;
+  pixel_converter_ts texture_pixel_converter;
+  palette_ts texture_palette;
+  upload_mode_te upload_mode = options.upload_mode;
+  if (options.present)
+  {
+    /* Video and events subsystems initialized successfully - Now create the window */
+    p_window = SDL_CreateWindow(
+      WINDOW_TITLE,
+      SDL_WINDOWPOS_CENTERED,
+      SDL_WINDOWPOS_CENTERED,
+      options.window_width,
+      options.window_height,
+      options.headless ? SDL_WINDOW_HIDDEN : SDL_WINDOW_SHOWN
+    );
+
+    if (p_window == NULL)
+    {
+      fprintf(stderr, "\nSDL2 window could not be created - Error: %s", SDL_GetError());
+      cleanup(OS_FAILURE_RETURN_CODE);
+    }
+
+    /*
+        SDL2 window created successfully - Now create the renderer. A named driver is taken as is, otherwise
+        SDL2 picks the first accelerated driver, or a software renderer when running headless
+    */
+    int render_driver_index = -1;
+    uint32_t renderer_flags = options.headless ? SDL_RENDERER_SOFTWARE : SDL_RENDERER_ACCELERATED;
+    if (options.p_renderer_name != NULL)
+    {
+      render_driver_index = find_render_driver(options.p_renderer_name);
+      if (render_driver_index < 0)
+      {
+        fprintf(stderr, "\nSDL2 render driver '%s' is not available, see --list-renderers", options.p_renderer_name);
+        cleanup(OS_FAILURE_RETURN_CODE);
+      }
+      renderer_flags = 0;
+    }
+    if (options.vsync)
+      renderer_flags |= SDL_RENDERER_PRESENTVSYNC;
+
+    p_renderer = SDL_CreateRenderer(p_window, render_driver_index, renderer_flags);
+    if (p_renderer == NULL)
+    {
+      fprintf(stderr, "\nSDL2 renderer could not be created - Error: %s", SDL_GetError());
+      cleanup(OS_FAILURE_RETURN_CODE);
+    }
+
+    if (SDL_GetRendererInfo(p_renderer, &renderer_info) != 0)
+    {
+      fprintf(stderr, "\nSDL2 renderer attributes could not be queried - Error: %s", SDL_GetError());
+      cleanup(OS_FAILURE_RETURN_CODE);
+    }
+
+    /*
+        SDL2 renderer created successfully - Now setup the texture to act as window pixel color buffer.
+        Zero-copy rendering requires a texture format the renderer supports natively with the bytes laid out exactly
+        like the client-side pixels. SDL2 would otherwise convert from a hidden staging buffer on every unlock.
+        Without zero-copy, the renderer's own format that is cheapest to convert into avoids a second conversion inside SDL2
+    */
+    uint32_t window_texture_format_requested;
+    if (options.zero_copy)
+    {
+      window_texture_format_requested = pixel_convert_choose_zero_copy_format(&renderer_info);
+      if (window_texture_format_requested == SDL_PIXELFORMAT_UNKNOWN)
+      {
+        fprintf(stderr, "\nSDL2 renderer '%s' has no native texture format laid out like the client-side pixels, zero-copy rendering is not supported", renderer_info.name);
+        cleanup(OS_FAILURE_RETURN_CODE);
+      }
+    }
+    else
+    {
+      window_texture_format_requested = pixel_convert_choose_texture_format(&renderer_info, SDL_PIXELFORMAT_RGBA8888);
+    }
+    p_window_texture = SDL_CreateTexture(
+      p_renderer,
+      window_texture_format_requested,
+      SDL_TEXTUREACCESS_STREAMING,
+      options.virtual_width,
+      options.virtual_height
+    );
+
+    if (p_window_texture == NULL)
+    {
+      fprintf(stderr, "\nSDL2 texture could not be created - Error: %s", SDL_GetError());
+      cleanup(OS_FAILURE_RETURN_CODE);
+    }
+
+    /* SDL2 window texture created successfully - Now extract the created texture attributes for robust, per-pixel texture manipulation */
+    const int query_texture_successful = SDL_QueryTexture(p_window_texture, &window_texture_format, NULL, NULL, NULL);
+    if (query_texture_successful != 0)
+    {
+      fprintf(stderr, "\nSDL2 texture attributes could not be queried - Error: %s", SDL_GetError());
+      cleanup(OS_FAILURE_RETURN_CODE);
+    }
+
+    /* Extract the pixel format of the texture so we can set texture pixel color values robustly */
+    p_texture_pixel_format = SDL_AllocFormat(window_texture_format);
+    if (p_texture_pixel_format == NULL)
+    {
+      fprintf(stderr, "\nSDL2 texture pixel format could not be determined - Error: %s", SDL_GetError());
+      cleanup(OS_FAILURE_RETURN_CODE);
+    }
+
+    /*
+        Select the row converter for the texture pixel format once, instead of decoding the format for every texel.
+        Without a forced kernel the widest kernel the CPU supports for this format is dispatched to
+    */
+    if (!options.convert_kernel_forced)
+    {
+      pixel_converter_init(&texture_pixel_converter, p_texture_pixel_format);
+    }
+    else if (pixel_converter_init_kernel(&texture_pixel_converter, p_texture_pixel_format, options.convert_kernel) != 0)
+    {
+      fprintf(stderr, "\nPixel conversion kernel '%s' is not available for this CPU and texture pixel format", pixel_kernel_name(options.convert_kernel));
+      cleanup(OS_FAILURE_RETURN_CODE);
+    }
+
+    /* Convert the palette of indexed rendering into texels once, so expanding an index is a single table lookup */
+    if (options.indexed && palette_init(&texture_palette, &texture_pixel_converter, options.p_palette_name) != 0)
+    {
+      fprintf(stderr, "\nUnknown palette '%s'", options.p_palette_name);
+      cleanup(OS_FAILURE_RETURN_CODE);
+    }
+
+    /*
+        Select how client-side pixels reach the texture. Textures laid out like the client-side pixels need no conversion:
+        accelerated renderers upload them straight from the client-side buffer, which saves copying them into the staging
+        pixels of a lock first, while the locked pixels of software renderers are the texture itself and take one bulk copy
+        when their pitch matches the client-side rows, or one copy per row otherwise
+    */
+    const int texture_matches_client_pixels = !options.zero_copy && !options.indexed && (window_texture_format == SDL_PIXELFORMAT_RGBA32);
+    if (upload_mode == UPLOAD_MODE_AUTO)
+    {
+      void * p_texture_pixels = NULL;
+      int texture_pitch = 0;
+      if (!texture_matches_client_pixels)
+      {
+        upload_mode = UPLOAD_MODE_CONVERT;
+      }
+      else if (renderer_info.flags & SDL_RENDERER_ACCELERATED)
+      {
+        upload_mode = UPLOAD_MODE_UPDATE;
+      }
+      else if (SDL_LockTexture(p_window_texture, NULL, &p_texture_pixels, &texture_pitch) == 0)
+      {
+        SDL_UnlockTexture(p_window_texture);
+        upload_mode = (texture_pitch == options.virtual_width * (int)sizeof(client_pixel_rgba_ts)) ? UPLOAD_MODE_BULK : UPLOAD_MODE_ROWS;
+      }
+      else
+      {
+        upload_mode = UPLOAD_MODE_ROWS;
+      }
+    }
+    else if (upload_mode != UPLOAD_MODE_CONVERT && !texture_matches_client_pixels)
+    {
+      fprintf(stderr, "\nThe %s upload mode needs a texture laid out like the client-side pixels, which the renderer did not provide", upload_mode_name(upload_mode));
+      cleanup(OS_FAILURE_RETURN_CODE);
+    }
+
+    /* SDL2 texture attributes determined successfully - Now configure the renderer for fixed-ration rendering */
+    const int logical_size_set = SDL_RenderSetLogicalSize(p_renderer, options.virtual_width, options.virtual_height);
+    if (logical_size_set != 0)
+    {
+      fprintf(stderr, "\nSDL2 logical render size could not be set - Error: %s", SDL_GetError());
+      cleanup(OS_FAILURE_RETURN_CODE);
+    }
+
+    /* Set renderer draw and clear color in case the renderer is to be cleared */
+    const int set_render_draw_color_successful = SDL_SetRenderDrawColor(p_renderer, 0x20 ,0x20, 0x20, 0xFF);
+    if (set_render_draw_color_successful != 0)
+    {
+      fprintf(stderr, "\nSDL2 renderer draw color could not be set - Error: %s", SDL_GetError());
+      cleanup(OS_FAILURE_RETURN_CODE);
+    }
+  }
+
+  /*
+      SDL2 related setup and configuration completed successfully - Now allocate a client-side pixel buffer for offline rendering.
+      Zero-copy rendering writes into the locked texture instead and needs no client-side pixel buffer,
+      while indexed rendering only needs one palette index per pixel. Pipelined rendering allocates its own buffers
+  */
+  if (options.pipeline)
   {
-    fprintf(stderr, "\nSDL2 renderer draw color could not be set - Error: %s", SDL_GetError());
+    /* Every client-side buffer belongs to the frame pipeline */
+  }
+  else if (options.indexed)
+  {
+    p_client_pixels_indexed = malloc((size_t)options.virtual_width * (size_t)options.virtual_height);
+    if (p_client_pixels_indexed == NULL)
+    {
+      fprintf(stderr, "\nCould not allocate client-side palette index buffer for offline rendering - Error: Malloc failed");
+      cleanup(OS_FAILURE_RETURN_CODE);
+    }
+  }
+  else if (!options.zero_copy)
+  {
+    p_client_pixels_rgba = malloc(sizeof(client_pixel_rgba_ts) * (size_t)options.virtual_width * (size_t)options.virtual_height);
+    if (p_client_pixels_rgba == NULL)
+    {
+      fprintf(stderr, "\nCould not allocate client-side pixel buffer for offline rendering - Error: Malloc failed");
+      cleanup(OS_FAILURE_RETURN_CODE);
+    }
+  }
+  const client_framebuffer_ts client_framebuffer = {
+    p_client_pixels_rgba,
+    options.virtual_width,
+    options.virtual_height,
+    (int)sizeof(client_pixel_rgba_ts) * options.virtual_width
+  };
+  const client_framebuffer_indexed_ts client_indexed_framebuffer = {
+    p_client_pixels_indexed,
+    options.virtual_width,
+    options.virtual_height,
+    options.virtual_width
+  };
+
+  /* Setup the pixel generator that renders every frame, patterns report their own allocation failures */
+  const int pixel_generator_init_result = pixel_generator_init(&pixel_generator, options.p_pattern_name, options.seed);
+  if (pixel_generator_init_result != 0)
+  {
+    if (pixel_generator_init_result == PIXEL_GENERATOR_UNKNOWN_PATTERN)
+      fprintf(stderr, "\nUnknown pixel generator pattern '%s'", options.p_pattern_name);
     cleanup(OS_FAILURE_RETURN_CODE);
   }
 
-  /* SDL2 related setup and configuration completed successfully - Now allocate a client-side pixel buffer for offline rendering */
-  p_client_pixels_rgba = malloc(sizeof(client_pixel_rgba_ts) * WINDOW_PIXELS_TOTAL_VIRTUAL);
-  if (p_client_pixels_rgba == NULL)
+  if (options.indexed && pixel_generator.fill_index_rows == NULL)
   {
-    fprintf(stderr, "\nCould not allocate client-side pixel buffer for offline rendering - Error: Malloc failed");
+    fprintf(stderr, "\nPixel generator pattern '%s' cannot render palette indices", pixel_generator.p_name);
     cleanup(OS_FAILURE_RETURN_CODE);
   }
+  uint64_t frame_index = 0;
+
+  /*
+      Track the regions that change between frames, so only those are filled, converted and uploaded.
+      The texture holds no valid pixels until the first frame uploads all of them
+  */
+  damage_tracker_ts frame_damage;
+  damage_init(&frame_damage, options.virtual_width, options.virtual_height);
+  int texture_requires_full_upload = 1;
+  uint64_t texture_frame_index = 0;
+  uint64_t damaged_texels_total = 0;
+
+  /* Start the worker threads that split the fill and conversion stages into row bands, unless running single-threaded */
+  if (options.thread_count != 1)
+  {
+    p_worker_pool = worker_pool_create(options.thread_count);
+    if (p_worker_pool == NULL)
+      cleanup(OS_FAILURE_RETURN_CODE);
+  }
+
+  /*
+      Hand the pixel generator over to a render thread that fills the next frames into a ring of client-side buffers,
+      while this thread converts and presents them, if requested
+  */
+  if (options.pipeline)
+  {
+    p_frame_pipeline = frame_pipeline_create(options.buffer_count, options.present_policy, options.virtual_width, options.virtual_height, options.indexed, &pixel_generator, p_worker_pool);
+    if (p_frame_pipeline == NULL)
+      cleanup(OS_FAILURE_RETURN_CODE);
+  }
+
+  /*
+      Capture frames on a background I/O thread, if requested. Without client-side pixels to copy,
+      the renderer output is read back after the texture is copied into it
+  */
+  const int capture_readback = options.capture_readback || options.zero_copy || options.indexed;
+  if (options.p_capture_path != NULL)
+  {
+    int capture_width = options.virtual_width;
+    int capture_height = options.virtual_height;
+    if (capture_readback && SDL_GetRendererOutputSize(p_renderer, &capture_width, &capture_height) != 0)
+    {
+      fprintf(stderr, "\nSDL2 renderer output size could not be queried - Error: %s", SDL_GetError());
+      cleanup(OS_FAILURE_RETURN_CODE);
+    }
+
+    const capture_format_te capture_format = capture_format_from_path(options.p_capture_path);
+    p_capture = capture_create(options.p_capture_path, capture_format, capture_width, capture_height, options.capture_queue_length);
+    if (p_capture == NULL)
+      cleanup(OS_FAILURE_RETURN_CODE);
+  }
+
+  /*
+      Stream every frame to an external encoder, if requested. Status output moves to the standard error
+      while the standard output carries the frames
+  */
+  FILE * const p_status_stream = (options.p_video_path != NULL && video_stream_is_stdout(options.p_video_path)) ? stderr : stdout;
+  if (options.p_video_path != NULL)
+  {
+    p_video_stream = video_stream_open(options.p_video_path);
+    if (p_video_stream == NULL)
+      cleanup(OS_FAILURE_RETURN_CODE);
+
+    fprintf(
+      stderr,
+      "Streaming raw video, encode with: ffmpeg -f rawvideo -pixel_format rgba -video_size %dx%d -framerate %g -i %s <output>\n",
+      options.virtual_width,
+      options.virtual_height,
+      (options.frame_rate > 0.0) ? options.frame_rate : 60.0,
+      options.p_video_path
+    );
+  }
+
+  /* Record per-stage frame timings, if requested */
+  if (options.benchmark)
+  {
+    if (benchmark_init(&frame_benchmark, options.frame_limit, options.benchmark_warmup_frames) != 0)
+      cleanup(OS_FAILURE_RETURN_CODE);
+
+    benchmark_set_property(&frame_benchmark, "video_driver", "%s", SDL_GetCurrentVideoDriver());
+    benchmark_set_property(&frame_benchmark, "renderer", "%s", options.present ? renderer_info.name : "none");
+    benchmark_set_property(&frame_benchmark, "vsync", "%d", (options.present && (renderer_info.flags & SDL_RENDERER_PRESENTVSYNC)) ? 1 : 0);
+    benchmark_set_property(&frame_benchmark, "texture", "%s", options.present ? SDL_GetPixelFormatName(window_texture_format) : "none");
+    benchmark_set_property(&frame_benchmark, "converter", "%s", (options.zero_copy || !options.present) ? "none" : texture_pixel_converter.p_name);
+    benchmark_set_property(&frame_benchmark, "upload", "%s", (options.zero_copy || !options.present) ? "none" : upload_mode_name(upload_mode));
+    benchmark_set_property(&frame_benchmark, "pattern", "%s %s", pixel_generator.p_name, pixel_kernel_name(pixel_generator.kernel));
+    benchmark_set_property(&frame_benchmark, "palette", "%s", options.indexed ? texture_palette.p_name : "none");
+    benchmark_set_property(&frame_benchmark, "zero_copy", "%d", options.zero_copy);
+    benchmark_set_property(&frame_benchmark, "damage_tracking", "%d", options.zero_copy ? 0 : options.damage_tracking);
+    benchmark_set_property(&frame_benchmark, "threads", "%d", worker_pool_thread_count(p_worker_pool));
+    benchmark_set_property(&frame_benchmark, "pipeline_buffers", "%d", options.pipeline ? options.buffer_count : 0);
+    benchmark_set_property(&frame_benchmark, "present_policy", "%s", options.pipeline ? frame_present_policy_name(options.present_policy) : "none");
+    benchmark_set_property(&frame_benchmark, "virtual_size", "%dx%d", options.virtual_width, options.virtual_height);
+    benchmark_set_property(&frame_benchmark, "capture", "%s", (p_capture == NULL) ? "none" : capture_format_name(p_capture->format));
+    benchmark_set_property(&frame_benchmark, "video_out", "%d", (p_video_stream != NULL) ? 1 : 0);
+    benchmark_set_property(&frame_benchmark, "present", "%d", options.present);
+  }
 
-  /* Timing related */
+  /* Timing related, where frames are paced to the requested rate and the pattern advances in fixed simulation steps */
+  frame_scheduler_ts frame_scheduler;
+  frame_scheduler_init(&frame_scheduler, options.frame_rate, options.step_rate);
+  uint64_t simulation_step = 0;
+  const uint64_t run_started_in_millis = SDL_GetTicks64();
   uint64_t timer_started_in_millis = SDL_GetTicks64();
   const unsigned int millis_per_second = 1000;
   unsigned int frames_per_second = 0;
@@ -132,6 +459,15 @@ int main(int argc, char * argv[])
   int window_close_requested = 0;
   while (!window_close_requested)
   {
+    /* Stop after the requested number of frames or seconds, which is the only way to end a headless run without a signal */
+    if (options.frame_limit != 0 && frame_index >= options.frame_limit)
+      break;
+
+    if (options.seconds_limit > 0.0 && (double)(SDL_GetTicks64() - run_started_in_millis) >= options.seconds_limit * millis_per_second)
+      break;
+
+    benchmark_begin_frame(&frame_benchmark);
+
     /* Process SDL2 window events */
     SDL_Event window_event;
     while (SDL_PollEvent(&window_event) != 0)
@@ -147,6 +483,17 @@ int main(int argc, char * argv[])
           {
             window_close_requested = 1;
           }
+          else if (window_event.key.keysym.sym == SDLK_p && options.indexed)
+          {
+            /* Swapping palettes leaves the palette indices untouched, only the texels are expanded again */
+            palette_load_preset(&texture_palette, &texture_pixel_converter, palette_next_preset_name(texture_palette.p_name));
+            texture_requires_full_upload = 1;
+          }
+          break;
+        case SDL_RENDER_TARGETS_RESET:
+        case SDL_RENDER_DEVICE_RESET:
+          /* The renderer may have dropped the texture contents, so the next frame uploads every texel again */
+          texture_requires_full_upload = 1;
           break;
       }
     }
@@ -155,9 +502,27 @@ int main(int argc, char * argv[])
     const uint64_t timer_millis_elapsed = SDL_GetTicks64() - timer_started_in_millis;
     if (timer_millis_elapsed >= millis_per_second)
     {
-      /* Show the FPS count through the window title */
-      snprintf(fps_window_title, MAX_FPS_TITLE_LENGTH, "%s - FPS: %u", WINDOW_TITLE, frames_per_second);
-      SDL_SetWindowTitle(p_window, fps_window_title);
+      /* Show the FPS count through the window title, or on the standard output when nobody can see the window */
+      if (options.headless)
+      {
+        fprintf(p_status_stream, "FPS: %u\n", frames_per_second);
+      }
+      else
+      {
+        snprintf(fps_window_title, MAX_FPS_TITLE_LENGTH, "%s - FPS: %u", WINDOW_TITLE, frames_per_second);
+        SDL_SetWindowTitle(p_window, fps_window_title);
+      }
+
+      /* The mailbox trades frames for latency, so report how many it dropped and presented again so far */
+      if (p_frame_pipeline != NULL && options.present_policy == FRAME_PRESENT_POLICY_MAILBOX)
+      {
+        fprintf(
+          p_status_stream,
+          "Frames dropped: %llu, repeated: %llu\n",
+          (unsigned long long)frame_pipeline_frames_dropped(p_frame_pipeline),
+          (unsigned long long)frame_pipeline_frames_repeated(p_frame_pipeline)
+        );
+      }
 
       /* Reset the time and statistics */
       timer_started_in_millis = SDL_GetTicks64();
@@ -165,100 +530,288 @@ int main(int argc, char * argv[])
     }
     frames_per_second++;
 
-    /* All SDL2 window events processed - Now render into the client-side pixel buffer */
-    for (int texel_y = 0; texel_y < WINDOW_HEIGHT_VIRTUAL; texel_y++)
-    {
-      for (int texel_x = 0; texel_x < WINDOW_WIDTH_VIRTUAL; texel_x++)
-      {
-        const int client_texel_index = (WINDOW_WIDTH_VIRTUAL * texel_y) + texel_x;
-        client_pixel_rgba_ts * const p_client_pixel_color = p_client_pixels_rgba + client_texel_index;
-        
-        /* Determine a random color intensity to render per pixel */
-        const uint8_t random_intensity = (uint8_t)(rand() % 80);
-
-        /* Render into the client-side pixel buffer */
-        p_client_pixel_color->red   = random_intensity;
-        p_client_pixel_color->green = random_intensity;
-        p_client_pixel_color->blue  = random_intensity;
-        p_client_pixel_color->alpha = 0xFF;
-      }
-    }
+    /* Advance the pixel generator by the simulation steps elapsed since the previous frame, unless the render thread owns it */
+    const int simulation_steps = frame_scheduler_begin_frame(&frame_scheduler);
+    if (frame_index > 0)
+      simulation_step += (uint64_t)simulation_steps;
+    if (p_frame_pipeline == NULL)
+      pixel_generator_begin_frame(&pixel_generator, simulation_step, options.virtual_width, options.virtual_height);
+    frame_index++;
+    benchmark_mark(&frame_benchmark, BENCHMARK_STAGE_EVENTS);
 
     /*
         Update texture color data before rendering it into the (hidden) renderer surface.
 
         The pointer to the texture pixels must be used for WRITING ONLY using the provided pitch!
     */
-    void * p_texture_pixels = NULL;
-    int texture_pitch;
-    const int lock_texture_successful = SDL_LockTexture(
-      p_window_texture,
-      NULL,
-      (void **)&p_texture_pixels,
-      &texture_pitch
-    );
-
-    if (lock_texture_successful != 0)
+    if (options.zero_copy)
     {
-      fprintf(stderr, "\nSDL2 texture could not be locked - %s", SDL_GetError());
+      /* Render straight into the locked texture, whose memory layout matches the client-side pixels */
+      void * p_texture_pixels = NULL;
+      int texture_pitch;
+      const int lock_texture_successful = SDL_LockTexture(
+        p_window_texture,
+        NULL,
+        (void **)&p_texture_pixels,
+        &texture_pitch
+      );
+
+      benchmark_mark(&frame_benchmark, BENCHMARK_STAGE_LOCK);
+
+      if (lock_texture_successful != 0)
+      {
+        fprintf(stderr, "\nSDL2 texture could not be locked - %s", SDL_GetError());
+      }
+      else
+      {
+        const client_framebuffer_ts texture_framebuffer = {
+          (client_pixel_rgba_ts *)p_texture_pixels,
+          options.virtual_width,
+          options.virtual_height,
+          texture_pitch
+        };
+        render_stage_fill(p_worker_pool, &pixel_generator, &texture_framebuffer);
+        benchmark_mark(&frame_benchmark, BENCHMARK_STAGE_FILL);
+
+        /* Unlock the locked texture and upload the changes to video memory, if required */
+        SDL_UnlockTexture(p_window_texture);
+        benchmark_mark(&frame_benchmark, BENCHMARK_STAGE_UNLOCK);
+      }
     }
-
-    /*
-        Texture locked - Now copy the client-side pixel data into the texture in one go
-    */
-    uint32_t * const p_texture_pixels_rgba = (uint32_t *)p_texture_pixels;
-    for (int texel_y = 0; texel_y < WINDOW_HEIGHT_VIRTUAL; texel_y++)
+    else
     {
-      for (int texel_x = 0; texel_x < WINDOW_WIDTH_VIRTUAL; texel_x++)
+      const client_framebuffer_ts * p_frame_framebuffer = &client_framebuffer;
+      const client_framebuffer_indexed_ts * p_frame_indexed_framebuffer = &client_indexed_framebuffer;
+      if (p_frame_pipeline != NULL)
       {
         /*
+            Take the next frame the render thread completed according to the present policy.
+            The damage recorded against the frame before only applies to the texture if no frame was dropped in between,
+            and a frame presented again needs no upload at all
+        */
+        const frame_slot_ts * const p_frame_slot = frame_pipeline_acquire(p_frame_pipeline);
+        p_frame_framebuffer = &p_frame_slot->framebuffer;
+        p_frame_indexed_framebuffer = &p_frame_slot->indexed_framebuffer;
+        frame_damage = p_frame_slot->damage;
+        if (texture_requires_full_upload || !options.damage_tracking || p_frame_slot->frame_index != texture_frame_index + 1)
+          damage_add_all(&frame_damage);
+        if (!texture_requires_full_upload && p_frame_slot->frame_index == texture_frame_index)
+          damage_clear(&frame_damage);
+        texture_frame_index = p_frame_slot->frame_index;
+      }
+      else
+      {
+        /*
+            Determine the regions changed since the previous frame. Zero-copy rendering above always fills the
+            whole texture instead, because a locked texture does not necessarily hold the previous pixels
+        */
+        damage_clear(&frame_damage);
+        if (texture_requires_full_upload || !options.damage_tracking)
+        {
+          damage_add_all(&frame_damage);
+        }
+        else
+        {
+          pixel_generator_collect_damage(&pixel_generator, &frame_damage);
+        }
+
+        /* All SDL2 window events processed - Now render the changed rows into the client-side pixel or palette index buffer */
+        if (options.indexed)
+          render_stage_fill_indexed_damage(p_worker_pool, &pixel_generator, &client_indexed_framebuffer, &frame_damage);
+        else
+          render_stage_fill_damage(p_worker_pool, &pixel_generator, &client_framebuffer, &frame_damage);
+      }
+      texture_requires_full_upload = 0;
+      damaged_texels_total += (uint64_t)damage_area(&frame_damage);
+
+      /* With the pipeline, the fill stage is the time spent waiting for the render thread */
+      benchmark_mark(&frame_benchmark, BENCHMARK_STAGE_FILL);
+
+      /* Lock, convert and upload each damaged rectangle on its own, leaving the rest of the texture untouched */
+      const int upload_rect_count = options.present ? frame_damage.rect_count : 0;
+      for (int rect_index = 0; rect_index < upload_rect_count; rect_index++)
+      {
+        const SDL_Rect * const p_damaged_rect = &frame_damage.rects[rect_index];
+        if (upload_mode == UPLOAD_MODE_UPDATE)
+        {
+          /* Nothing to lock or convert - Upload the damaged client-side pixels as they are */
+          benchmark_mark(&frame_benchmark, BENCHMARK_STAGE_LOCK);
+          benchmark_mark(&frame_benchmark, BENCHMARK_STAGE_CONVERT);
+          if (render_stage_update(p_window_texture, p_frame_framebuffer, p_damaged_rect) != 0)
+          {
+            fprintf(stderr, "\nSDL2 texture could not be updated - %s", SDL_GetError());
+            texture_requires_full_upload = 1;
+            break;
+          }
+          benchmark_mark(&frame_benchmark, BENCHMARK_STAGE_UNLOCK);
+          continue;
+        }
+
+        void * p_texture_pixels = NULL;
+        int texture_pitch;
+        const int lock_texture_successful = SDL_LockTexture(
+          p_window_texture,
+          p_damaged_rect,
+          (void **)&p_texture_pixels,
+          &texture_pitch
+        );
+
+        benchmark_mark(&frame_benchmark, BENCHMARK_STAGE_LOCK);
+
+        if (lock_texture_successful != 0)
+        {
+          fprintf(stderr, "\nSDL2 texture could not be locked - %s", SDL_GetError());
+          texture_requires_full_upload = 1;
+          break;
+        }
+
+        /*
+            Texture locked - Now convert the damaged client-side pixels into the texture row by row.
+            The conversion returns once all rows are converted, which is the barrier before unlocking the texture.
+
             At this point, assume that the client-side texture has the same dimensions as the SDL2 texture
             to avoid extra work per pixel
         */
-        const int texture_texel_index = (texture_pitch / sizeof(uint32_t) * texel_y) + texel_x;
-        const int client_texel_index = (WINDOW_WIDTH_VIRTUAL * texel_y) + texel_x;
-
-        /* Convert the client pixel color based on the texture pixel format */
-        const client_pixel_rgba_ts * const p_client_pixel_color = p_client_pixels_rgba + client_texel_index;
-        const uint32_t formatted_pixel_color = SDL_MapRGB(
-          p_texture_pixel_format,
-          p_client_pixel_color->red,
-          p_client_pixel_color->green,
-          p_client_pixel_color->blue
-        );
+        if (options.indexed)
+          render_stage_expand(p_worker_pool, &texture_palette, p_texture_pixels, texture_pitch, p_frame_indexed_framebuffer, p_damaged_rect);
+        else if (upload_mode == UPLOAD_MODE_BULK)
+          render_stage_copy_bulk(p_texture_pixels, texture_pitch, p_frame_framebuffer, p_damaged_rect);
+        else if (upload_mode == UPLOAD_MODE_ROWS)
+          render_stage_copy_rows(p_texture_pixels, texture_pitch, p_frame_framebuffer, p_damaged_rect);
+        else
+          render_stage_convert(p_worker_pool, &texture_pixel_converter, p_texture_pixels, texture_pitch, p_frame_framebuffer, p_damaged_rect);
+        benchmark_mark(&frame_benchmark, BENCHMARK_STAGE_CONVERT);
+
+        /* Unlock the locked texture and upload the changes to video memory, if required */
+        SDL_UnlockTexture(p_window_texture);
+        benchmark_mark(&frame_benchmark, BENCHMARK_STAGE_UNLOCK);
+      }
+
+      /* Queue a copy of the client-side pixels for the I/O thread before their buffer may take the next frame */
+      if (p_capture != NULL && !capture_readback && (frame_index - 1) % options.capture_interval == 0)
+      {
+        capture_frame(p_capture, p_frame_framebuffer, frame_index - 1);
+        benchmark_mark(&frame_benchmark, BENCHMARK_STAGE_CAPTURE);
+      }
+
+      /*
+          Write the frame to the video stream before its buffer may take the next frame. The write blocks
+          until the reader takes the frame, so a slow encoder paces the loop and no frame is lost
+      */
+      if (p_video_stream != NULL)
+      {
+        if (video_stream_write_frame(p_video_stream, p_frame_framebuffer) != 0)
+          window_close_requested = 1;
+        benchmark_mark(&frame_benchmark, BENCHMARK_STAGE_CAPTURE);
+      }
+
+      /* The texture holds the frame now, so its client-side buffer can take the next frame */
+      if (p_frame_pipeline != NULL)
+        frame_pipeline_release(p_frame_pipeline);
+    }
+
+    /* Without presentation, the frame ends with the client-side pixels */
+    if (options.present)
+    {
+      /*
+          Clear the entire (hidden) renderer window pixel data to a single color.
+          This seems unnecessary if every pixel is overwritten every frame but the SDL2
+          documentation urges to clear the renderer before every drawing cycle anyway
+      */
+      const int render_clear_successful = SDL_RenderClear(p_renderer);
+      if (render_clear_successful != 0)
+      {
+        fprintf(stderr, "\nSDL2 Render clear failed - Error: %s", SDL_GetError());
+      }
+      benchmark_mark(&frame_benchmark, BENCHMARK_STAGE_CLEAR);
+
+      /* Copy the texture pixel data into the (hidden) renderer window surface */
+      const int render_copy_successful = SDL_RenderCopy(p_renderer, p_window_texture, NULL, NULL);
+      if (render_copy_successful != 0)
+      {
+        fprintf(stderr, "\nSDL2 Render copy failed - Error: %s", SDL_GetError());
+      }
+      benchmark_mark(&frame_benchmark, BENCHMARK_STAGE_COPY);
 
-        /* Set the texel color in the SDL2 texture */
-        p_texture_pixels_rgba[texture_texel_index] = formatted_pixel_color;
+      /* Read the renderer output back into the next free capture frame, which happens on this thread */
+      if (p_capture != NULL && capture_readback && (frame_index - 1) % options.capture_interval == 0)
+      {
+        client_framebuffer_ts * const p_capture_framebuffer = capture_begin_frame(p_capture, frame_index - 1);
+        if (p_capture_framebuffer != NULL)
+        {
+          const SDL_Rect capture_rect = { 0, 0, p_capture_framebuffer->width, p_capture_framebuffer->height };
+          if (SDL_RenderReadPixels(p_renderer, &capture_rect, SDL_PIXELFORMAT_RGBA32, p_capture_framebuffer->p_pixels, p_capture_framebuffer->pitch) == 0)
+          {
+            capture_commit_frame(p_capture);
+          }
+          else
+          {
+            fprintf(stderr, "\nSDL2 renderer pixels could not be read back - Error: %s", SDL_GetError());
+            capture_cancel_frame(p_capture);
+          }
+        }
+        benchmark_mark(&frame_benchmark, BENCHMARK_STAGE_CAPTURE);
       }
+
+      /*
+          Copy the (hidden) renderer window pixel data into the visible window surface.
+          This is similar to swapping the back and front buffers with double-buffered rendering,
+          but between different window buffer implicitly
+      */
+      SDL_RenderPresent(p_renderer);
+      benchmark_mark(&frame_benchmark, BENCHMARK_STAGE_PRESENT);
     }
+    benchmark_end_frame(&frame_benchmark);
 
-    /* Unlock the locked texture and upload the changes to video memory, if required */
-    SDL_UnlockTexture(p_window_texture);
+    /* Sleep and spin until the next frame is due, if frames are paced */
+    frame_scheduler_wait(&frame_scheduler);
+  }
 
-    /*
-        Clear the entire (hidden) renderer window pixel data to a single color.
-        This seems unnecessary if every pixel is overwritten every frame but the SDL2
-        documentation urges to clear the renderer before every drawing cycle anyway
-    */
-    const int render_clear_successful = SDL_RenderClear(p_renderer);
-    if (render_clear_successful != 0)
+  frame_scheduler_print_summary(&frame_scheduler, p_status_stream);
+
+  /* Report captures the I/O thread could not keep up with, the queued ones are still written during cleanup */
+  if (p_capture != NULL)
+  {
+    fprintf(
+      p_status_stream,
+      "Captured frames: %llu, dropped: %llu\n",
+      (unsigned long long)capture_frames_captured(p_capture),
+      (unsigned long long)capture_frames_dropped(p_capture)
+    );
+  }
+
+  if (p_video_stream != NULL)
+    fprintf(p_status_stream, "Streamed frames: %llu\n", (unsigned long long)p_video_stream->frames_written);
+
+  /* Report the benchmark results before releasing them */
+  if (options.benchmark)
+  {
+    if (!options.zero_copy && frame_index > 0)
+      benchmark_set_property(&frame_benchmark, "damaged_texels_per_frame", "%.1f", (double)damaged_texels_total / (double)frame_index);
+
+    if (options.frame_rate > 0.0)
     {
-      fprintf(stderr, "\nSDL2 Render clear failed - Error: %s", SDL_GetError());
+      benchmark_set_property(&frame_benchmark, "target_fps", "%.3f", options.frame_rate);
+      benchmark_set_property(&frame_benchmark, "pacing_mean_ms", "%.4f", frame_scheduler_interval_mean_ms(&frame_scheduler));
+      benchmark_set_property(&frame_benchmark, "pacing_jitter_ms", "%.4f", frame_scheduler_jitter_ms(&frame_scheduler));
+      benchmark_set_property(&frame_benchmark, "pacing_jitter_max_ms", "%.4f", frame_scheduler_jitter_max_ms(&frame_scheduler));
     }
 
-    /* Copy the texture pixel data into the (hidden) renderer window surface */
-    const int render_copy_successful = SDL_RenderCopy(p_renderer, p_window_texture, NULL, NULL);
-    if (render_copy_successful != 0)
+    if (p_frame_pipeline != NULL)
     {
-      fprintf(stderr, "\nSDL2 Render copy failed - Error: %s", SDL_GetError());
+      benchmark_set_property(&frame_benchmark, "frames_dropped", "%llu", (unsigned long long)frame_pipeline_frames_dropped(p_frame_pipeline));
+      benchmark_set_property(&frame_benchmark, "frames_repeated", "%llu", (unsigned long long)frame_pipeline_frames_repeated(p_frame_pipeline));
     }
 
-    /*
-        Copy the (hidden) renderer window pixel data into the visible window surface.
-        This is similar to swapping the back and front buffers with double-buffered rendering,
-        but between different window buffer implicitly
-    */
-    SDL_RenderPresent(p_renderer);
+    if (p_capture != NULL)
+    {
+      benchmark_set_property(&frame_benchmark, "capture_frames", "%llu", (unsigned long long)capture_frames_captured(p_capture));
+      benchmark_set_property(&frame_benchmark, "capture_frames_dropped", "%llu", (unsigned long long)capture_frames_dropped(p_capture));
+    }
+
+    benchmark_print_summary(&frame_benchmark, p_status_stream);
+    if (options.p_benchmark_report_path != NULL && benchmark_write_report(&frame_benchmark, options.p_benchmark_report_path) != 0)
+      cleanup(OS_FAILURE_RETURN_CODE);
   }
 
   /* Cleanup all resources */
@@ -271,9 +824,31 @@ int main(int argc, char * argv[])
 /* Function definitions */
 void cleanup(int report_status)
 {
+  /* Close the video stream, which signals the end of the video to the reader */
+  video_stream_close(p_video_stream);
+
+  /* Write the captured frames still queued and stop the I/O thread */
+  capture_destroy(p_capture);
+
+  /* Stop the render thread, which uses the worker threads */
+  frame_pipeline_destroy(p_frame_pipeline);
+
+  /* Cleanup the pattern state of the pixel generator */
+  pixel_generator_free(&pixel_generator);
+
+  /* Stop the worker threads */
+  worker_pool_destroy(p_worker_pool);
+
+  /* Cleanup benchmark samples */
+  benchmark_free(&frame_benchmark);
+
   /* Cleanup client-side pixel color buffer */
   if (p_client_pixels_rgba != NULL)
     free(p_client_pixels_rgba);
+
+  /* Cleanup client-side palette index buffer */
+  if (p_client_pixels_indexed != NULL)
+    free(p_client_pixels_indexed);
   
   /* Cleanup queried pixel formats */
   if (p_texture_pixel_format != NULL)
@@ -296,4 +871,50 @@ void cleanup(int report_status)
 
   /* Quit process and report status to the parent process */
   exit(report_status);
-}
\ No newline at end of file
+}
+
+/* Returns the index of the render driver with the given name, or -1 if SDL2 does not provide it */
+int find_render_driver(const char * p_driver_name)
+{
+  const int driver_count = SDL_GetNumRenderDrivers();
+  for (int driver_index = 0; driver_index < driver_count; driver_index++)
+  {
+    SDL_RendererInfo driver_info;
+    if (SDL_GetRenderDriverInfo(driver_index, &driver_info) == 0 && SDL_strcasecmp(driver_info.name, p_driver_name) == 0)
+      return driver_index;
+  }
+
+  return -1;
+}
+
+/* Prints every render driver with its capabilities and the conversion cost of each of its texture formats */
+void list_render_drivers(void)
+{
+  const int driver_count = SDL_GetNumRenderDrivers();
+  for (int driver_index = 0; driver_index < driver_count; driver_index++)
+  {
+    SDL_RendererInfo driver_info;
+    if (SDL_GetRenderDriverInfo(driver_index, &driver_info) != 0)
+    {
+      fprintf(stderr, "\nSDL2 render driver %d could not be queried - Error: %s", driver_index, SDL_GetError());
+      continue;
+    }
+
+    printf("%s%s%s%s%s\n",
+      driver_info.name,
+      (driver_info.flags & SDL_RENDERER_SOFTWARE) ? " software" : "",
+      (driver_info.flags & SDL_RENDERER_ACCELERATED) ? " accelerated" : "",
+      (driver_info.flags & SDL_RENDERER_PRESENTVSYNC) ? " vsync" : "",
+      (driver_info.flags & SDL_RENDERER_TARGETTEXTURE) ? " target-texture" : "");
+
+    for (uint32_t format_index = 0; format_index < driver_info.num_texture_formats; format_index++)
+    {
+      const uint32_t texture_format = driver_info.texture_formats[format_index];
+      const int conversion_cost = pixel_format_conversion_cost(texture_format);
+      if (conversion_cost < 0)
+        printf("  %s unsupported\n", SDL_GetPixelFormatName(texture_format));
+      else
+        printf("  %s cost %d\n", SDL_GetPixelFormatName(texture_format), conversion_cost);
+    }
+  }
+}
@@ -0,0 +1,495 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "options.h"
+#include "worker_pool.h"
+
+/* Constants */
+static const int DEFAULT_WINDOW_WIDTH = 800;
+static const int DEFAULT_WINDOW_HEIGHT = 600;
+static const int DEFAULT_WINDOW_WIDTH_VIRTUAL = 160;
+static const int DEFAULT_WINDOW_HEIGHT_VIRTUAL = 144;
+static const long MAX_SIZE_DIMENSION = 16384;
+static const uint64_t DEFAULT_BENCHMARK_FRAMES = 1000;
+
+/* Returns the value following the option at the given index, or NULL when the value is missing */
+static const char * option_value(int argc, char * argv[], int * p_arg_index)
+{
+  if (*p_arg_index + 1 >= argc)
+  {
+    fprintf(stderr, "\nCommand-line option '%s' requires a value", argv[*p_arg_index]);
+    return NULL;
+  }
+
+  (*p_arg_index)++;
+  return argv[*p_arg_index];
+}
+
+/* Parses an unsigned decimal or 0x-prefixed hexadecimal value no larger than the given maximum */
+static int option_parse_unsigned(const char * p_value, unsigned long long maximum, unsigned long long * p_result)
+{
+  char * p_value_end = NULL;
+  const unsigned long long parsed_value = strtoull(p_value, &p_value_end, 0);
+  if (p_value_end == p_value || *p_value_end != '\0' || *p_value == '-' || parsed_value > maximum)
+  {
+    fprintf(stderr, "\nInvalid unsigned value '%s'", p_value);
+    return -1;
+  }
+
+  *p_result = parsed_value;
+  return 0;
+}
+
+static int option_parse_uint32(const char * p_value, uint32_t * p_result)
+{
+  unsigned long long parsed_value;
+  if (option_parse_unsigned(p_value, UINT32_MAX, &parsed_value) != 0)
+    return -1;
+
+  *p_result = (uint32_t)parsed_value;
+  return 0;
+}
+
+static int option_parse_uint64(const char * p_value, uint64_t * p_result)
+{
+  unsigned long long parsed_value;
+  if (option_parse_unsigned(p_value, UINT64_MAX, &parsed_value) != 0)
+    return -1;
+
+  *p_result = (uint64_t)parsed_value;
+  return 0;
+}
+
+/* Parses a size given as <width>x<height>, for example 3840x2160 */
+static int option_parse_size(const char * p_value, int * p_width, int * p_height)
+{
+  char * p_width_end = NULL;
+  char * p_height_end = NULL;
+  const long width = strtol(p_value, &p_width_end, 10);
+  const long height = (*p_width_end == 'x') ? strtol(p_width_end + 1, &p_height_end, 10) : 0;
+  if (p_height_end == NULL || p_height_end == p_width_end + 1 || *p_height_end != '\0' ||
+      width < 1 || height < 1 || width > MAX_SIZE_DIMENSION || height > MAX_SIZE_DIMENSION)
+  {
+    fprintf(stderr, "\nInvalid size '%s', expected <width>x<height> with dimensions from 1 to %ld", p_value, MAX_SIZE_DIMENSION);
+    return -1;
+  }
+
+  *p_width = (int)width;
+  *p_height = (int)height;
+  return 0;
+}
+
+/* Parses a positive duration in seconds */
+static int option_parse_seconds(const char * p_value, double * p_result)
+{
+  char * p_value_end = NULL;
+  const double parsed_value = strtod(p_value, &p_value_end);
+  if (p_value_end == p_value || *p_value_end != '\0' || !(parsed_value > 0.0))
+  {
+    fprintf(stderr, "\nInvalid duration in seconds '%s'", p_value);
+    return -1;
+  }
+
+  *p_result = parsed_value;
+  return 0;
+}
+
+static int option_parse_rate(const char * p_value, double * p_result)
+{
+  char * p_value_end = NULL;
+  const double parsed_value = strtod(p_value, &p_value_end);
+  if (p_value_end == p_value || *p_value_end != '\0' || !(parsed_value > 0.0))
+  {
+    fprintf(stderr, "\nInvalid rate per second '%s'", p_value);
+    return -1;
+  }
+
+  *p_result = parsed_value;
+  return 0;
+}
+
+/* Function definitions */
+int options_parse(program_options_ts * p_options, int argc, char * argv[])
+{
+  /* Defaults reproduce the plain windowed rendering loop */
+  p_options->show_help = 0;
+  p_options->window_width = DEFAULT_WINDOW_WIDTH;
+  p_options->window_height = DEFAULT_WINDOW_HEIGHT;
+  p_options->virtual_width = DEFAULT_WINDOW_WIDTH_VIRTUAL;
+  p_options->virtual_height = DEFAULT_WINDOW_HEIGHT_VIRTUAL;
+  p_options->verify_conversion = 0;
+  p_options->verify_generators = 0;
+  p_options->verify_rendering = 0;
+  p_options->list_renderers = 0;
+  p_options->p_renderer_name = NULL;
+  p_options->vsync = 0;
+  p_options->upload_mode = UPLOAD_MODE_AUTO;
+  p_options->zero_copy = 0;
+  p_options->damage_tracking = 1;
+  p_options->indexed = 0;
+  p_options->p_palette_name = "grey";
+  p_options->pipeline = 0;
+  p_options->buffer_count = DEFAULT_PIPELINE_BUFFERS;
+  p_options->present_policy = FRAME_PRESENT_POLICY_FIFO;
+  p_options->headless = 0;
+  p_options->thread_count = 1;
+  p_options->frame_limit = 0;
+  p_options->seconds_limit = 0.0;
+  p_options->frame_rate = 0.0;
+  p_options->step_rate = 0.0;
+  p_options->benchmark = 0;
+  p_options->benchmark_warmup_frames = 0;
+  p_options->p_benchmark_report_path = NULL;
+  p_options->convert_kernel_forced = 0;
+  p_options->convert_kernel = PIXEL_KERNEL_SCALAR;
+  p_options->p_pattern_name = "noise";
+  p_options->seed = 0;
+  p_options->p_capture_path = NULL;
+  p_options->capture_interval = 1;
+  p_options->capture_queue_length = DEFAULT_CAPTURE_QUEUE_LENGTH;
+  p_options->capture_readback = 0;
+  p_options->p_video_path = NULL;
+  p_options->present = 1;
+
+  for (int arg_index = 1; arg_index < argc; arg_index++)
+  {
+    const char * const p_argument = argv[arg_index];
+
+    if (strcmp(p_argument, "--help") == 0)
+    {
+      p_options->show_help = 1;
+    }
+    else if (strcmp(p_argument, "--window-size") == 0)
+    {
+      const char * const p_value = option_value(argc, argv, &arg_index);
+      if (p_value == NULL || option_parse_size(p_value, &p_options->window_width, &p_options->window_height) != 0)
+        return -1;
+    }
+    else if (strcmp(p_argument, "--virtual-size") == 0)
+    {
+      const char * const p_value = option_value(argc, argv, &arg_index);
+      if (p_value == NULL || option_parse_size(p_value, &p_options->virtual_width, &p_options->virtual_height) != 0)
+        return -1;
+    }
+    else if (strcmp(p_argument, "--verify-conversion") == 0)
+    {
+      p_options->verify_conversion = 1;
+    }
+    else if (strcmp(p_argument, "--verify-generators") == 0)
+    {
+      p_options->verify_generators = 1;
+    }
+    else if (strcmp(p_argument, "--verify-rendering") == 0)
+    {
+      p_options->verify_rendering = 1;
+    }
+    else if (strcmp(p_argument, "--list-renderers") == 0)
+    {
+      p_options->list_renderers = 1;
+    }
+    else if (strcmp(p_argument, "--renderer") == 0)
+    {
+      p_options->p_renderer_name = option_value(argc, argv, &arg_index);
+      if (p_options->p_renderer_name == NULL)
+        return -1;
+    }
+    else if (strcmp(p_argument, "--vsync") == 0)
+    {
+      p_options->vsync = 1;
+    }
+    else if (strcmp(p_argument, "--upload") == 0)
+    {
+      const char * const p_value = option_value(argc, argv, &arg_index);
+      if (p_value == NULL)
+        return -1;
+
+      if (upload_mode_from_name(p_value, &p_options->upload_mode) != 0)
+      {
+        fprintf(stderr, "\nUnknown upload mode '%s'", p_value);
+        return -1;
+      }
+    }
+    else if (strcmp(p_argument, "--zero-copy") == 0)
+    {
+      p_options->zero_copy = 1;
+    }
+    else if (strcmp(p_argument, "--no-damage") == 0)
+    {
+      p_options->damage_tracking = 0;
+    }
+    else if (strcmp(p_argument, "--indexed") == 0)
+    {
+      p_options->indexed = 1;
+    }
+    else if (strcmp(p_argument, "--palette") == 0)
+    {
+      p_options->p_palette_name = option_value(argc, argv, &arg_index);
+      if (p_options->p_palette_name == NULL)
+        return -1;
+      p_options->indexed = 1;
+    }
+    else if (strcmp(p_argument, "--pipeline") == 0)
+    {
+      p_options->pipeline = 1;
+    }
+    else if (strcmp(p_argument, "--buffers") == 0)
+    {
+      uint32_t buffer_count;
+      const char * const p_value = option_value(argc, argv, &arg_index);
+      if (p_value == NULL || option_parse_uint32(p_value, &buffer_count) != 0)
+        return -1;
+
+      if (buffer_count < FRAME_PIPELINE_MIN_BUFFERS || buffer_count > FRAME_PIPELINE_MAX_BUFFERS)
+      {
+        fprintf(stderr, "\nBetween %d and %d client-side buffers are supported", FRAME_PIPELINE_MIN_BUFFERS, FRAME_PIPELINE_MAX_BUFFERS);
+        return -1;
+      }
+      p_options->buffer_count = (int)buffer_count;
+      p_options->pipeline = 1;
+    }
+    else if (strcmp(p_argument, "--present-policy") == 0)
+    {
+      const char * const p_value = option_value(argc, argv, &arg_index);
+      if (p_value == NULL)
+        return -1;
+
+      if (frame_present_policy_from_name(p_value, &p_options->present_policy) != 0)
+      {
+        fprintf(stderr, "\nUnknown present policy '%s'", p_value);
+        return -1;
+      }
+      p_options->pipeline = 1;
+    }
+    else if (strcmp(p_argument, "--headless") == 0)
+    {
+      p_options->headless = 1;
+    }
+    else if (strcmp(p_argument, "--threads") == 0)
+    {
+      uint32_t thread_count;
+      const char * const p_value = option_value(argc, argv, &arg_index);
+      if (p_value == NULL || option_parse_uint32(p_value, &thread_count) != 0)
+        return -1;
+
+      if (thread_count > WORKER_POOL_MAX_THREADS)
+      {
+        fprintf(stderr, "\nAt most %d threads are supported", WORKER_POOL_MAX_THREADS);
+        return -1;
+      }
+      p_options->thread_count = (int)thread_count;
+    }
+    else if (strcmp(p_argument, "--frames") == 0)
+    {
+      const char * const p_value = option_value(argc, argv, &arg_index);
+      if (p_value == NULL || option_parse_uint64(p_value, &p_options->frame_limit) != 0)
+        return -1;
+    }
+    else if (strcmp(p_argument, "--seconds") == 0)
+    {
+      const char * const p_value = option_value(argc, argv, &arg_index);
+      if (p_value == NULL || option_parse_seconds(p_value, &p_options->seconds_limit) != 0)
+        return -1;
+    }
+    else if (strcmp(p_argument, "--fps") == 0)
+    {
+      const char * const p_value = option_value(argc, argv, &arg_index);
+      if (p_value == NULL || option_parse_rate(p_value, &p_options->frame_rate) != 0)
+        return -1;
+    }
+    else if (strcmp(p_argument, "--timestep") == 0)
+    {
+      const char * const p_value = option_value(argc, argv, &arg_index);
+      if (p_value == NULL || option_parse_rate(p_value, &p_options->step_rate) != 0)
+        return -1;
+    }
+    else if (strcmp(p_argument, "--benchmark") == 0)
+    {
+      p_options->benchmark = 1;
+    }
+    else if (strcmp(p_argument, "--warmup") == 0)
+    {
+      const char * const p_value = option_value(argc, argv, &arg_index);
+      if (p_value == NULL || option_parse_uint64(p_value, &p_options->benchmark_warmup_frames) != 0)
+        return -1;
+    }
+    else if (strcmp(p_argument, "--benchmark-report") == 0)
+    {
+      p_options->benchmark = 1;
+      p_options->p_benchmark_report_path = option_value(argc, argv, &arg_index);
+      if (p_options->p_benchmark_report_path == NULL)
+        return -1;
+    }
+    else if (strcmp(p_argument, "--convert-kernel") == 0)
+    {
+      const char * const p_value = option_value(argc, argv, &arg_index);
+      if (p_value == NULL)
+        return -1;
+
+      if (pixel_kernel_from_name(p_value, &p_options->convert_kernel) != 0)
+      {
+        fprintf(stderr, "\nUnknown pixel conversion kernel '%s'", p_value);
+        return -1;
+      }
+      p_options->convert_kernel_forced = 1;
+    }
+    else if (strcmp(p_argument, "--pattern") == 0)
+    {
+      p_options->p_pattern_name = option_value(argc, argv, &arg_index);
+      if (p_options->p_pattern_name == NULL)
+        return -1;
+    }
+    else if (strcmp(p_argument, "--seed") == 0)
+    {
+      const char * const p_value = option_value(argc, argv, &arg_index);
+      if (p_value == NULL || option_parse_uint32(p_value, &p_options->seed) != 0)
+        return -1;
+    }
+    else if (strcmp(p_argument, "--capture") == 0)
+    {
+      p_options->p_capture_path = option_value(argc, argv, &arg_index);
+      if (p_options->p_capture_path == NULL)
+        return -1;
+    }
+    else if (strcmp(p_argument, "--capture-every") == 0)
+    {
+      const char * const p_value = option_value(argc, argv, &arg_index);
+      if (p_value == NULL || option_parse_uint64(p_value, &p_options->capture_interval) != 0)
+        return -1;
+
+      if (p_options->capture_interval == 0)
+      {
+        fprintf(stderr, "\nThe capture interval must be at least one frame");
+        return -1;
+      }
+    }
+    else if (strcmp(p_argument, "--capture-queue") == 0)
+    {
+      uint32_t capture_queue_length;
+      const char * const p_value = option_value(argc, argv, &arg_index);
+      if (p_value == NULL || option_parse_uint32(p_value, &capture_queue_length) != 0)
+        return -1;
+
+      if (capture_queue_length < CAPTURE_MIN_QUEUE_LENGTH || capture_queue_length > CAPTURE_MAX_QUEUE_LENGTH)
+      {
+        fprintf(stderr, "\nBetween %d and %d queued capture frames are supported", CAPTURE_MIN_QUEUE_LENGTH, CAPTURE_MAX_QUEUE_LENGTH);
+        return -1;
+      }
+      p_options->capture_queue_length = (int)capture_queue_length;
+    }
+    else if (strcmp(p_argument, "--capture-readback") == 0)
+    {
+      p_options->capture_readback = 1;
+    }
+    else if (strcmp(p_argument, "--video-out") == 0)
+    {
+      p_options->p_video_path = option_value(argc, argv, &arg_index);
+      if (p_options->p_video_path == NULL)
+        return -1;
+    }
+    else if (strcmp(p_argument, "--no-present") == 0)
+    {
+      p_options->present = 0;
+      p_options->headless = 1;
+    }
+    else
+    {
+      fprintf(stderr, "\nUnknown command-line option '%s'", p_argument);
+      return -1;
+    }
+  }
+
+  /* Indexed rendering expands palette indices into the texture, which leaves no client-side pixels to render in place */
+  if (p_options->indexed && p_options->zero_copy)
+  {
+    fprintf(stderr, "\nIndexed rendering cannot be combined with zero-copy rendering");
+    return -1;
+  }
+
+  /* Zero-copy rendering has nothing left to upload, and palette indices always need the palette expansion */
+  if ((p_options->zero_copy || p_options->indexed) && p_options->upload_mode != UPLOAD_MODE_AUTO && p_options->upload_mode != UPLOAD_MODE_CONVERT)
+  {
+    fprintf(stderr, "\nThe %s upload mode cannot be combined with %s rendering", upload_mode_name(p_options->upload_mode), p_options->zero_copy ? "zero-copy" : "indexed");
+    return -1;
+  }
+
+  /* The render thread fills client-side buffers, while only the presenting thread may lock the texture */
+  if (p_options->pipeline && p_options->zero_copy)
+  {
+    fprintf(stderr, "\nPipelined rendering cannot be combined with zero-copy rendering");
+    return -1;
+  }
+
+  /* The render thread of the pipeline renders consecutive frames, independently of the time the main thread measures */
+  if (p_options->pipeline && p_options->step_rate > 0.0)
+  {
+    fprintf(stderr, "\nFixed simulation steps cannot be combined with pipelined rendering");
+    return -1;
+  }
+
+  /* The mailbox needs a slot for presenting, one for the mailbox and one for rendering */
+  if (p_options->present_policy == FRAME_PRESENT_POLICY_MAILBOX && p_options->buffer_count < FRAME_PIPELINE_MIN_MAILBOX_BUFFERS)
+  {
+    fprintf(stderr, "\nThe mailbox present policy needs at least %d client-side buffers", FRAME_PIPELINE_MIN_MAILBOX_BUFFERS);
+    return -1;
+  }
+
+  /* The video stream and skipped presentation rely on the client-side RGBA pixels, which only the texture holds otherwise */
+  if ((p_options->p_video_path != NULL || !p_options->present) && (p_options->zero_copy || p_options->indexed))
+  {
+    fprintf(stderr, "\n%s cannot be combined with %s rendering", p_options->present ? "Video output" : "Skipping presentation", p_options->zero_copy ? "zero-copy" : "indexed");
+    return -1;
+  }
+
+  /* Without presentation there is no renderer output to read back */
+  if (!p_options->present && p_options->capture_readback)
+  {
+    fprintf(stderr, "\nSkipping presentation cannot be combined with capturing the renderer output");
+    return -1;
+  }
+
+  /* Benchmarks without any limit would never report, so limit them to a default number of frames */
+  if (p_options->benchmark && p_options->frame_limit == 0 && p_options->seconds_limit == 0.0)
+    p_options->frame_limit = DEFAULT_BENCHMARK_FRAMES;
+
+  return 0;
+}
+
+void options_print_usage(FILE * p_stream, const char * p_program_name)
+{
+  fprintf(p_stream, "Usage: %s [options]\n", p_program_name);
+  fprintf(p_stream, "  --help                      Show this help and exit\n");
+  fprintf(p_stream, "  --window-size <w>x<h>       Window size in pixels (default %dx%d)\n", DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT);
+  fprintf(p_stream, "  --virtual-size <w>x<h>      Virtual resolution rendered by the client (default %dx%d)\n", DEFAULT_WINDOW_WIDTH_VIRTUAL, DEFAULT_WINDOW_HEIGHT_VIRTUAL);
+  fprintf(p_stream, "  --verify-conversion         Verify every pixel conversion, palette and blend kernel and exit\n");
+  fprintf(p_stream, "  --verify-generators         Verify every pixel generator kernel against the scalar noise and exit\n");
+  fprintf(p_stream, "  --verify-rendering          Verify the raster primitives, sprite blits and tilemaps against per-pixel references and exit\n");
+  fprintf(p_stream, "  --list-renderers            List the render drivers with their texture formats and exit\n");
+  fprintf(p_stream, "  --renderer <name>           Render driver to use, such as software, opengl, opengles2 or direct3d\n");
+  fprintf(p_stream, "  --vsync                     Synchronize presenting with the display refresh\n");
+  fprintf(p_stream, "  --upload <mode>             Texture upload: auto (default), convert, bulk, rows or update\n");
+  fprintf(p_stream, "  --zero-copy                 Render straight into the locked texture without a client-side pixel buffer\n");
+  fprintf(p_stream, "  --indexed                   Render palette indices and expand them into the texture through the palette\n");
+  fprintf(p_stream, "  --palette <name>            Palette of indexed rendering: grey (default), dmg or heat, P cycles them\n");
+  fprintf(p_stream, "  --pipeline                  Render on a separate thread while the main thread converts and presents\n");
+  fprintf(p_stream, "  --buffers <count>           Client-side buffers of the pipeline, %d to %d (default %d)\n", FRAME_PIPELINE_MIN_BUFFERS, FRAME_PIPELINE_MAX_BUFFERS, DEFAULT_PIPELINE_BUFFERS);
+  fprintf(p_stream, "  --present-policy <name>     Pipeline presentation: fifo presents every frame (default), mailbox the newest\n");
+  fprintf(p_stream, "  --no-damage                 Convert and upload the whole texture every frame instead of the changed regions\n");
+  fprintf(p_stream, "  --headless                  Render offscreen with the software renderer, without display or GPU\n");
+  fprintf(p_stream, "  --threads <count>           Threads filling and converting row bands, 0 for one per CPU (default 1)\n");
+  fprintf(p_stream, "  --frames <count>            Quit after rendering the given number of frames\n");
+  fprintf(p_stream, "  --seconds <duration>        Quit after running for the given number of seconds\n");
+  fprintf(p_stream, "  --fps <rate>                Pace frames to the given rate instead of running unthrottled\n");
+  fprintf(p_stream, "  --timestep <rate>           Advance the pattern in fixed steps per second instead of one step per frame\n");
+  fprintf(p_stream, "  --benchmark                 Record per-stage frame timings and print percentiles on exit (default %llu frames)\n", (unsigned long long)DEFAULT_BENCHMARK_FRAMES);
+  fprintf(p_stream, "  --warmup <count>            Number of initial frames the benchmark does not record\n");
+  fprintf(p_stream, "  --benchmark-report <path>   Benchmark and write the report as CSV for *.csv paths, JSON otherwise\n");
+  fprintf(p_stream, "  --convert-kernel <name>     Force the conversion kernel: scalar, sse2, avx2 or neon\n");
+  fprintf(p_stream, "  --pattern <name>            Pixel generator pattern: noise (default), gradient, sprites or tilemap\n");
+  fprintf(p_stream, "  --seed <value>              Seed of the pixel generator, frames are deterministic per seed\n");
+  fprintf(p_stream, "  --capture <path>            Capture frames on a background thread, as numbered *.png or *.ppm files or one raw RGBA stream\n");
+  fprintf(p_stream, "  --capture-every <count>     Capture every given frame only (default 1)\n");
+  fprintf(p_stream, "  --capture-queue <count>     Captured frames waiting to be written, %d to %d, further frames are dropped (default %d)\n", CAPTURE_MIN_QUEUE_LENGTH, CAPTURE_MAX_QUEUE_LENGTH, DEFAULT_CAPTURE_QUEUE_LENGTH);
+  fprintf(p_stream, "  --capture-readback          Capture the presented renderer output instead of the client-side pixels\n");
+  fprintf(p_stream, "  --video-out <path>          Stream every frame as raw RGBA video to a file or named pipe, - for the standard output\n");
+  fprintf(p_stream, "  --no-present                Skip the window, renderer and texture and only render client-side frames, implies --headless\n");
+}
@@ -0,0 +1,61 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "pixel_convert.h"
+#include "frame_pipeline.h"
+#include "render_stages.h"
+#include "capture.h"
+
+/* Defines */
+#define DEFAULT_PIPELINE_BUFFERS (3)
+#define DEFAULT_CAPTURE_QUEUE_LENGTH (4)
+
+/* Datatypes */
+typedef struct {
+  int show_help;
+  int window_width;
+  int window_height;
+  int virtual_width;
+  int virtual_height;
+  int verify_conversion;
+  int verify_generators;
+  int verify_rendering;
+  int list_renderers;
+  const char * p_renderer_name;
+  int vsync;
+  upload_mode_te upload_mode;
+  int zero_copy;
+  int damage_tracking;
+  int indexed;
+  const char * p_palette_name;
+  int pipeline;
+  int buffer_count;
+  frame_present_policy_te present_policy;
+  int headless;
+  int thread_count;
+  uint64_t frame_limit;
+  double seconds_limit;
+  double frame_rate;
+  double step_rate;
+  int benchmark;
+  uint64_t benchmark_warmup_frames;
+  const char * p_benchmark_report_path;
+  int convert_kernel_forced;
+  pixel_kernel_te convert_kernel;
+  const char * p_pattern_name;
+  uint32_t seed;
+  const char * p_capture_path;
+  uint64_t capture_interval;
+  int capture_queue_length;
+  int capture_readback;
+  const char * p_video_path;
+  int present;
+} program_options_ts;
+
+/* Function prototypes */
+int options_parse(program_options_ts * p_options, int argc, char * argv[]);
+void options_print_usage(FILE * p_stream, const char * p_program_name);
+
+#endif
@@ -0,0 +1,279 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <SDL.h>
+#include "palette.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PALETTE_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+/* Constants */
+static const char * const PALETTE_PRESET_NAMES[] = { "grey", "dmg", "heat" };
+
+/*
+    Palette presets.
+
+    The grey ramp maps every index to the same intensity, so indexed patterns match their RGBA
+    counterparts. The dmg preset repeats the four shades of the original handheld display for
+    2-bit indices, and heat ramps from black through red and yellow to white
+*/
+static void palette_preset_colors(int preset, client_pixel_rgba_ts * p_colors)
+{
+  static const client_pixel_rgba_ts DMG_SHADES[4] = {
+    { 0x9B, 0xBC, 0x0F, 0xFF },
+    { 0x8B, 0xAC, 0x0F, 0xFF },
+    { 0x30, 0x62, 0x30, 0xFF },
+    { 0x0F, 0x38, 0x0F, 0xFF }
+  };
+
+  for (int index = 0; index < PALETTE_SIZE; index++)
+  {
+    client_pixel_rgba_ts color = { (uint8_t)index, (uint8_t)index, (uint8_t)index, 0xFF };
+    if (preset == 1)
+    {
+      color = DMG_SHADES[index & 0x3];
+    }
+    else if (preset == 2)
+    {
+      color.red = (uint8_t)SDL_min(index * 3, 0xFF);
+      color.green = (uint8_t)SDL_max(0, SDL_min((index - 85) * 3, 0xFF));
+      color.blue = (uint8_t)SDL_max(0, SDL_min((index - 170) * 3, 0xFF));
+    }
+    p_colors[index] = color;
+  }
+}
+
+static int palette_preset_from_name(const char * p_preset_name)
+{
+  for (size_t preset = 0; preset < SDL_arraysize(PALETTE_PRESET_NAMES); preset++)
+  {
+    if (SDL_strcmp(p_preset_name, PALETTE_PRESET_NAMES[preset]) == 0)
+      return (int)preset;
+  }
+  return -1;
+}
+
+/* Scalar expanders - A plain table lookup per texel, specialized for the common texel sizes */
+static void expand_row_texels32(const palette_ts * p_palette, void * p_texel_row, const uint8_t * p_index_row, int texel_count)
+{
+  uint32_t * const p_texels = (uint32_t *)p_texel_row;
+  for (int texel_x = 0; texel_x < texel_count; texel_x++)
+  {
+    p_texels[texel_x] = p_palette->lookup.texels32[p_index_row[texel_x]];
+  }
+}
+
+static void expand_row_texels16(const palette_ts * p_palette, void * p_texel_row, const uint8_t * p_index_row, int texel_count)
+{
+  uint16_t * const p_texels = (uint16_t *)p_texel_row;
+  for (int texel_x = 0; texel_x < texel_count; texel_x++)
+  {
+    p_texels[texel_x] = p_palette->lookup.texels16[p_index_row[texel_x]];
+  }
+}
+
+static void expand_row_generic(const palette_ts * p_palette, void * p_texel_row, const uint8_t * p_index_row, int texel_count)
+{
+  const size_t texel_size = (size_t)p_palette->texel_size;
+  uint8_t * p_texel = (uint8_t *)p_texel_row;
+  for (int texel_x = 0; texel_x < texel_count; texel_x++)
+  {
+    SDL_memcpy(p_texel, &p_palette->lookup.texel_bytes[texel_size * p_index_row[texel_x]], texel_size);
+    p_texel += texel_size;
+  }
+}
+
+#ifdef PALETTE_X86_KERNELS
+/* AVX2 kernel - Widens 8 indices to 32-bit lanes and gathers their texels from the table in one instruction */
+__attribute__((target("avx2")))
+static void expand_row_texels32_avx2(const palette_ts * p_palette, void * p_texel_row, const uint8_t * p_index_row, int texel_count)
+{
+  const int * const p_lookup = (const int *)p_palette->lookup.texels32;
+  uint32_t * const p_texels = (uint32_t *)p_texel_row;
+  int texel_x = 0;
+  for (; texel_x + 16 <= texel_count; texel_x += 16)
+  {
+    const __m128i indices = _mm_loadu_si128((const __m128i *)(p_index_row + texel_x));
+    const __m256i texels_first = _mm256_i32gather_epi32(p_lookup, _mm256_cvtepu8_epi32(indices), 4);
+    const __m256i texels_second = _mm256_i32gather_epi32(p_lookup, _mm256_cvtepu8_epi32(_mm_srli_si128(indices, 8)), 4);
+    _mm256_storeu_si256((__m256i *)(p_texels + texel_x), texels_first);
+    _mm256_storeu_si256((__m256i *)(p_texels + texel_x + 8), texels_second);
+  }
+  for (; texel_x + 8 <= texel_count; texel_x += 8)
+  {
+    const __m128i indices = _mm_loadl_epi64((const __m128i *)(p_index_row + texel_x));
+    _mm256_storeu_si256((__m256i *)(p_texels + texel_x), _mm256_i32gather_epi32(p_lookup, _mm256_cvtepu8_epi32(indices), 4));
+  }
+  expand_row_texels32(p_palette, p_texels + texel_x, p_index_row + texel_x, texel_count - texel_x);
+}
+#endif
+
+/* Function definitions */
+int palette_init(palette_ts * p_palette, const pixel_converter_ts * p_converter, const char * p_preset_name)
+{
+  /* Dispatch to the widest kernel the CPU supports, the scalar kernel supports all texel sizes */
+  const pixel_kernel_te kernel_preference[] = { PIXEL_KERNEL_AVX2, PIXEL_KERNEL_SCALAR };
+  for (size_t kernel_index = 0; kernel_index < SDL_arraysize(kernel_preference); kernel_index++)
+  {
+    if (palette_init_kernel(p_palette, p_converter, p_preset_name, kernel_preference[kernel_index]) == 0)
+      return 0;
+  }
+  return -1;
+}
+
+int palette_init_kernel(palette_ts * p_palette, const pixel_converter_ts * p_converter, const char * p_preset_name, pixel_kernel_te kernel)
+{
+  if (!pixel_kernel_available(kernel))
+    return -1;
+
+  p_palette->kernel = kernel;
+  p_palette->expand_row = NULL;
+  p_palette->texel_size = p_converter->p_pixel_format->BytesPerPixel;
+
+  switch (kernel)
+  {
+    case PIXEL_KERNEL_SCALAR:
+      if (p_palette->texel_size == 4)
+        p_palette->expand_row = expand_row_texels32;
+      else if (p_palette->texel_size == 2)
+        p_palette->expand_row = expand_row_texels16;
+      else
+        p_palette->expand_row = expand_row_generic;
+      break;
+#ifdef PALETTE_X86_KERNELS
+    case PIXEL_KERNEL_AVX2:
+      if (p_palette->texel_size == 4)
+        p_palette->expand_row = expand_row_texels32_avx2;
+      break;
+#endif
+    default:
+      break;
+  }
+
+  if (p_palette->expand_row == NULL)
+    return -1;
+
+  return palette_load_preset(p_palette, p_converter, p_preset_name);
+}
+
+int palette_load_preset(palette_ts * p_palette, const pixel_converter_ts * p_converter, const char * p_preset_name)
+{
+  const int preset = palette_preset_from_name(p_preset_name);
+  if (preset < 0)
+    return -1;
+
+  client_pixel_rgba_ts preset_colors[PALETTE_SIZE];
+  palette_preset_colors(preset, preset_colors);
+  palette_set_colors(p_palette, p_converter, preset_colors);
+  p_palette->p_name = PALETTE_PRESET_NAMES[preset];
+  return 0;
+}
+
+/*
+    Replaces every palette color and converts them into texels once, which makes the expansion
+    a plain table lookup and a palette swap as cheap as converting PALETTE_SIZE pixels
+*/
+void palette_set_colors(palette_ts * p_palette, const pixel_converter_ts * p_converter, const client_pixel_rgba_ts * p_colors)
+{
+  SDL_memcpy(p_palette->colors, p_colors, sizeof(p_palette->colors));
+  p_converter->convert_row(p_converter, p_palette->lookup.texel_bytes, p_palette->colors, PALETTE_SIZE);
+  p_palette->p_name = "custom";
+}
+
+/* Returns the preset following the given one, wrapping around after the last preset */
+const char * palette_next_preset_name(const char * p_preset_name)
+{
+  const int preset = palette_preset_from_name(p_preset_name);
+  return PALETTE_PRESET_NAMES[(size_t)(preset + 1) % SDL_arraysize(PALETTE_PRESET_NAMES)];
+}
+
+/*
+    Compares the expansion of every kernel available on this CPU against looking up each palette color
+    through SDL_MapRGB, for a range of row lengths that exercise the vector loop tails.
+    Returns the number of failed kernel and format combinations
+*/
+int palette_verify_kernels(void)
+{
+  const uint32_t verified_pixel_formats[] = { SDL_PIXELFORMAT_RGBA8888, SDL_PIXELFORMAT_ARGB8888, SDL_PIXELFORMAT_RGB565, SDL_PIXELFORMAT_RGB24 };
+  enum { VERIFY_ROW_LENGTH_MAX = 131 };
+  static uint8_t index_row[VERIFY_ROW_LENGTH_MAX];
+  static uint32_t texel_row[VERIFY_ROW_LENGTH_MAX + 1];
+  static uint32_t reference_texel_row[VERIFY_ROW_LENGTH_MAX + 1];
+  static palette_ts palette;
+
+  /* Deterministic pseudo-random palette colors and indices */
+  client_pixel_rgba_ts palette_colors[PALETTE_SIZE];
+  uint32_t random_state = 0x9E3779B9u;
+  for (int index = 0; index < PALETTE_SIZE; index++)
+  {
+    random_state = (random_state * 1664525u) + 1013904223u;
+    palette_colors[index].red = (uint8_t)(random_state >> 24);
+    palette_colors[index].green = (uint8_t)(random_state >> 16);
+    palette_colors[index].blue = (uint8_t)(random_state >> 8);
+    palette_colors[index].alpha = (uint8_t)random_state;
+  }
+  for (int texel_x = 0; texel_x < VERIFY_ROW_LENGTH_MAX; texel_x++)
+  {
+    random_state = (random_state * 1664525u) + 1013904223u;
+    index_row[texel_x] = (uint8_t)(random_state >> 24);
+  }
+
+  int failures = 0;
+  for (size_t format_index = 0; format_index < SDL_arraysize(verified_pixel_formats); format_index++)
+  {
+    SDL_PixelFormat * const p_pixel_format = SDL_AllocFormat(verified_pixel_formats[format_index]);
+    if (p_pixel_format == NULL)
+    {
+      fprintf(stderr, "\nPixel format %s could not be allocated - Error: %s", SDL_GetPixelFormatName(verified_pixel_formats[format_index]), SDL_GetError());
+      failures++;
+      continue;
+    }
+    const size_t texel_size = p_pixel_format->BytesPerPixel;
+
+    pixel_converter_ts converter;
+    pixel_converter_init(&converter, p_pixel_format);
+
+    for (int kernel = 0; kernel < PIXEL_KERNEL_COUNT; kernel++)
+    {
+      if (palette_init_kernel(&palette, &converter, "grey", (pixel_kernel_te)kernel) != 0)
+        continue;
+      palette_set_colors(&palette, &converter, palette_colors);
+
+      int kernel_passed = 1;
+      for (int row_length = 0; row_length <= VERIFY_ROW_LENGTH_MAX && kernel_passed; row_length++)
+      {
+        /* Build the reference row through SDL2 and poison the expanded row, including one texel past its end */
+        uint8_t * p_reference_texel = (uint8_t *)reference_texel_row;
+        for (int texel_x = 0; texel_x < row_length; texel_x++)
+        {
+          const client_pixel_rgba_ts color = palette_colors[index_row[texel_x]];
+          const uint32_t reference_color = SDL_MapRGB(p_pixel_format, color.red, color.green, color.blue);
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+          SDL_memcpy(p_reference_texel, (const uint8_t *)&reference_color + (4 - texel_size), texel_size);
+#else
+          SDL_memcpy(p_reference_texel, &reference_color, texel_size);
+#endif
+          p_reference_texel += texel_size;
+        }
+        SDL_memset(p_reference_texel, 0xA5, texel_size);
+        SDL_memset(texel_row, 0xA5, sizeof(texel_row));
+
+        palette.expand_row(&palette, texel_row, index_row, row_length);
+        if (SDL_memcmp(texel_row, reference_texel_row, texel_size * (row_length + 1)) != 0)
+        {
+          fprintf(stdout, "FAIL  %-26s palette %-8s row length %d\n", SDL_GetPixelFormatName(p_pixel_format->format), pixel_kernel_name(palette.kernel), row_length);
+          kernel_passed = 0;
+          failures++;
+        }
+      }
+
+      if (kernel_passed)
+        fprintf(stdout, "PASS  %-26s palette %s\n", SDL_GetPixelFormatName(p_pixel_format->format), pixel_kernel_name(palette.kernel));
+    }
+
+    SDL_FreeFormat(p_pixel_format);
+  }
+
+  return failures;
+}
@@ -0,0 +1,48 @@
+#ifndef PALETTE_H
+#define PALETTE_H
+
+#include <stdint.h>
+#include "client_pixels.h"
+#include "pixel_convert.h"
+
+/* Defines */
+#define PALETTE_SIZE (256)
+
+/* Datatypes */
+typedef struct palette_s palette_ts;
+
+/*
+    Expands a row of palette indices into a row of texels of the palette pixel format.
+    The texel row must be able to hold texel_count texels of the palette pixel format
+*/
+typedef void (* palette_expand_row_tf)(
+  const palette_ts * p_palette,
+  void * p_texel_row,
+  const uint8_t * p_index_row,
+  int texel_count
+);
+
+struct palette_s {
+  const char * p_name;
+  pixel_kernel_te kernel;
+  palette_expand_row_tf expand_row;
+  int texel_size;
+  client_pixel_rgba_ts colors[PALETTE_SIZE];
+
+  /* Colors pre-converted into the texel pixel format, indexed by the texel size */
+  union {
+    uint32_t texels32[PALETTE_SIZE];
+    uint16_t texels16[PALETTE_SIZE];
+    uint8_t texel_bytes[PALETTE_SIZE * 4];
+  } lookup;
+};
+
+/* Function prototypes */
+int palette_init(palette_ts * p_palette, const pixel_converter_ts * p_converter, const char * p_preset_name);
+int palette_init_kernel(palette_ts * p_palette, const pixel_converter_ts * p_converter, const char * p_preset_name, pixel_kernel_te kernel);
+int palette_load_preset(palette_ts * p_palette, const pixel_converter_ts * p_converter, const char * p_preset_name);
+void palette_set_colors(palette_ts * p_palette, const pixel_converter_ts * p_converter, const client_pixel_rgba_ts * p_colors);
+const char * palette_next_preset_name(const char * p_preset_name);
+int palette_verify_kernels(void);
+
+#endif
@@ -0,0 +1,723 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <SDL.h>
+#include "pixel_convert.h"
+
+/*
+    Vectorized kernels are only compiled where the client pixel bytes can be loaded as little-endian
+    32-bit words, which makes red the least significant byte of every loaded client pixel
+*/
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && (SDL_BYTEORDER == SDL_LIL_ENDIAN)
+#define PIXEL_CONVERT_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) && (SDL_BYTEORDER == SDL_LIL_ENDIAN)
+#define PIXEL_CONVERT_NEON_KERNELS
+#include <arm_neon.h>
+#endif
+
+/* Constants */
+static const char * const PIXEL_KERNEL_NAMES[PIXEL_KERNEL_COUNT] = { "scalar", "sse2", "avx2", "neon" };
+
+/*
+    Specialized row converters.
+
+    Every converter produces exactly the texel value SDL_MapRGB would produce for the
+    same pixel format, which means the client-side alpha is ignored and formats with
+    an alpha channel receive a fully opaque alpha
+*/
+/*
+    Copies client-side pixels as they are into texels of the pixel format whose memory layout matches
+    client_pixel_rgba_ts byte for byte. Unlike the other converters it keeps the client-side alpha
+*/
+static void convert_row_copy(const pixel_converter_ts * p_converter, void * p_texel_row, const client_pixel_rgba_ts * p_client_row, int texel_count)
+{
+  (void)p_converter;
+  SDL_memcpy(p_texel_row, p_client_row, sizeof(client_pixel_rgba_ts) * (size_t)texel_count);
+}
+
+static void convert_row_rgba8888(const pixel_converter_ts * p_converter, void * p_texel_row, const client_pixel_rgba_ts * p_client_row, int texel_count)
+{
+  (void)p_converter;
+  uint32_t * const p_texels = (uint32_t *)p_texel_row;
+  for (int texel_x = 0; texel_x < texel_count; texel_x++)
+  {
+    const client_pixel_rgba_ts client_pixel = p_client_row[texel_x];
+    p_texels[texel_x] = ((uint32_t)client_pixel.red << 24) | ((uint32_t)client_pixel.green << 16) | ((uint32_t)client_pixel.blue << 8) | 0x000000FFu;
+  }
+}
+
+static void convert_row_argb8888(const pixel_converter_ts * p_converter, void * p_texel_row, const client_pixel_rgba_ts * p_client_row, int texel_count)
+{
+  (void)p_converter;
+  uint32_t * const p_texels = (uint32_t *)p_texel_row;
+  for (int texel_x = 0; texel_x < texel_count; texel_x++)
+  {
+    const client_pixel_rgba_ts client_pixel = p_client_row[texel_x];
+    p_texels[texel_x] = 0xFF000000u | ((uint32_t)client_pixel.red << 16) | ((uint32_t)client_pixel.green << 8) | (uint32_t)client_pixel.blue;
+  }
+}
+
+static void convert_row_abgr8888(const pixel_converter_ts * p_converter, void * p_texel_row, const client_pixel_rgba_ts * p_client_row, int texel_count)
+{
+  (void)p_converter;
+  uint32_t * const p_texels = (uint32_t *)p_texel_row;
+  for (int texel_x = 0; texel_x < texel_count; texel_x++)
+  {
+    const client_pixel_rgba_ts client_pixel = p_client_row[texel_x];
+    p_texels[texel_x] = 0xFF000000u | ((uint32_t)client_pixel.blue << 16) | ((uint32_t)client_pixel.green << 8) | (uint32_t)client_pixel.red;
+  }
+}
+
+static void convert_row_rgb888(const pixel_converter_ts * p_converter, void * p_texel_row, const client_pixel_rgba_ts * p_client_row, int texel_count)
+{
+  (void)p_converter;
+  uint32_t * const p_texels = (uint32_t *)p_texel_row;
+  for (int texel_x = 0; texel_x < texel_count; texel_x++)
+  {
+    const client_pixel_rgba_ts client_pixel = p_client_row[texel_x];
+    p_texels[texel_x] = ((uint32_t)client_pixel.red << 16) | ((uint32_t)client_pixel.green << 8) | (uint32_t)client_pixel.blue;
+  }
+}
+
+static void convert_row_rgb565(const pixel_converter_ts * p_converter, void * p_texel_row, const client_pixel_rgba_ts * p_client_row, int texel_count)
+{
+  (void)p_converter;
+  uint16_t * const p_texels = (uint16_t *)p_texel_row;
+  for (int texel_x = 0; texel_x < texel_count; texel_x++)
+  {
+    const client_pixel_rgba_ts client_pixel = p_client_row[texel_x];
+    p_texels[texel_x] = (uint16_t)(((client_pixel.red >> 3) << 11) | ((client_pixel.green >> 2) << 5) | (client_pixel.blue >> 3));
+  }
+}
+
+/* Fallback for every other pixel format, which lets SDL2 decode the format for every single texel */
+static void convert_row_generic(const pixel_converter_ts * p_converter, void * p_texel_row, const client_pixel_rgba_ts * p_client_row, int texel_count)
+{
+  const SDL_PixelFormat * const p_pixel_format = p_converter->p_pixel_format;
+  uint8_t * p_texel = (uint8_t *)p_texel_row;
+  for (int texel_x = 0; texel_x < texel_count; texel_x++)
+  {
+    const client_pixel_rgba_ts client_pixel = p_client_row[texel_x];
+    const uint32_t formatted_pixel_color = SDL_MapRGB(p_pixel_format, client_pixel.red, client_pixel.green, client_pixel.blue);
+
+    /* Store only as many bytes as a texel of this format occupies */
+    switch (p_pixel_format->BytesPerPixel)
+    {
+      case 1:
+        *p_texel = (uint8_t)formatted_pixel_color;
+        break;
+      case 2:
+        *(uint16_t *)p_texel = (uint16_t)formatted_pixel_color;
+        break;
+      case 3:
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+        SDL_memcpy(p_texel, (const uint8_t *)&formatted_pixel_color + 1, 3);
+#else
+        SDL_memcpy(p_texel, &formatted_pixel_color, 3);
+#endif
+        break;
+      default:
+        *(uint32_t *)p_texel = formatted_pixel_color;
+        break;
+    }
+    p_texel += p_pixel_format->BytesPerPixel;
+  }
+}
+
+/*
+    Converts any packed pixel format using the precomputed channel layout, which is exactly
+    what SDL_MapRGB computes per texel without decoding the format over and over again
+*/
+static void convert_row_packed(const pixel_converter_ts * p_converter, void * p_texel_row, const client_pixel_rgba_ts * p_client_row, int texel_count)
+{
+  const uint8_t * const p_shifts = p_converter->channel_shifts;
+  const uint8_t * const p_losses = p_converter->channel_losses;
+  const uint32_t constant_bits = p_converter->constant_bits;
+
+  if (p_converter->p_pixel_format->BytesPerPixel == 2)
+  {
+    uint16_t * const p_texels = (uint16_t *)p_texel_row;
+    for (int texel_x = 0; texel_x < texel_count; texel_x++)
+    {
+      const client_pixel_rgba_ts client_pixel = p_client_row[texel_x];
+      p_texels[texel_x] = (uint16_t)(
+        ((uint32_t)(client_pixel.red >> p_losses[0]) << p_shifts[0]) |
+        ((uint32_t)(client_pixel.green >> p_losses[1]) << p_shifts[1]) |
+        ((uint32_t)(client_pixel.blue >> p_losses[2]) << p_shifts[2]) |
+        constant_bits
+      );
+    }
+  }
+  else
+  {
+    uint32_t * const p_texels = (uint32_t *)p_texel_row;
+    for (int texel_x = 0; texel_x < texel_count; texel_x++)
+    {
+      const client_pixel_rgba_ts client_pixel = p_client_row[texel_x];
+      p_texels[texel_x] =
+        ((uint32_t)(client_pixel.red >> p_losses[0]) << p_shifts[0]) |
+        ((uint32_t)(client_pixel.green >> p_losses[1]) << p_shifts[1]) |
+        ((uint32_t)(client_pixel.blue >> p_losses[2]) << p_shifts[2]) |
+        constant_bits;
+    }
+  }
+}
+
+#ifdef PIXEL_CONVERT_X86_KERNELS
+/*
+    SSE2 kernels - Isolate, truncate and reposition every channel with shifts and masks,
+    converting 4 client pixels per instruction
+*/
+__attribute__((target("sse2")))
+static __m128i convert_texels_sse2(__m128i client_pixels, const __m128i * p_right_shifts, const __m128i * p_channel_masks, const __m128i * p_left_shifts, __m128i constant_bits)
+{
+  __m128i texels = constant_bits;
+  for (int channel = 0; channel < 3; channel++)
+  {
+    const __m128i channel_bits = _mm_and_si128(_mm_srl_epi32(client_pixels, p_right_shifts[channel]), p_channel_masks[channel]);
+    texels = _mm_or_si128(texels, _mm_sll_epi32(channel_bits, p_left_shifts[channel]));
+  }
+  return texels;
+}
+
+__attribute__((target("sse2")))
+static void convert_row_packed_sse2(const pixel_converter_ts * p_converter, void * p_texel_row, const client_pixel_rgba_ts * p_client_row, int texel_count)
+{
+  __m128i right_shifts[3];
+  __m128i channel_masks[3];
+  __m128i left_shifts[3];
+  for (int channel = 0; channel < 3; channel++)
+  {
+    right_shifts[channel] = _mm_cvtsi32_si128((8 * channel) + p_converter->channel_losses[channel]);
+    channel_masks[channel] = _mm_set1_epi32(0xFF >> p_converter->channel_losses[channel]);
+    left_shifts[channel] = _mm_cvtsi32_si128(p_converter->channel_shifts[channel]);
+  }
+  const __m128i constant_bits = _mm_set1_epi32((int)p_converter->constant_bits);
+
+  int texel_x = 0;
+  if (p_converter->p_pixel_format->BytesPerPixel == 2)
+  {
+    /* Narrow two vectors of 32-bit texels at once, biased so the signed saturating pack cannot clip */
+    const __m128i pack_bias_32 = _mm_set1_epi32(0x8000);
+    const __m128i pack_bias_16 = _mm_set1_epi16((short)0x8000);
+    uint16_t * const p_texels = (uint16_t *)p_texel_row;
+    for (; texel_x + 8 <= texel_count; texel_x += 8)
+    {
+      const __m128i client_low = _mm_loadu_si128((const __m128i *)(p_client_row + texel_x));
+      const __m128i client_high = _mm_loadu_si128((const __m128i *)(p_client_row + texel_x + 4));
+      const __m128i texels_low = convert_texels_sse2(client_low, right_shifts, channel_masks, left_shifts, constant_bits);
+      const __m128i texels_high = convert_texels_sse2(client_high, right_shifts, channel_masks, left_shifts, constant_bits);
+      const __m128i texels = _mm_packs_epi32(_mm_sub_epi32(texels_low, pack_bias_32), _mm_sub_epi32(texels_high, pack_bias_32));
+      _mm_storeu_si128((__m128i *)(p_texels + texel_x), _mm_xor_si128(texels, pack_bias_16));
+    }
+    convert_row_packed(p_converter, p_texels + texel_x, p_client_row + texel_x, texel_count - texel_x);
+  }
+  else
+  {
+    uint32_t * const p_texels = (uint32_t *)p_texel_row;
+    for (; texel_x + 4 <= texel_count; texel_x += 4)
+    {
+      const __m128i client_pixels = _mm_loadu_si128((const __m128i *)(p_client_row + texel_x));
+      _mm_storeu_si128((__m128i *)(p_texels + texel_x), convert_texels_sse2(client_pixels, right_shifts, channel_masks, left_shifts, constant_bits));
+    }
+    convert_row_packed(p_converter, p_texels + texel_x, p_client_row + texel_x, texel_count - texel_x);
+  }
+}
+
+/*
+    AVX2 kernels - Byte aligned 32-bit formats are a pure byte shuffle of 8 client pixels per instruction,
+    16-bit formats use the shift and mask approach on 8 client pixels per instruction
+*/
+__attribute__((target("avx2")))
+static void convert_row_shuffle32_avx2(const pixel_converter_ts * p_converter, void * p_texel_row, const client_pixel_rgba_ts * p_client_row, int texel_count)
+{
+  /* Build the in-lane byte shuffle, with 0x80 zeroing every byte that is not a color channel */
+  uint8_t shuffle_bytes[32];
+  for (int byte_index = 0; byte_index < 32; byte_index++)
+  {
+    const int channel = p_converter->texel_byte_channels[byte_index & 3];
+    shuffle_bytes[byte_index] = (channel < 0) ? 0x80 : (uint8_t)((byte_index & 0x0C) + channel);
+  }
+  const __m256i shuffle = _mm256_loadu_si256((const __m256i *)shuffle_bytes);
+  const __m256i constant_bits = _mm256_set1_epi32((int)p_converter->constant_bits);
+
+  uint32_t * const p_texels = (uint32_t *)p_texel_row;
+  int texel_x = 0;
+  for (; texel_x + 16 <= texel_count; texel_x += 16)
+  {
+    const __m256i client_first = _mm256_loadu_si256((const __m256i *)(p_client_row + texel_x));
+    const __m256i client_second = _mm256_loadu_si256((const __m256i *)(p_client_row + texel_x + 8));
+    _mm256_storeu_si256((__m256i *)(p_texels + texel_x), _mm256_or_si256(_mm256_shuffle_epi8(client_first, shuffle), constant_bits));
+    _mm256_storeu_si256((__m256i *)(p_texels + texel_x + 8), _mm256_or_si256(_mm256_shuffle_epi8(client_second, shuffle), constant_bits));
+  }
+  for (; texel_x + 8 <= texel_count; texel_x += 8)
+  {
+    const __m256i client_pixels = _mm256_loadu_si256((const __m256i *)(p_client_row + texel_x));
+    _mm256_storeu_si256((__m256i *)(p_texels + texel_x), _mm256_or_si256(_mm256_shuffle_epi8(client_pixels, shuffle), constant_bits));
+  }
+  convert_row_packed(p_converter, p_texels + texel_x, p_client_row + texel_x, texel_count - texel_x);
+}
+
+__attribute__((target("avx2")))
+static __m256i convert_texels_avx2(__m256i client_pixels, const __m128i * p_right_shifts, const __m256i * p_channel_masks, const __m128i * p_left_shifts, __m256i constant_bits)
+{
+  __m256i texels = constant_bits;
+  for (int channel = 0; channel < 3; channel++)
+  {
+    const __m256i channel_bits = _mm256_and_si256(_mm256_srl_epi32(client_pixels, p_right_shifts[channel]), p_channel_masks[channel]);
+    texels = _mm256_or_si256(texels, _mm256_sll_epi32(channel_bits, p_left_shifts[channel]));
+  }
+  return texels;
+}
+
+__attribute__((target("avx2")))
+static void convert_row_packed16_avx2(const pixel_converter_ts * p_converter, void * p_texel_row, const client_pixel_rgba_ts * p_client_row, int texel_count)
+{
+  __m128i right_shifts[3];
+  __m256i channel_masks[3];
+  __m128i left_shifts[3];
+  for (int channel = 0; channel < 3; channel++)
+  {
+    right_shifts[channel] = _mm_cvtsi32_si128((8 * channel) + p_converter->channel_losses[channel]);
+    channel_masks[channel] = _mm256_set1_epi32(0xFF >> p_converter->channel_losses[channel]);
+    left_shifts[channel] = _mm_cvtsi32_si128(p_converter->channel_shifts[channel]);
+  }
+  const __m256i constant_bits = _mm256_set1_epi32((int)p_converter->constant_bits);
+
+  uint16_t * const p_texels = (uint16_t *)p_texel_row;
+  int texel_x = 0;
+  for (; texel_x + 16 <= texel_count; texel_x += 16)
+  {
+    const __m256i client_first = _mm256_loadu_si256((const __m256i *)(p_client_row + texel_x));
+    const __m256i client_second = _mm256_loadu_si256((const __m256i *)(p_client_row + texel_x + 8));
+    const __m256i texels_first = convert_texels_avx2(client_first, right_shifts, channel_masks, left_shifts, constant_bits);
+    const __m256i texels_second = convert_texels_avx2(client_second, right_shifts, channel_masks, left_shifts, constant_bits);
+
+    /* The pack interleaves the 128-bit lanes of both inputs, so restore the texel order afterwards */
+    const __m256i texels = _mm256_packus_epi32(texels_first, texels_second);
+    _mm256_storeu_si256((__m256i *)(p_texels + texel_x), _mm256_permute4x64_epi64(texels, _MM_SHUFFLE(3, 1, 2, 0)));
+  }
+  convert_row_packed(p_converter, p_texels + texel_x, p_client_row + texel_x, texel_count - texel_x);
+}
+#endif
+
+#ifdef PIXEL_CONVERT_NEON_KERNELS
+/*
+    NEON kernels - De-interleave 16 client pixels into channel vectors and re-interleave
+    them in texel byte order, or widen 8 client pixels for 16-bit formats
+*/
+static void convert_row_shuffle32_neon(const pixel_converter_ts * p_converter, void * p_texel_row, const client_pixel_rgba_ts * p_client_row, int texel_count)
+{
+  uint8x16_t constant_bytes[4];
+  for (int texel_byte = 0; texel_byte < 4; texel_byte++)
+  {
+    constant_bytes[texel_byte] = vdupq_n_u8((uint8_t)(p_converter->constant_bits >> (8 * texel_byte)));
+  }
+
+  uint32_t * const p_texels = (uint32_t *)p_texel_row;
+  int texel_x = 0;
+  for (; texel_x + 16 <= texel_count; texel_x += 16)
+  {
+    const uint8x16x4_t client_channels = vld4q_u8((const uint8_t *)(p_client_row + texel_x));
+    uint8x16x4_t texel_bytes;
+    for (int texel_byte = 0; texel_byte < 4; texel_byte++)
+    {
+      const int channel = p_converter->texel_byte_channels[texel_byte];
+      texel_bytes.val[texel_byte] = (channel < 0) ? constant_bytes[texel_byte] : client_channels.val[channel];
+    }
+    vst4q_u8((uint8_t *)(p_texels + texel_x), texel_bytes);
+  }
+  convert_row_packed(p_converter, p_texels + texel_x, p_client_row + texel_x, texel_count - texel_x);
+}
+
+static void convert_row_packed16_neon(const pixel_converter_ts * p_converter, void * p_texel_row, const client_pixel_rgba_ts * p_client_row, int texel_count)
+{
+  int16x8_t right_shifts[3];
+  int16x8_t left_shifts[3];
+  for (int channel = 0; channel < 3; channel++)
+  {
+    right_shifts[channel] = vdupq_n_s16((int16_t)-p_converter->channel_losses[channel]);
+    left_shifts[channel] = vdupq_n_s16((int16_t)p_converter->channel_shifts[channel]);
+  }
+  const uint16x8_t constant_bits = vdupq_n_u16((uint16_t)p_converter->constant_bits);
+
+  uint16_t * const p_texels = (uint16_t *)p_texel_row;
+  int texel_x = 0;
+  for (; texel_x + 8 <= texel_count; texel_x += 8)
+  {
+    const uint8x8x4_t client_channels = vld4_u8((const uint8_t *)(p_client_row + texel_x));
+    uint16x8_t texels = constant_bits;
+    for (int channel = 0; channel < 3; channel++)
+    {
+      const uint16x8_t channel_bits = vshlq_u16(vmovl_u8(client_channels.val[channel]), right_shifts[channel]);
+      texels = vorrq_u16(texels, vshlq_u16(channel_bits, left_shifts[channel]));
+    }
+    vst1q_u16(p_texels + texel_x, texels);
+  }
+  convert_row_packed(p_converter, p_texels + texel_x, p_client_row + texel_x, texel_count - texel_x);
+}
+#endif
+
+/* Determines the texel layout of packed pixel formats, returns -1 for formats the packed converters cannot produce */
+static int pixel_converter_analyze_format(pixel_converter_ts * p_converter, const SDL_PixelFormat * p_pixel_format)
+{
+  const uint32_t channel_masks[3] = { p_pixel_format->Rmask, p_pixel_format->Gmask, p_pixel_format->Bmask };
+  const uint8_t channel_shifts[3] = { p_pixel_format->Rshift, p_pixel_format->Gshift, p_pixel_format->Bshift };
+  const uint8_t channel_losses[3] = { p_pixel_format->Rloss, p_pixel_format->Gloss, p_pixel_format->Bloss };
+
+  /* Byte layout used by the shuffle kernels, which remains unset for formats that are not byte aligned */
+  for (int texel_byte = 0; texel_byte < 4; texel_byte++)
+  {
+    p_converter->texel_byte_channels[texel_byte] = -1;
+  }
+
+  if (p_pixel_format->palette != NULL || (p_pixel_format->BytesPerPixel != 2 && p_pixel_format->BytesPerPixel != 4))
+    return -1;
+
+  for (int channel = 0; channel < 3; channel++)
+  {
+    /* Channels wider than 8 bits report a wrapped around loss which SDL_MapRGB cannot handle either */
+    if (channel_masks[channel] == 0 || channel_losses[channel] > 7)
+      return -1;
+
+    p_converter->channel_shifts[channel] = channel_shifts[channel];
+    p_converter->channel_losses[channel] = channel_losses[channel];
+  }
+  p_converter->constant_bits = p_pixel_format->Amask;
+
+  for (int channel = 0; channel < 3; channel++)
+  {
+    if (p_pixel_format->BytesPerPixel == 4 && channel_losses[channel] == 0 && (channel_shifts[channel] % 8) == 0)
+      p_converter->texel_byte_channels[channel_shifts[channel] / 8] = (int8_t)channel;
+  }
+
+  return 0;
+}
+
+static int pixel_converter_is_byte_aligned(const pixel_converter_ts * p_converter)
+{
+  int channels_found = 0;
+  for (int texel_byte = 0; texel_byte < 4; texel_byte++)
+  {
+    if (p_converter->texel_byte_channels[texel_byte] >= 0)
+      channels_found++;
+  }
+  return channels_found == 3;
+}
+
+/* Function definitions */
+void pixel_converter_init(pixel_converter_ts * p_converter, const SDL_PixelFormat * p_pixel_format)
+{
+  /* Texels laid out exactly like the client-side pixels need no conversion at all */
+  if (pixel_converter_init_copy(p_converter, p_pixel_format) == 0)
+    return;
+
+  /* Dispatch to the widest kernel the CPU supports for this pixel format, the scalar kernel supports all formats */
+  const pixel_kernel_te kernel_preference[] = { PIXEL_KERNEL_AVX2, PIXEL_KERNEL_NEON, PIXEL_KERNEL_SSE2, PIXEL_KERNEL_SCALAR };
+  for (size_t kernel_index = 0; kernel_index < SDL_arraysize(kernel_preference); kernel_index++)
+  {
+    if (pixel_converter_init_kernel(p_converter, p_pixel_format, kernel_preference[kernel_index]) == 0)
+      return;
+  }
+}
+
+/* Sets up the copying converter, returns -1 if the pixel format is not laid out like the client-side pixels */
+int pixel_converter_init_copy(pixel_converter_ts * p_converter, const SDL_PixelFormat * p_pixel_format)
+{
+  if (p_pixel_format->format != SDL_PIXELFORMAT_RGBA32)
+    return -1;
+
+  pixel_converter_analyze_format(p_converter, p_pixel_format);
+  p_converter->p_pixel_format = p_pixel_format;
+  p_converter->kernel = PIXEL_KERNEL_SCALAR;
+  p_converter->p_name = "copy";
+  p_converter->convert_row = convert_row_copy;
+  return 0;
+}
+
+int pixel_converter_init_kernel(pixel_converter_ts * p_converter, const SDL_PixelFormat * p_pixel_format, pixel_kernel_te kernel)
+{
+  if (!pixel_kernel_available(kernel))
+    return -1;
+
+  p_converter->p_pixel_format = p_pixel_format;
+  p_converter->kernel = kernel;
+  p_converter->p_name = NULL;
+  p_converter->convert_row = NULL;
+
+  /* Inspect the pixel format once so the per-frame conversion does not have to */
+  const int format_is_packed = (pixel_converter_analyze_format(p_converter, p_pixel_format) == 0);
+
+  switch (kernel)
+  {
+    case PIXEL_KERNEL_SCALAR:
+      switch (p_pixel_format->format)
+      {
+        case SDL_PIXELFORMAT_RGBA8888:
+          p_converter->p_name = "scalar RGBA8888";
+          p_converter->convert_row = convert_row_rgba8888;
+          break;
+        case SDL_PIXELFORMAT_ARGB8888:
+          p_converter->p_name = "scalar ARGB8888";
+          p_converter->convert_row = convert_row_argb8888;
+          break;
+        case SDL_PIXELFORMAT_ABGR8888:
+          p_converter->p_name = "scalar ABGR8888";
+          p_converter->convert_row = convert_row_abgr8888;
+          break;
+        case SDL_PIXELFORMAT_RGB888:
+          p_converter->p_name = "scalar RGB888";
+          p_converter->convert_row = convert_row_rgb888;
+          break;
+        case SDL_PIXELFORMAT_RGB565:
+          p_converter->p_name = "scalar RGB565";
+          p_converter->convert_row = convert_row_rgb565;
+          break;
+        default:
+          p_converter->p_name = format_is_packed ? "scalar packed" : "scalar generic";
+          p_converter->convert_row = format_is_packed ? convert_row_packed : convert_row_generic;
+          break;
+      }
+      break;
+
+#ifdef PIXEL_CONVERT_X86_KERNELS
+    case PIXEL_KERNEL_SSE2:
+      if (format_is_packed)
+      {
+        p_converter->p_name = (p_pixel_format->BytesPerPixel == 2) ? "sse2 packed16" : "sse2 packed32";
+        p_converter->convert_row = convert_row_packed_sse2;
+      }
+      break;
+
+    case PIXEL_KERNEL_AVX2:
+      if (format_is_packed && pixel_converter_is_byte_aligned(p_converter))
+      {
+        p_converter->p_name = "avx2 shuffle32";
+        p_converter->convert_row = convert_row_shuffle32_avx2;
+      }
+      else if (format_is_packed && p_pixel_format->BytesPerPixel == 2)
+      {
+        p_converter->p_name = "avx2 packed16";
+        p_converter->convert_row = convert_row_packed16_avx2;
+      }
+      break;
+#endif
+
+#ifdef PIXEL_CONVERT_NEON_KERNELS
+    case PIXEL_KERNEL_NEON:
+      if (format_is_packed && pixel_converter_is_byte_aligned(p_converter))
+      {
+        p_converter->p_name = "neon shuffle32";
+        p_converter->convert_row = convert_row_shuffle32_neon;
+      }
+      else if (format_is_packed && p_pixel_format->BytesPerPixel == 2)
+      {
+        p_converter->p_name = "neon packed16";
+        p_converter->convert_row = convert_row_packed16_neon;
+      }
+      break;
+#endif
+
+    default:
+      break;
+  }
+
+  return (p_converter->convert_row != NULL) ? 0 : -1;
+}
+
+/*
+    Relative cost of converting client-side pixels into texels of the pixel format, lower being cheaper:
+    the format laid out like the client-side pixels is a plain copy, other byte aligned 32-bit formats are a byte shuffle, other packed formats need shifts and masks, and the
+    remaining formats go through SDL_MapRGB per texel. Returns -1 for pixel formats no converter supports
+*/
+int pixel_format_conversion_cost(uint32_t pixel_format)
+{
+  if (SDL_ISPIXELFORMAT_FOURCC(pixel_format) || SDL_ISPIXELFORMAT_INDEXED(pixel_format))
+    return -1;
+
+  SDL_PixelFormat * const p_pixel_format = SDL_AllocFormat(pixel_format);
+  if (p_pixel_format == NULL)
+    return -1;
+
+  pixel_converter_ts format_analysis;
+  int conversion_cost = -1;
+  if (pixel_converter_init_copy(&format_analysis, p_pixel_format) == 0)
+    conversion_cost = 0;
+  else if (pixel_converter_analyze_format(&format_analysis, p_pixel_format) == 0)
+    conversion_cost = pixel_converter_is_byte_aligned(&format_analysis) ? 1 : 2;
+  else if (p_pixel_format->BytesPerPixel == 3)
+    conversion_cost = 3;
+
+  SDL_FreeFormat(p_pixel_format);
+  return conversion_cost;
+}
+
+/*
+    Chooses the texture format of the renderer that is cheapest to convert into, preferring formats the renderer
+    lists first among equally cheap ones. Returns the fallback format if the renderer lists no supported format
+*/
+uint32_t pixel_convert_choose_texture_format(const SDL_RendererInfo * p_renderer_info, uint32_t fallback_pixel_format)
+{
+  uint32_t chosen_pixel_format = fallback_pixel_format;
+  int chosen_conversion_cost = -1;
+  for (Uint32 format_index = 0; format_index < p_renderer_info->num_texture_formats; format_index++)
+  {
+    const int conversion_cost = pixel_format_conversion_cost(p_renderer_info->texture_formats[format_index]);
+    if (conversion_cost >= 0 && (chosen_conversion_cost < 0 || conversion_cost < chosen_conversion_cost))
+    {
+      chosen_pixel_format = p_renderer_info->texture_formats[format_index];
+      chosen_conversion_cost = conversion_cost;
+    }
+  }
+  return chosen_pixel_format;
+}
+
+/*
+    Chooses the texture format of the renderer whose bytes are laid out like the client-side pixels, so rendering into
+    a locked texture needs no conversion inside SDL2. Formats without alpha take the client alpha in their unused byte.
+    Returns SDL_PIXELFORMAT_UNKNOWN if the renderer lists no such format natively
+*/
+uint32_t pixel_convert_choose_zero_copy_format(const SDL_RendererInfo * p_renderer_info)
+{
+  const uint32_t zero_copy_pixel_formats[] = { SDL_PIXELFORMAT_RGBA32, SDL_PIXELFORMAT_RGBX32 };
+  for (size_t preference_index = 0; preference_index < SDL_arraysize(zero_copy_pixel_formats); preference_index++)
+  {
+    for (Uint32 format_index = 0; format_index < p_renderer_info->num_texture_formats; format_index++)
+    {
+      if (p_renderer_info->texture_formats[format_index] == zero_copy_pixel_formats[preference_index])
+        return zero_copy_pixel_formats[preference_index];
+    }
+  }
+  return SDL_PIXELFORMAT_UNKNOWN;
+}
+
+int pixel_kernel_available(pixel_kernel_te kernel)
+{
+  switch (kernel)
+  {
+    case PIXEL_KERNEL_SCALAR:
+      return 1;
+#ifdef PIXEL_CONVERT_X86_KERNELS
+    case PIXEL_KERNEL_SSE2:
+      return SDL_HasSSE2() ? 1 : 0;
+    case PIXEL_KERNEL_AVX2:
+      return SDL_HasAVX2() ? 1 : 0;
+#endif
+#ifdef PIXEL_CONVERT_NEON_KERNELS
+    case PIXEL_KERNEL_NEON:
+      return SDL_HasNEON() ? 1 : 0;
+#endif
+    default:
+      return 0;
+  }
+}
+
+const char * pixel_kernel_name(pixel_kernel_te kernel)
+{
+  return ((int)kernel >= 0 && kernel < PIXEL_KERNEL_COUNT) ? PIXEL_KERNEL_NAMES[kernel] : "unknown";
+}
+
+int pixel_kernel_from_name(const char * p_kernel_name, pixel_kernel_te * p_kernel)
+{
+  for (int kernel = 0; kernel < PIXEL_KERNEL_COUNT; kernel++)
+  {
+    if (SDL_strcmp(p_kernel_name, PIXEL_KERNEL_NAMES[kernel]) == 0)
+    {
+      *p_kernel = (pixel_kernel_te)kernel;
+      return 0;
+    }
+  }
+  return -1;
+}
+
+/*
+    Compares every kernel available on this CPU against the SDL_MapRGB reference, and the copying converter
+    against the SDL_MapRGBA reference, for every supported pixel format and a range of row lengths that exercise the vector loop tails.
+    Returns the number of failed kernel and format combinations
+*/
+int pixel_convert_verify_kernels(void)
+{
+  const uint32_t verified_pixel_formats[] = {
+    SDL_PIXELFORMAT_RGBA8888, SDL_PIXELFORMAT_ARGB8888, SDL_PIXELFORMAT_ABGR8888, SDL_PIXELFORMAT_BGRA8888,
+    SDL_PIXELFORMAT_RGBX8888, SDL_PIXELFORMAT_BGRX8888, SDL_PIXELFORMAT_RGB888, SDL_PIXELFORMAT_BGR888,
+    SDL_PIXELFORMAT_RGB565, SDL_PIXELFORMAT_BGR565, SDL_PIXELFORMAT_RGB24
+  };
+  enum { VERIFY_ROW_LENGTH_MAX = 1031 };
+  static client_pixel_rgba_ts client_row[VERIFY_ROW_LENGTH_MAX];
+  static uint32_t texel_row[VERIFY_ROW_LENGTH_MAX + 1];
+  static uint32_t reference_texel_row[VERIFY_ROW_LENGTH_MAX + 1];
+
+  /* Deterministic pseudo-random client pixels, including random alpha which must not leak into the texels */
+  uint32_t random_state = 0x12345678u;
+  for (int texel_x = 0; texel_x < VERIFY_ROW_LENGTH_MAX; texel_x++)
+  {
+    random_state = (random_state * 1664525u) + 1013904223u;
+    client_row[texel_x].red = (uint8_t)(random_state >> 24);
+    client_row[texel_x].green = (uint8_t)(random_state >> 16);
+    client_row[texel_x].blue = (uint8_t)(random_state >> 8);
+    client_row[texel_x].alpha = (uint8_t)random_state;
+  }
+
+  int failures = 0;
+  for (size_t format_index = 0; format_index < SDL_arraysize(verified_pixel_formats); format_index++)
+  {
+    SDL_PixelFormat * const p_pixel_format = SDL_AllocFormat(verified_pixel_formats[format_index]);
+    if (p_pixel_format == NULL)
+    {
+      fprintf(stderr, "\nPixel format %s could not be allocated - Error: %s", SDL_GetPixelFormatName(verified_pixel_formats[format_index]), SDL_GetError());
+      failures++;
+      continue;
+    }
+    const size_t texel_size = p_pixel_format->BytesPerPixel;
+
+    /* Every kernel, followed by the copying converter which keeps the client-side alpha */
+    for (int kernel = 0; kernel <= PIXEL_KERNEL_COUNT; kernel++)
+    {
+      pixel_converter_ts converter;
+      const int keeps_alpha = (kernel == PIXEL_KERNEL_COUNT);
+      const int init_result = keeps_alpha
+        ? pixel_converter_init_copy(&converter, p_pixel_format)
+        : pixel_converter_init_kernel(&converter, p_pixel_format, (pixel_kernel_te)kernel);
+      if (init_result != 0)
+        continue;
+
+      int kernel_passed = 1;
+      for (int row_length = 0; row_length <= VERIFY_ROW_LENGTH_MAX && kernel_passed; row_length += (row_length < 67) ? 1 : 241)
+      {
+        /* Build the reference row through SDL2 and poison the converted row, including one texel past its end */
+        uint8_t * p_reference_texel = (uint8_t *)reference_texel_row;
+        for (int texel_x = 0; texel_x < row_length; texel_x++)
+        {
+          const uint32_t reference_color = keeps_alpha
+            ? SDL_MapRGBA(p_pixel_format, client_row[texel_x].red, client_row[texel_x].green, client_row[texel_x].blue, client_row[texel_x].alpha)
+            : SDL_MapRGB(p_pixel_format, client_row[texel_x].red, client_row[texel_x].green, client_row[texel_x].blue);
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+          SDL_memcpy(p_reference_texel, (const uint8_t *)&reference_color + (4 - texel_size), texel_size);
+#else
+          SDL_memcpy(p_reference_texel, &reference_color, texel_size);
+#endif
+          p_reference_texel += texel_size;
+        }
+        SDL_memset(p_reference_texel, 0xA5, texel_size);
+        SDL_memset(texel_row, 0xA5, sizeof(texel_row));
+
+        converter.convert_row(&converter, texel_row, client_row, row_length);
+        if (SDL_memcmp(texel_row, reference_texel_row, texel_size * (row_length + 1)) != 0)
+        {
+          fprintf(stdout, "FAIL  %-26s %-16s row length %d\n", SDL_GetPixelFormatName(p_pixel_format->format), converter.p_name, row_length);
+          kernel_passed = 0;
+          failures++;
+        }
+      }
+
+      if (kernel_passed)
+        fprintf(stdout, "PASS  %-26s %s\n", SDL_GetPixelFormatName(p_pixel_format->format), converter.p_name);
+    }
+
+    SDL_FreeFormat(p_pixel_format);
+  }
+
+  return failures;
+}
@@ -0,0 +1,55 @@
+#ifndef PIXEL_CONVERT_H
+#define PIXEL_CONVERT_H
+
+#include <stdint.h>
+#include <SDL.h>
+#include "client_pixels.h"
+
+/* Datatypes */
+typedef enum {
+  PIXEL_KERNEL_SCALAR = 0,
+  PIXEL_KERNEL_SSE2,
+  PIXEL_KERNEL_AVX2,
+  PIXEL_KERNEL_NEON,
+  PIXEL_KERNEL_COUNT
+} pixel_kernel_te;
+
+typedef struct pixel_converter_s pixel_converter_ts;
+
+/*
+    Converts a row of client-side pixels into a row of texels of the converter pixel format.
+    The texel row must be able to hold texel_count texels of the converter pixel format
+*/
+typedef void (* pixel_row_converter_tf)(
+  const pixel_converter_ts * p_converter,
+  void * p_texel_row,
+  const client_pixel_rgba_ts * p_client_row,
+  int texel_count
+);
+
+struct pixel_converter_s {
+  const char * p_name;
+  const SDL_PixelFormat * p_pixel_format;
+  pixel_kernel_te kernel;
+  pixel_row_converter_tf convert_row;
+
+  /* Texel layout of the pixel format, precomputed for the packed and vectorized converters */
+  uint8_t channel_shifts[3];
+  uint8_t channel_losses[3];
+  uint32_t constant_bits;
+  int8_t texel_byte_channels[4];
+};
+
+/* Function prototypes */
+void pixel_converter_init(pixel_converter_ts * p_converter, const SDL_PixelFormat * p_pixel_format);
+int pixel_converter_init_copy(pixel_converter_ts * p_converter, const SDL_PixelFormat * p_pixel_format);
+int pixel_converter_init_kernel(pixel_converter_ts * p_converter, const SDL_PixelFormat * p_pixel_format, pixel_kernel_te kernel);
+int pixel_format_conversion_cost(uint32_t pixel_format);
+uint32_t pixel_convert_choose_texture_format(const SDL_RendererInfo * p_renderer_info, uint32_t fallback_pixel_format);
+uint32_t pixel_convert_choose_zero_copy_format(const SDL_RendererInfo * p_renderer_info);
+int pixel_kernel_available(pixel_kernel_te kernel);
+const char * pixel_kernel_name(pixel_kernel_te kernel);
+int pixel_kernel_from_name(const char * p_kernel_name, pixel_kernel_te * p_kernel);
+int pixel_convert_verify_kernels(void);
+
+#endif
@@ -0,0 +1,722 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <SDL.h>
+#include "pixel_generator.h"
+#include "raster.h"
+#include "tilemap.h"
+#include "sprite.h"
+
+/* Vectorized noise kernels write client pixels as little-endian 32-bit words, red being the least significant byte */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && (SDL_BYTEORDER == SDL_LIL_ENDIAN)
+#define PIXEL_GENERATOR_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) && (SDL_BYTEORDER == SDL_LIL_ENDIAN)
+#define PIXEL_GENERATOR_NEON_KERNELS
+#include <arm_neon.h>
+#endif
+
+/* Defines */
+#define NOISE_LANES (8)
+#define SPRITE_COUNT (6)
+#define TILEMAP_PATTERN_TILE_COUNT (16)
+#define TILEMAP_PATTERN_BACKGROUND_TILES (8)
+#define TILEMAP_PATTERN_SPRITE_TILES (4)
+
+/* Constants */
+static const uint32_t NOISE_INTENSITY_RANGE = 80;
+static const int SPRITE_SIZE = 8;
+static const int SPRITE_BACKGROUND_CELL_SHIFT = 3;
+static const int TILEMAP_PATTERN_MAP_SIZE = 32;
+static const int TILEMAP_PATTERN_WAVE_AMPLITUDE = 4;
+static const client_pixel_rgba_ts TILEMAP_PATTERN_PALETTE[TILEMAP_COLOR_COUNT] = {
+  { 0x9B, 0xBC, 0x0F, 0xFF },
+  { 0x8B, 0xAC, 0x0F, 0xFF },
+  { 0x30, 0x62, 0x30, 0xFF },
+  { 0x0F, 0x38, 0x0F, 0xFF }
+};
+static const client_pixel_rgba_ts TILEMAP_PATTERN_SPRITE_KEY = { 0xFF, 0x00, 0xFF, 0xFF };
+
+/* Datatypes */
+typedef struct {
+  tilemap_ts * p_tilemap;
+  client_pixel_rgba_ts sprite_pixels[TILEMAP_PATTERN_SPRITE_TILES * TILEMAP_TILE_SIZE * TILEMAP_TILE_SIZE];
+  sprite_atlas_ts sprite_atlas;
+  sprite_draw_list_ts sprite_draw_list;
+  uint64_t frame_index;
+} tilemap_pattern_state_ts;
+
+/*
+    Noise stream.
+
+    Every row runs NOISE_LANES independent xorshift32 generators, seeded from the frame seed and
+    the row index. Pixel x of a row takes the next value of lane (x % NOISE_LANES), so a vector of
+    NOISE_LANES generators produces exactly the same pixels as the scalar definition below. The
+    intensity is scaled from the upper 16 bits of the state with a multiply instead of a modulo
+*/
+static uint32_t hash32(uint32_t value)
+{
+  value ^= value >> 16;
+  value *= 0x7FEB352Du;
+  value ^= value >> 15;
+  value *= 0x846CA68Bu;
+  value ^= value >> 16;
+  return value;
+}
+
+static uint32_t xorshift32(uint32_t state)
+{
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+static void noise_seed_lanes(uint32_t * p_lanes, uint32_t frame_seed, int row)
+{
+  for (int lane = 0; lane < NOISE_LANES; lane++)
+  {
+    /* Xorshift generators must never be seeded with zero */
+    p_lanes[lane] = hash32(frame_seed + ((uint32_t)row * 0x9E3779B9u) + ((uint32_t)lane * 0x632BE5ABu)) | 1u;
+  }
+}
+
+/* Palette indices take the noise intensity itself, so a grey ramp palette reproduces the RGBA noise */
+static void noise_fill_index_rows(const pixel_generator_ts * p_generator, const client_framebuffer_indexed_ts * p_framebuffer, int row_begin, int row_end)
+{
+  uint32_t lanes[NOISE_LANES];
+  for (int row = row_begin; row < row_end; row++)
+  {
+    uint8_t * const p_row = client_framebuffer_indexed_row(p_framebuffer, row);
+    noise_seed_lanes(lanes, p_generator->frame_seed, row);
+    for (int pixel_x = 0; pixel_x < p_framebuffer->width; pixel_x++)
+    {
+      const int lane = pixel_x % NOISE_LANES;
+      lanes[lane] = xorshift32(lanes[lane]);
+      p_row[pixel_x] = (uint8_t)(((lanes[lane] >> 16) * NOISE_INTENSITY_RANGE) >> 16);
+    }
+  }
+}
+
+static void noise_fill_pixels_scalar(client_pixel_rgba_ts * p_pixels, int pixel_count, uint32_t * p_lanes)
+{
+  for (int pixel_x = 0; pixel_x < pixel_count; pixel_x++)
+  {
+    const int lane = pixel_x % NOISE_LANES;
+    p_lanes[lane] = xorshift32(p_lanes[lane]);
+
+    const uint8_t intensity = (uint8_t)(((p_lanes[lane] >> 16) * NOISE_INTENSITY_RANGE) >> 16);
+    p_pixels[pixel_x].red = intensity;
+    p_pixels[pixel_x].green = intensity;
+    p_pixels[pixel_x].blue = intensity;
+    p_pixels[pixel_x].alpha = 0xFF;
+  }
+}
+
+static void noise_fill_rows_scalar(const pixel_generator_ts * p_generator, const client_framebuffer_ts * p_framebuffer, int row_begin, int row_end)
+{
+  uint32_t lanes[NOISE_LANES];
+  for (int row = row_begin; row < row_end; row++)
+  {
+    noise_seed_lanes(lanes, p_generator->frame_seed, row);
+    noise_fill_pixels_scalar(client_framebuffer_row(p_framebuffer, row), p_framebuffer->width, lanes);
+  }
+}
+
+#ifdef PIXEL_GENERATOR_X86_KERNELS
+/* SSE2 kernel - Two vectors of 4 generators, filling 8 pixels per iteration */
+__attribute__((target("sse2")))
+static __m128i noise_step_sse2(__m128i * p_state, __m128i intensity_range, __m128i opaque_alpha)
+{
+  __m128i state = *p_state;
+  state = _mm_xor_si128(state, _mm_slli_epi32(state, 13));
+  state = _mm_xor_si128(state, _mm_srli_epi32(state, 17));
+  state = _mm_xor_si128(state, _mm_slli_epi32(state, 5));
+  *p_state = state;
+
+  /* The upper state half moves into the lower 16 bits, so the high multiply yields the scaled intensity per lane */
+  const __m128i intensity = _mm_mulhi_epu16(_mm_srli_epi32(state, 16), intensity_range);
+  return _mm_or_si128(
+    _mm_or_si128(intensity, _mm_slli_epi32(intensity, 8)),
+    _mm_or_si128(_mm_slli_epi32(intensity, 16), opaque_alpha)
+  );
+}
+
+__attribute__((target("sse2")))
+static void noise_fill_rows_sse2(const pixel_generator_ts * p_generator, const client_framebuffer_ts * p_framebuffer, int row_begin, int row_end)
+{
+  const __m128i intensity_range = _mm_set1_epi32((int)NOISE_INTENSITY_RANGE);
+  const __m128i opaque_alpha = _mm_set1_epi32((int)0xFF000000u);
+  uint32_t lanes[NOISE_LANES];
+
+  for (int row = row_begin; row < row_end; row++)
+  {
+    client_pixel_rgba_ts * const p_row = client_framebuffer_row(p_framebuffer, row);
+    noise_seed_lanes(lanes, p_generator->frame_seed, row);
+    __m128i state_low = _mm_loadu_si128((const __m128i *)lanes);
+    __m128i state_high = _mm_loadu_si128((const __m128i *)(lanes + 4));
+
+    int pixel_x = 0;
+    for (; pixel_x + NOISE_LANES <= p_framebuffer->width; pixel_x += NOISE_LANES)
+    {
+      _mm_storeu_si128((__m128i *)(p_row + pixel_x), noise_step_sse2(&state_low, intensity_range, opaque_alpha));
+      _mm_storeu_si128((__m128i *)(p_row + pixel_x + 4), noise_step_sse2(&state_high, intensity_range, opaque_alpha));
+    }
+
+    _mm_storeu_si128((__m128i *)lanes, state_low);
+    _mm_storeu_si128((__m128i *)(lanes + 4), state_high);
+    noise_fill_pixels_scalar(p_row + pixel_x, p_framebuffer->width - pixel_x, lanes);
+  }
+}
+
+/* AVX2 kernel - One vector of 8 generators, filling 8 pixels per iteration */
+__attribute__((target("avx2")))
+static void noise_fill_rows_avx2(const pixel_generator_ts * p_generator, const client_framebuffer_ts * p_framebuffer, int row_begin, int row_end)
+{
+  const __m256i intensity_range = _mm256_set1_epi32((int)NOISE_INTENSITY_RANGE);
+  const __m256i opaque_alpha = _mm256_set1_epi32((int)0xFF000000u);
+  uint32_t lanes[NOISE_LANES];
+
+  for (int row = row_begin; row < row_end; row++)
+  {
+    client_pixel_rgba_ts * const p_row = client_framebuffer_row(p_framebuffer, row);
+    noise_seed_lanes(lanes, p_generator->frame_seed, row);
+    __m256i state = _mm256_loadu_si256((const __m256i *)lanes);
+
+    int pixel_x = 0;
+    for (; pixel_x + NOISE_LANES <= p_framebuffer->width; pixel_x += NOISE_LANES)
+    {
+      state = _mm256_xor_si256(state, _mm256_slli_epi32(state, 13));
+      state = _mm256_xor_si256(state, _mm256_srli_epi32(state, 17));
+      state = _mm256_xor_si256(state, _mm256_slli_epi32(state, 5));
+
+      const __m256i intensity = _mm256_mulhi_epu16(_mm256_srli_epi32(state, 16), intensity_range);
+      const __m256i pixels = _mm256_or_si256(
+        _mm256_or_si256(intensity, _mm256_slli_epi32(intensity, 8)),
+        _mm256_or_si256(_mm256_slli_epi32(intensity, 16), opaque_alpha)
+      );
+      _mm256_storeu_si256((__m256i *)(p_row + pixel_x), pixels);
+    }
+
+    _mm256_storeu_si256((__m256i *)lanes, state);
+    noise_fill_pixels_scalar(p_row + pixel_x, p_framebuffer->width - pixel_x, lanes);
+  }
+}
+#endif
+
+#ifdef PIXEL_GENERATOR_NEON_KERNELS
+/* NEON kernel - Two vectors of 4 generators, filling 8 pixels per iteration */
+static uint32x4_t noise_step_neon(uint32x4_t * p_state, uint32x4_t opaque_alpha)
+{
+  uint32x4_t state = *p_state;
+  state = veorq_u32(state, vshlq_n_u32(state, 13));
+  state = veorq_u32(state, vshrq_n_u32(state, 17));
+  state = veorq_u32(state, vshlq_n_u32(state, 5));
+  *p_state = state;
+
+  const uint32x4_t intensity = vshrq_n_u32(vmulq_n_u32(vshrq_n_u32(state, 16), NOISE_INTENSITY_RANGE), 16);
+  return vorrq_u32(vmulq_n_u32(intensity, 0x00010101u), opaque_alpha);
+}
+
+static void noise_fill_rows_neon(const pixel_generator_ts * p_generator, const client_framebuffer_ts * p_framebuffer, int row_begin, int row_end)
+{
+  const uint32x4_t opaque_alpha = vdupq_n_u32(0xFF000000u);
+  uint32_t lanes[NOISE_LANES];
+
+  for (int row = row_begin; row < row_end; row++)
+  {
+    client_pixel_rgba_ts * const p_row = client_framebuffer_row(p_framebuffer, row);
+    noise_seed_lanes(lanes, p_generator->frame_seed, row);
+    uint32x4_t state_low = vld1q_u32(lanes);
+    uint32x4_t state_high = vld1q_u32(lanes + 4);
+
+    int pixel_x = 0;
+    for (; pixel_x + NOISE_LANES <= p_framebuffer->width; pixel_x += NOISE_LANES)
+    {
+      vst1q_u32((uint32_t *)(p_row + pixel_x), noise_step_neon(&state_low, opaque_alpha));
+      vst1q_u32((uint32_t *)(p_row + pixel_x + 4), noise_step_neon(&state_high, opaque_alpha));
+    }
+
+    vst1q_u32(lanes, state_low);
+    vst1q_u32(lanes + 4, state_high);
+    noise_fill_pixels_scalar(p_row + pixel_x, p_framebuffer->width - pixel_x, lanes);
+  }
+}
+#endif
+
+/* Gradient pattern scrolling by one pixel per frame, cheap enough to measure the rest of the pipeline */
+static void gradient_fill_rows(const pixel_generator_ts * p_generator, const client_framebuffer_ts * p_framebuffer, int row_begin, int row_end)
+{
+  const uint32_t scroll_offset = (uint32_t)p_generator->frame_index;
+  for (int row = row_begin; row < row_end; row++)
+  {
+    client_pixel_rgba_ts * const p_row = client_framebuffer_row(p_framebuffer, row);
+    for (int pixel_x = 0; pixel_x < p_framebuffer->width; pixel_x++)
+    {
+      p_row[pixel_x].red = (uint8_t)(pixel_x + scroll_offset);
+      p_row[pixel_x].green = (uint8_t)(row + scroll_offset);
+      p_row[pixel_x].blue = (uint8_t)(pixel_x ^ row);
+      p_row[pixel_x].alpha = 0xFF;
+    }
+  }
+}
+
+static void gradient_fill_index_rows(const pixel_generator_ts * p_generator, const client_framebuffer_indexed_ts * p_framebuffer, int row_begin, int row_end)
+{
+  const uint32_t scroll_offset = (uint32_t)p_generator->frame_index;
+  for (int row = row_begin; row < row_end; row++)
+  {
+    uint8_t * const p_row = client_framebuffer_indexed_row(p_framebuffer, row);
+    for (int pixel_x = 0; pixel_x < p_framebuffer->width; pixel_x++)
+    {
+      p_row[pixel_x] = (uint8_t)((pixel_x + scroll_offset) ^ (uint32_t)row);
+    }
+  }
+}
+
+/*
+    Sprites.
+
+    A few solid squares bounce across a static checkerboard, each with its own start position and
+    speed derived from the seed. Positions are a pure function of the frame index, so the damage of
+    a frame is the area each sprite covered in the previously rendered frame and covers in the current one
+*/
+static int sprite_bounce(uint64_t travel, int range)
+{
+  if (range <= 0)
+    return 0;
+
+  const uint64_t period = (uint64_t)range * 2;
+  const int phase = (int)(travel % period);
+  return (phase <= range) ? phase : (int)period - phase;
+}
+
+static SDL_Rect sprite_rect(const pixel_generator_ts * p_generator, int sprite, uint64_t frame_index, int width, int height)
+{
+  const uint32_t sprite_hash = hash32(p_generator->seed + ((uint32_t)sprite * 0x9E3779B9u));
+  const uint64_t velocity_x = 1 + (sprite_hash & 0x1u);
+  const uint64_t velocity_y = 1 + ((sprite_hash >> 1) & 0x1u);
+  const uint64_t start_x = (sprite_hash >> 8) & 0xFFFu;
+  const uint64_t start_y = sprite_hash >> 20;
+
+  SDL_Rect rect;
+  rect.w = SDL_min(SPRITE_SIZE, width);
+  rect.h = SDL_min(SPRITE_SIZE, height);
+  rect.x = sprite_bounce(start_x + (frame_index * velocity_x), width - rect.w);
+  rect.y = sprite_bounce(start_y + (frame_index * velocity_y), height - rect.h);
+  return rect;
+}
+
+static uint32_t sprite_color_hash(const pixel_generator_ts * p_generator, int sprite)
+{
+  return hash32(p_generator->seed ^ ((uint32_t)sprite * 0x632BE5ABu));
+}
+
+static uint8_t sprite_background_intensity(int pixel_x, int row)
+{
+  return (((pixel_x ^ row) >> SPRITE_BACKGROUND_CELL_SHIFT) & 0x1) ? 0x30 : 0x28;
+}
+
+static void sprites_fill_rows(const pixel_generator_ts * p_generator, const client_framebuffer_ts * p_framebuffer, int row_begin, int row_end)
+{
+  /* Draw into the rows of this band only, other bands may be drawn at the same time */
+  raster_target_ts raster_target;
+  const SDL_Rect band_rect = { 0, row_begin, p_framebuffer->width, row_end - row_begin };
+  raster_target_init(&raster_target, p_framebuffer);
+  raster_target_set_clip(&raster_target, &band_rect);
+
+  /* The checkerboard is made of aligned cells, so each cell of a row is a single span */
+  const int cell_size = 1 << SPRITE_BACKGROUND_CELL_SHIFT;
+  for (int row = row_begin; row < row_end; row++)
+  {
+    for (int cell_x = 0; cell_x < p_framebuffer->width; cell_x += cell_size)
+    {
+      const uint8_t intensity = sprite_background_intensity(cell_x, row);
+      const client_pixel_rgba_ts background_color = { intensity, intensity, intensity, 0xFF };
+      raster_span_horizontal(&raster_target, cell_x, cell_x + cell_size, row, background_color);
+    }
+  }
+
+  /* Later sprites are drawn over earlier ones */
+  for (int sprite = 0; sprite < SPRITE_COUNT; sprite++)
+  {
+    const SDL_Rect rect = sprite_rect(p_generator, sprite, p_generator->frame_index, p_framebuffer->width, p_framebuffer->height);
+    const uint32_t sprite_hash = sprite_color_hash(p_generator, sprite);
+    const client_pixel_rgba_ts sprite_color = {
+      (uint8_t)(sprite_hash | 0x80u),
+      (uint8_t)((sprite_hash >> 8) | 0x40u),
+      (uint8_t)((sprite_hash >> 16) | 0x40u),
+      0xFF
+    };
+    raster_rect_fill(&raster_target, &rect, sprite_color);
+  }
+}
+
+static void sprites_fill_index_rows(const pixel_generator_ts * p_generator, const client_framebuffer_indexed_ts * p_framebuffer, int row_begin, int row_end)
+{
+  SDL_Rect sprite_rects[SPRITE_COUNT];
+  for (int sprite = 0; sprite < SPRITE_COUNT; sprite++)
+  {
+    sprite_rects[sprite] = sprite_rect(p_generator, sprite, p_generator->frame_index, p_framebuffer->width, p_framebuffer->height);
+  }
+
+  for (int row = row_begin; row < row_end; row++)
+  {
+    uint8_t * const p_row = client_framebuffer_indexed_row(p_framebuffer, row);
+    for (int pixel_x = 0; pixel_x < p_framebuffer->width; pixel_x++)
+    {
+      p_row[pixel_x] = sprite_background_intensity(pixel_x, row);
+    }
+
+    for (int sprite = 0; sprite < SPRITE_COUNT; sprite++)
+    {
+      const SDL_Rect * const p_rect = &sprite_rects[sprite];
+      if (row >= p_rect->y && row < p_rect->y + p_rect->h)
+        SDL_memset(p_row + p_rect->x, (uint8_t)(sprite_color_hash(p_generator, sprite) | 0x80u), (size_t)p_rect->w);
+    }
+  }
+}
+
+static void sprites_collect_damage(const pixel_generator_ts * p_generator, damage_tracker_ts * p_damage)
+{
+  for (int sprite = 0; sprite < SPRITE_COUNT; sprite++)
+  {
+    const SDL_Rect previous_rect = sprite_rect(p_generator, sprite, p_generator->previous_frame_index, p_damage->width, p_damage->height);
+    const SDL_Rect current_rect = sprite_rect(p_generator, sprite, p_generator->frame_index, p_damage->width, p_damage->height);
+    damage_add(p_damage, &previous_rect);
+    damage_add(p_damage, &current_rect);
+  }
+}
+
+/*
+    Tilemap.
+
+    A handheld console style screen of two tile layers and a few sprites. Tiles, maps and sprites are
+    derived from the seed once, then every frame only scrolls the layers. The scanline hook bends the
+    background into a wave, and the sprites bounce like those of the sprites pattern
+*/
+static void tilemap_pattern_free_state(void * p_state)
+{
+  tilemap_pattern_state_ts * const p_pattern = (tilemap_pattern_state_ts *)p_state;
+  if (p_pattern == NULL)
+    return;
+
+  tilemap_destroy(p_pattern->p_tilemap);
+  sprite_draw_list_free(&p_pattern->sprite_draw_list);
+  sprite_atlas_free(&p_pattern->sprite_atlas);
+  free(p_pattern);
+}
+
+static void tilemap_pattern_scanline(const tilemap_ts * p_tilemap, int scanline, tilemap_scanline_ts * p_scanline, const void * p_hook_data)
+{
+  (void)p_tilemap;
+  const tilemap_pattern_state_ts * const p_pattern = (const tilemap_pattern_state_ts *)p_hook_data;
+  const uint64_t wave_phase = (uint64_t)scanline + (p_pattern->frame_index / 2);
+  p_scanline->scroll_x[0] += sprite_bounce(wave_phase, TILEMAP_PATTERN_WAVE_AMPLITUDE * 2) - TILEMAP_PATTERN_WAVE_AMPLITUDE;
+}
+
+static void tilemap_pattern_begin_frame(pixel_generator_ts * p_generator, int width, int height)
+{
+  tilemap_pattern_state_ts * const p_pattern = (tilemap_pattern_state_ts *)p_generator->p_state;
+  const uint64_t map_pixels = (uint64_t)(TILEMAP_PATTERN_MAP_SIZE * TILEMAP_TILE_SIZE);
+  const uint64_t frame_index = p_generator->frame_index;
+  p_pattern->frame_index = frame_index;
+
+  /* The foreground moves faster than the background, which drifts diagonally */
+  tilemap_set_scroll(p_pattern->p_tilemap, 0, (int)((frame_index / 2) % map_pixels), (int)((frame_index / 4) % map_pixels));
+  tilemap_set_scroll(p_pattern->p_tilemap, 1, (int)(frame_index % map_pixels), 0);
+
+  /* Lay out the sprites once per frame, every row band then renders the same draw list. Sprites turn around every few dozen frames */
+  sprite_draw_list_clear(&p_pattern->sprite_draw_list);
+  for (int sprite = 0; sprite < SPRITE_COUNT; sprite++)
+  {
+    const SDL_Rect rect = sprite_rect(p_generator, sprite, frame_index, width, height);
+    const SDL_Rect source_rect = sprite_atlas_tile_rect(&p_pattern->sprite_atlas, sprite % TILEMAP_PATTERN_SPRITE_TILES, TILEMAP_TILE_SIZE);
+    const int flip = (int)(((frame_index >> 5) + (uint64_t)sprite) & 0x1u) ? SPRITE_FLIP_HORIZONTAL : SPRITE_FLIP_NONE;
+    sprite_draw_list_add(&p_pattern->sprite_draw_list, &source_rect, rect.x, rect.y, flip);
+  }
+}
+
+static tilemap_pattern_state_ts * tilemap_pattern_create(uint32_t seed)
+{
+  tilemap_pattern_state_ts * const p_pattern = calloc(1, sizeof(tilemap_pattern_state_ts));
+  if (p_pattern == NULL)
+  {
+    fprintf(stderr, "\nCould not allocate tilemap pattern - Error: Calloc failed");
+    return NULL;
+  }
+
+  p_pattern->p_tilemap = tilemap_create(TILEMAP_PATTERN_TILE_COUNT, TILEMAP_PATTERN_PALETTE);
+  if (p_pattern->p_tilemap == NULL
+    || tilemap_add_layer(p_pattern->p_tilemap, TILEMAP_PATTERN_MAP_SIZE, TILEMAP_PATTERN_MAP_SIZE, 0) < 0
+    || tilemap_add_layer(p_pattern->p_tilemap, TILEMAP_PATTERN_MAP_SIZE, TILEMAP_PATTERN_MAP_SIZE, 1) < 0)
+  {
+    tilemap_pattern_free_state(p_pattern);
+    return NULL;
+  }
+
+  /*
+      Tile 0 stays blank. Tiles are mirrored horizontally and vertically, so random quarters still look drawn.
+      Background tiles use the two lighter colors, foreground tiles the two darker ones
+  */
+  uint8_t tile_data[TILEMAP_PATTERN_TILE_COUNT * TILEMAP_TILE_DATA_SIZE] = { 0 };
+  for (int tile = 1; tile < TILEMAP_PATTERN_TILE_COUNT; tile++)
+  {
+    const int foreground = tile >= TILEMAP_PATTERN_BACKGROUND_TILES;
+    for (int tile_y = 0; tile_y < TILEMAP_TILE_SIZE / 2; tile_y++)
+    {
+      const uint32_t row_hash = hash32(seed + ((uint32_t)((tile * TILEMAP_TILE_SIZE) + tile_y) * 0x9E3779B9u));
+      const uint8_t half_row = (uint8_t)(row_hash & 0xFu);
+      uint8_t mirrored_half_row = 0;
+      for (int bit = 0; bit < 4; bit++)
+      {
+        mirrored_half_row |= (uint8_t)(((half_row >> bit) & 0x1u) << (3 - bit));
+      }
+
+      const uint8_t row_bits = (uint8_t)((half_row << 4) | mirrored_half_row);
+      const uint8_t low_plane = foreground ? (uint8_t)(row_bits & (row_hash >> 8)) : row_bits;
+      const uint8_t high_plane = foreground ? row_bits : 0;
+      for (int mirror = 0; mirror < 2; mirror++)
+      {
+        const int data_row = mirror ? (TILEMAP_TILE_SIZE - 1 - tile_y) : tile_y;
+        tile_data[(tile * TILEMAP_TILE_DATA_SIZE) + (data_row * 2)] = low_plane;
+        tile_data[(tile * TILEMAP_TILE_DATA_SIZE) + (data_row * 2) + 1] = high_plane;
+      }
+    }
+  }
+  tilemap_set_tile_data(p_pattern->p_tilemap, 0, TILEMAP_PATTERN_TILE_COUNT, tile_data);
+
+  /* The background is covered completely, the foreground only sparsely */
+  const int foreground_tiles = TILEMAP_PATTERN_TILE_COUNT - TILEMAP_PATTERN_BACKGROUND_TILES;
+  for (int row = 0; row < TILEMAP_PATTERN_MAP_SIZE; row++)
+  {
+    for (int column = 0; column < TILEMAP_PATTERN_MAP_SIZE; column++)
+    {
+      const uint32_t cell_hash = hash32(seed ^ ((uint32_t)((row * TILEMAP_PATTERN_MAP_SIZE) + column) * 0x632BE5ABu));
+      tilemap_set_tile(p_pattern->p_tilemap, 0, column, row, 1 + (int)(cell_hash % (TILEMAP_PATTERN_BACKGROUND_TILES - 1)));
+      if (((cell_hash >> 16) & 0x7u) == 0)
+        tilemap_set_tile(p_pattern->p_tilemap, 1, column, row, TILEMAP_PATTERN_BACKGROUND_TILES + (int)((cell_hash >> 20) % (uint32_t)foreground_tiles));
+    }
+  }
+  tilemap_set_scanline_hook(p_pattern->p_tilemap, tilemap_pattern_scanline, p_pattern);
+
+  /* Sprites are discs and triangles drawn over the color key, each in one of the darker palette colors */
+  const client_framebuffer_ts sprite_framebuffer = {
+    p_pattern->sprite_pixels,
+    TILEMAP_PATTERN_SPRITE_TILES * TILEMAP_TILE_SIZE,
+    TILEMAP_TILE_SIZE,
+    (int)sizeof(client_pixel_rgba_ts) * TILEMAP_PATTERN_SPRITE_TILES * TILEMAP_TILE_SIZE
+  };
+  raster_target_ts sprite_target;
+  raster_target_init(&sprite_target, &sprite_framebuffer);
+  const SDL_Rect sprite_atlas_rect = { 0, 0, sprite_framebuffer.width, sprite_framebuffer.height };
+  raster_rect_fill(&sprite_target, &sprite_atlas_rect, TILEMAP_PATTERN_SPRITE_KEY);
+  for (int tile = 0; tile < TILEMAP_PATTERN_SPRITE_TILES; tile++)
+  {
+    const int tile_x = tile * TILEMAP_TILE_SIZE;
+    const client_pixel_rgba_ts sprite_color = TILEMAP_PATTERN_PALETTE[2 + (tile & 0x1)];
+    if (tile < TILEMAP_PATTERN_SPRITE_TILES / 2)
+      raster_circle_fill(&sprite_target, tile_x + 3, 3, 3, sprite_color);
+    else
+      raster_triangle_fill(&sprite_target, tile_x, TILEMAP_TILE_SIZE, tile_x + TILEMAP_TILE_SIZE, TILEMAP_TILE_SIZE / 2, tile_x, 0, sprite_color);
+  }
+
+  if (sprite_atlas_init(&p_pattern->sprite_atlas, &sprite_framebuffer, SPRITE_TRANSPARENCY_COLOR_KEY, TILEMAP_PATTERN_SPRITE_KEY) != 0
+    || sprite_draw_list_init(&p_pattern->sprite_draw_list, &p_pattern->sprite_atlas, SPRITE_COUNT) != 0)
+  {
+    tilemap_pattern_free_state(p_pattern);
+    return NULL;
+  }
+  return p_pattern;
+}
+
+static void tilemap_pattern_fill_rows(const pixel_generator_ts * p_generator, const client_framebuffer_ts * p_framebuffer, int row_begin, int row_end)
+{
+  const tilemap_pattern_state_ts * const p_pattern = (const tilemap_pattern_state_ts *)p_generator->p_state;
+  tilemap_render_rows(p_pattern->p_tilemap, p_framebuffer, row_begin, row_end);
+
+  /* Draw into the rows of this band only, other bands may be drawn at the same time */
+  raster_target_ts raster_target;
+  const SDL_Rect band_rect = { 0, row_begin, p_framebuffer->width, row_end - row_begin };
+  raster_target_init(&raster_target, p_framebuffer);
+  raster_target_set_clip(&raster_target, &band_rect);
+  sprite_draw_list_render(&p_pattern->sprite_draw_list, &raster_target);
+}
+
+/* Function definitions */
+int pixel_generator_init(pixel_generator_ts * p_generator, const char * p_pattern_name, uint32_t seed)
+{
+  /* Dispatch to the widest kernel the CPU supports, the scalar kernel supports all patterns */
+  const pixel_kernel_te kernel_preference[] = { PIXEL_KERNEL_AVX2, PIXEL_KERNEL_NEON, PIXEL_KERNEL_SSE2, PIXEL_KERNEL_SCALAR };
+  for (size_t kernel_index = 0; kernel_index < SDL_arraysize(kernel_preference); kernel_index++)
+  {
+    const int init_result = pixel_generator_init_kernel(p_generator, p_pattern_name, seed, kernel_preference[kernel_index]);
+    if (init_result != PIXEL_GENERATOR_UNKNOWN_PATTERN)
+      return init_result;
+  }
+  return PIXEL_GENERATOR_UNKNOWN_PATTERN;
+}
+
+int pixel_generator_init_kernel(pixel_generator_ts * p_generator, const char * p_pattern_name, uint32_t seed, pixel_kernel_te kernel)
+{
+  if (!pixel_kernel_available(kernel))
+    return PIXEL_GENERATOR_UNKNOWN_PATTERN;
+
+  p_generator->p_name = NULL;
+  p_generator->fill_rows = NULL;
+  p_generator->fill_index_rows = NULL;
+  p_generator->collect_damage = NULL;
+  p_generator->begin_frame = NULL;
+  p_generator->free_state = NULL;
+  p_generator->p_state = NULL;
+  p_generator->kernel = kernel;
+  p_generator->seed = seed;
+  p_generator->frame_seed = 0;
+  p_generator->frame_index = 0;
+  p_generator->previous_frame_index = 0;
+
+  if (SDL_strcmp(p_pattern_name, "noise") == 0)
+  {
+    p_generator->p_name = "noise";
+    p_generator->fill_index_rows = noise_fill_index_rows;
+    switch (kernel)
+    {
+      case PIXEL_KERNEL_SCALAR:
+        p_generator->fill_rows = noise_fill_rows_scalar;
+        break;
+#ifdef PIXEL_GENERATOR_X86_KERNELS
+      case PIXEL_KERNEL_SSE2:
+        p_generator->fill_rows = noise_fill_rows_sse2;
+        break;
+      case PIXEL_KERNEL_AVX2:
+        p_generator->fill_rows = noise_fill_rows_avx2;
+        break;
+#endif
+#ifdef PIXEL_GENERATOR_NEON_KERNELS
+      case PIXEL_KERNEL_NEON:
+        p_generator->fill_rows = noise_fill_rows_neon;
+        break;
+#endif
+      default:
+        break;
+    }
+  }
+  else if (SDL_strcmp(p_pattern_name, "gradient") == 0 && kernel == PIXEL_KERNEL_SCALAR)
+  {
+    p_generator->p_name = "gradient";
+    p_generator->fill_rows = gradient_fill_rows;
+    p_generator->fill_index_rows = gradient_fill_index_rows;
+  }
+  else if (SDL_strcmp(p_pattern_name, "sprites") == 0 && kernel == PIXEL_KERNEL_SCALAR)
+  {
+    p_generator->p_name = "sprites";
+    p_generator->fill_rows = sprites_fill_rows;
+    p_generator->fill_index_rows = sprites_fill_index_rows;
+    p_generator->collect_damage = sprites_collect_damage;
+  }
+  else if (SDL_strcmp(p_pattern_name, "tilemap") == 0 && kernel == PIXEL_KERNEL_SCALAR)
+  {
+    p_generator->p_state = tilemap_pattern_create(seed);
+    if (p_generator->p_state == NULL)
+      return PIXEL_GENERATOR_ALLOCATION_FAILED;
+
+    p_generator->p_name = "tilemap";
+    p_generator->fill_rows = tilemap_pattern_fill_rows;
+    p_generator->begin_frame = tilemap_pattern_begin_frame;
+    p_generator->free_state = tilemap_pattern_free_state;
+  }
+
+  return (p_generator->fill_rows != NULL) ? 0 : PIXEL_GENERATOR_UNKNOWN_PATTERN;
+}
+
+/* Frees the pattern state, after which the generator must be initialized again before its next use */
+void pixel_generator_free(pixel_generator_ts * p_generator)
+{
+  if (p_generator->free_state != NULL)
+    p_generator->free_state(p_generator->p_state);
+
+  p_generator->free_state = NULL;
+  p_generator->p_state = NULL;
+}
+
+void pixel_generator_begin_frame(pixel_generator_ts * p_generator, uint64_t frame_index, int width, int height)
+{
+  /* One seed per frame, fully determined by the generator seed and the frame index, which may skip frames */
+  p_generator->previous_frame_index = p_generator->frame_index;
+  p_generator->frame_index = frame_index;
+  p_generator->frame_seed = hash32(p_generator->seed ^ hash32((uint32_t)frame_index ^ hash32((uint32_t)(frame_index >> 32))));
+  if (p_generator->begin_frame != NULL)
+    p_generator->begin_frame(p_generator, width, height);
+}
+
+void pixel_generator_fill(const pixel_generator_ts * p_generator, const client_framebuffer_ts * p_framebuffer)
+{
+  p_generator->fill_rows(p_generator, p_framebuffer, 0, p_framebuffer->height);
+}
+
+/* Adds the damage of the current frame, which is the whole framebuffer for patterns that change every pixel */
+void pixel_generator_collect_damage(const pixel_generator_ts * p_generator, damage_tracker_ts * p_damage)
+{
+  if (p_generator->collect_damage == NULL)
+  {
+    damage_add_all(p_damage);
+    return;
+  }
+
+  p_generator->collect_damage(p_generator, p_damage);
+}
+
+/*
+    Compares the noise of every kernel available on this CPU against the scalar noise definition
+    for a range of seeds and row widths that exercise the vector loop tails.
+    Returns the number of failed kernels
+*/
+int pixel_generator_verify_kernels(void)
+{
+  enum { VERIFY_WIDTH_MAX = 77, VERIFY_HEIGHT = 3 };
+  static client_pixel_rgba_ts reference_pixels[VERIFY_WIDTH_MAX * VERIFY_HEIGHT];
+  static client_pixel_rgba_ts kernel_pixels[VERIFY_WIDTH_MAX * VERIFY_HEIGHT];
+  const uint32_t verified_seeds[] = { 0u, 1u, 0xDEADBEEFu };
+
+  pixel_generator_ts reference_generator;
+  pixel_generator_init_kernel(&reference_generator, "noise", 0, PIXEL_KERNEL_SCALAR);
+
+  int failures = 0;
+  for (int kernel = 0; kernel < PIXEL_KERNEL_COUNT; kernel++)
+  {
+    pixel_generator_ts generator;
+    if (pixel_generator_init_kernel(&generator, "noise", 0, (pixel_kernel_te)kernel) != 0)
+      continue;
+
+    int kernel_passed = 1;
+    for (size_t seed_index = 0; seed_index < SDL_arraysize(verified_seeds) && kernel_passed; seed_index++)
+    {
+      for (int width = 0; width <= VERIFY_WIDTH_MAX && kernel_passed; width++)
+      {
+        const client_framebuffer_ts reference_framebuffer = { reference_pixels, width, VERIFY_HEIGHT, (int)sizeof(client_pixel_rgba_ts) * width };
+        const client_framebuffer_ts kernel_framebuffer = { kernel_pixels, width, VERIFY_HEIGHT, (int)sizeof(client_pixel_rgba_ts) * width };
+
+        reference_generator.seed = verified_seeds[seed_index];
+        generator.seed = verified_seeds[seed_index];
+        pixel_generator_begin_frame(&reference_generator, (uint64_t)width, width, VERIFY_HEIGHT);
+        pixel_generator_begin_frame(&generator, (uint64_t)width, width, VERIFY_HEIGHT);
+
+        pixel_generator_fill(&reference_generator, &reference_framebuffer);
+        pixel_generator_fill(&generator, &kernel_framebuffer);
+        if (SDL_memcmp(reference_pixels, kernel_pixels, sizeof(client_pixel_rgba_ts) * width * VERIFY_HEIGHT) != 0)
+        {
+          fprintf(stdout, "FAIL  noise %-8s seed 0x%08X width %d\n", pixel_kernel_name(generator.kernel), (unsigned int)verified_seeds[seed_index], width);
+          kernel_passed = 0;
+          failures++;
+        }
+      }
+    }
+
+    if (kernel_passed)
+      fprintf(stdout, "PASS  noise %s\n", pixel_kernel_name(generator.kernel));
+  }
+
+  return failures;
+}
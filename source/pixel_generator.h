@@ -0,0 +1,74 @@
+#ifndef PIXEL_GENERATOR_H
+#define PIXEL_GENERATOR_H
+
+#include <stdint.h>
+#include "client_pixels.h"
+#include "pixel_convert.h"
+#include "damage.h"
+
+/* Defines */
+#define PIXEL_GENERATOR_UNKNOWN_PATTERN (-1)
+#define PIXEL_GENERATOR_ALLOCATION_FAILED (-2)
+
+/* Datatypes */
+typedef struct pixel_generator_s pixel_generator_ts;
+
+/*
+    Fills the rows [row_begin, row_end) of the framebuffer for the current frame.
+    Rows only depend on the generator frame state, so disjoint row ranges may be filled in any order
+*/
+typedef void (* pixel_generator_fill_rows_tf)(
+  const pixel_generator_ts * p_generator,
+  const client_framebuffer_ts * p_framebuffer,
+  int row_begin,
+  int row_end
+);
+
+/* Fills the rows [row_begin, row_end) of an indexed framebuffer with the palette indices of the current frame */
+typedef void (* pixel_generator_fill_index_rows_tf)(
+  const pixel_generator_ts * p_generator,
+  const client_framebuffer_indexed_ts * p_framebuffer,
+  int row_begin,
+  int row_end
+);
+
+/*
+    Adds the regions whose pixels differ from the previous frame to the damage tracker.
+    Pixels outside of these regions must be left exactly as the previous frame filled them
+*/
+typedef void (* pixel_generator_collect_damage_tf)(
+  const pixel_generator_ts * p_generator,
+  damage_tracker_ts * p_damage
+);
+
+/* Advances the pattern state to the current frame of the given framebuffer size, before any of its rows are filled */
+typedef void (* pixel_generator_begin_frame_tf)(pixel_generator_ts * p_generator, int width, int height);
+
+/* Frees the state a pattern allocated when it was initialized */
+typedef void (* pixel_generator_free_state_tf)(void * p_state);
+
+struct pixel_generator_s {
+  const char * p_name;
+  pixel_generator_fill_rows_tf fill_rows;
+  pixel_generator_fill_index_rows_tf fill_index_rows;
+  pixel_generator_collect_damage_tf collect_damage;
+  pixel_generator_begin_frame_tf begin_frame;
+  pixel_generator_free_state_tf free_state;
+  void * p_state;
+  pixel_kernel_te kernel;
+  uint32_t seed;
+  uint32_t frame_seed;
+  uint64_t frame_index;
+  uint64_t previous_frame_index;
+};
+
+/* Function prototypes */
+int pixel_generator_init(pixel_generator_ts * p_generator, const char * p_pattern_name, uint32_t seed);
+int pixel_generator_init_kernel(pixel_generator_ts * p_generator, const char * p_pattern_name, uint32_t seed, pixel_kernel_te kernel);
+void pixel_generator_free(pixel_generator_ts * p_generator);
+void pixel_generator_begin_frame(pixel_generator_ts * p_generator, uint64_t frame_index, int width, int height);
+void pixel_generator_fill(const pixel_generator_ts * p_generator, const client_framebuffer_ts * p_framebuffer);
+void pixel_generator_collect_damage(const pixel_generator_ts * p_generator, damage_tracker_ts * p_damage);
+int pixel_generator_verify_kernels(void);
+
+#endif
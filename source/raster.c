@@ -0,0 +1,631 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <SDL.h>
+#include "raster.h"
+
+/* Spans are filled with 128-bit stores where the target provides them unconditionally */
+#if defined(__SSE2__)
+#define RASTER_SSE2_STORES
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#define RASTER_NEON_STORES
+#include <arm_neon.h>
+#endif
+
+/* Fills a run of consecutive pixels with the same color */
+static void raster_fill_pixels(client_pixel_rgba_ts * p_pixels, int pixel_count, client_pixel_rgba_ts color)
+{
+  int pixel_x = 0;
+
+#if defined(RASTER_SSE2_STORES) || defined(RASTER_NEON_STORES)
+  /* The packed color keeps the byte order of the pixel, so the wide stores are independent of the endianness */
+  uint32_t packed_color;
+  SDL_memcpy(&packed_color, &color, sizeof(packed_color));
+#endif
+
+#if defined(RASTER_SSE2_STORES)
+  const __m128i colors = _mm_set1_epi32((int)packed_color);
+  for (; pixel_x + 8 <= pixel_count; pixel_x += 8)
+  {
+    _mm_storeu_si128((__m128i *)(p_pixels + pixel_x), colors);
+    _mm_storeu_si128((__m128i *)(p_pixels + pixel_x + 4), colors);
+  }
+  for (; pixel_x + 4 <= pixel_count; pixel_x += 4)
+  {
+    _mm_storeu_si128((__m128i *)(p_pixels + pixel_x), colors);
+  }
+#elif defined(RASTER_NEON_STORES)
+  const uint32x4_t colors = vdupq_n_u32(packed_color);
+  for (; pixel_x + 8 <= pixel_count; pixel_x += 8)
+  {
+    vst1q_u32((uint32_t *)(p_pixels + pixel_x), colors);
+    vst1q_u32((uint32_t *)(p_pixels + pixel_x + 4), colors);
+  }
+  for (; pixel_x + 4 <= pixel_count; pixel_x += 4)
+  {
+    vst1q_u32((uint32_t *)(p_pixels + pixel_x), colors);
+  }
+#endif
+
+  for (; pixel_x < pixel_count; pixel_x++)
+  {
+    p_pixels[pixel_x] = color;
+  }
+}
+
+/* Rounds the quotient towards positive infinity, for positive denominators */
+static int64_t raster_ceil_div(int64_t numerator, int64_t denominator)
+{
+  const int64_t quotient = numerator / denominator;
+  return ((numerator % denominator) > 0) ? quotient + 1 : quotient;
+}
+
+/*
+    First pixel column whose center lies at or right of the edge from (x_top, y_top) to (x_bottom, y_bottom),
+    measured at the center of the row. Vertices lie on pixel corners and y_top must be less than y_bottom
+*/
+static int raster_edge_column(int x_top, int y_top, int x_bottom, int y_bottom, int y)
+{
+  const int64_t double_height = 2 * ((int64_t)y_bottom - y_top);
+  const int64_t numerator = (2 * (int64_t)x_top * double_height) + (2 * ((int64_t)x_bottom - x_top) * ((2 * ((int64_t)y - y_top)) + 1)) - double_height;
+  return (int)raster_ceil_div(numerator, 2 * double_height);
+}
+
+/*
+    Shrinks the half width of a circle row until the row lies on the circle of the radius. Pixels count as
+    inside while x * x + y * y <= radius * radius + radius, which matches the midpoint circle algorithm
+*/
+static int raster_circle_half_width(int half_width, int row_offset, int radius)
+{
+  const int64_t limit = ((int64_t)radius * radius) + radius;
+  while (half_width > 0 && ((int64_t)half_width * half_width) + ((int64_t)row_offset * row_offset) > limit)
+  {
+    half_width--;
+  }
+  return half_width;
+}
+
+/* Verification framebuffer, with padding past every row and a clip rectangle per verification pass */
+#define RASTER_VERIFY_WIDTH (37)
+#define RASTER_VERIFY_HEIGHT (29)
+#define RASTER_VERIFY_PITCH_PIXELS (RASTER_VERIFY_WIDTH + 3)
+
+/* Plots a single pixel of the per-pixel references, if it lies inside the clip rectangle */
+static void raster_reference_point(const raster_target_ts * p_target, int64_t x, int64_t y, client_pixel_rgba_ts color)
+{
+  const SDL_Rect * const p_clip_rect = &p_target->clip_rect;
+  if (x < p_clip_rect->x || x >= p_clip_rect->x + p_clip_rect->w || y < p_clip_rect->y || y >= p_clip_rect->y + p_clip_rect->h)
+    return;
+
+  client_framebuffer_row(&p_target->framebuffer, (int)y)[x] = color;
+}
+
+/* Bresenham's algorithm pixel by pixel, with the error term walking every step of the line */
+static void raster_reference_line(const raster_target_ts * p_target, int x0, int y0, int x1, int y1, client_pixel_rgba_ts color)
+{
+  const int64_t delta_x = SDL_abs(x1 - x0);
+  const int64_t delta_y = -(int64_t)SDL_abs(y1 - y0);
+  const int step_x = (x0 < x1) ? 1 : -1;
+  const int step_y = (y0 < y1) ? 1 : -1;
+  int64_t error = delta_x + delta_y;
+  int64_t x = x0;
+  int64_t y = y0;
+  for (;;)
+  {
+    raster_reference_point(p_target, x, y, color);
+    if (x == x1 && y == y1)
+      break;
+
+    const int64_t double_error = 2 * error;
+    if (double_error >= delta_y)
+    {
+      error += delta_y;
+      x += step_x;
+    }
+    if (double_error <= delta_x)
+    {
+      error += delta_x;
+      y += step_y;
+    }
+  }
+}
+
+/* Whether the center of pixel column x lies at or right of the edge, measured at the center of row y */
+static int raster_reference_right_of_edge(int64_t x_top, int64_t y_top, int64_t x_bottom, int64_t y_bottom, int64_t x, int64_t y)
+{
+  const int64_t height = y_bottom - y_top;
+  return ((2 * x) + 1) * height >= (2 * x_top * height) + ((x_bottom - x_top) * ((2 * (y - y_top)) + 1));
+}
+
+/* Fills every pixel of the clip rectangle between the long edge and the short edge of its row */
+static void raster_reference_triangle(const raster_target_ts * p_target, const SDL_Point * p_vertices, client_pixel_rgba_ts color)
+{
+  SDL_Point sorted[3] = { p_vertices[0], p_vertices[1], p_vertices[2] };
+  for (int pass = 0; pass < 2; pass++)
+  {
+    for (int vertex = 0; vertex < 2 - pass; vertex++)
+    {
+      if (sorted[vertex + 1].y < sorted[vertex].y)
+      {
+        const SDL_Point swap = sorted[vertex];
+        sorted[vertex] = sorted[vertex + 1];
+        sorted[vertex + 1] = swap;
+      }
+    }
+  }
+
+  const SDL_Rect * const p_clip_rect = &p_target->clip_rect;
+  for (int y = p_clip_rect->y; y < p_clip_rect->y + p_clip_rect->h; y++)
+  {
+    if (y < sorted[0].y || y >= sorted[2].y)
+      continue;
+
+    const SDL_Point * const p_short_top = (y < sorted[1].y) ? &sorted[0] : &sorted[1];
+    const SDL_Point * const p_short_bottom = (y < sorted[1].y) ? &sorted[1] : &sorted[2];
+    for (int x = p_clip_rect->x; x < p_clip_rect->x + p_clip_rect->w; x++)
+    {
+      const int right_of_long_edge = raster_reference_right_of_edge(sorted[0].x, sorted[0].y, sorted[2].x, sorted[2].y, x, y);
+      const int right_of_short_edge = raster_reference_right_of_edge(p_short_top->x, p_short_top->y, p_short_bottom->x, p_short_bottom->y, x, y);
+      if (right_of_long_edge != right_of_short_edge)
+        raster_reference_point(p_target, x, y, color);
+    }
+  }
+}
+
+/* Plots every pixel of the clip rectangle inside the circle, or only the pixels of the outline the midpoint algorithm plots */
+static void raster_reference_circle(const raster_target_ts * p_target, int center_x, int center_y, int radius, int outline, client_pixel_rgba_ts color)
+{
+  if (radius < 0)
+    return;
+
+  const int64_t limit = ((int64_t)radius * radius) + radius;
+  for (int64_t offset_y = 0; offset_y <= radius; offset_y++)
+  {
+    int64_t offset_x = radius;
+    while (offset_x * offset_x + offset_y * offset_y > limit)
+    {
+      offset_x--;
+    }
+
+    if (!outline)
+    {
+      for (int64_t x = -offset_x; x <= offset_x; x++)
+      {
+        raster_reference_point(p_target, center_x + x, center_y + offset_y, color);
+        raster_reference_point(p_target, center_x + x, center_y - offset_y, color);
+      }
+    }
+    else if (offset_y <= offset_x)
+    {
+      const int64_t octant_points[8][2] = {
+        { offset_x, offset_y }, { -offset_x, offset_y }, { offset_x, -offset_y }, { -offset_x, -offset_y },
+        { offset_y, offset_x }, { -offset_y, offset_x }, { offset_y, -offset_x }, { -offset_y, -offset_x }
+      };
+      for (int point = 0; point < 8; point++)
+      {
+        raster_reference_point(p_target, center_x + octant_points[point][0], center_y + octant_points[point][1], color);
+      }
+    }
+  }
+}
+
+/* Next value of the deterministic pseudo-random coordinates of the verification, in [minimum, maximum] */
+static int raster_verify_random(uint32_t * p_random_state, int minimum, int maximum)
+{
+  *p_random_state = (*p_random_state * 1664525u) + 1013904223u;
+  return minimum + (int)((*p_random_state >> 8) % (uint32_t)(maximum - minimum + 1));
+}
+
+/* Function definitions */
+void raster_target_init(raster_target_ts * p_target, const client_framebuffer_ts * p_framebuffer)
+{
+  p_target->framebuffer = *p_framebuffer;
+  raster_target_set_clip(p_target, NULL);
+}
+
+/* Limits drawing to the clip rectangle inside the framebuffer, or to the whole framebuffer without a rectangle */
+void raster_target_set_clip(raster_target_ts * p_target, const SDL_Rect * p_clip_rect)
+{
+  const SDL_Rect framebuffer_rect = { 0, 0, p_target->framebuffer.width, p_target->framebuffer.height };
+  if (p_clip_rect == NULL)
+  {
+    p_target->clip_rect = framebuffer_rect;
+  }
+  else if (!SDL_IntersectRect(p_clip_rect, &framebuffer_rect, &p_target->clip_rect))
+  {
+    p_target->clip_rect.w = 0;
+    p_target->clip_rect.h = 0;
+  }
+}
+
+/* Fills the pixels [x_begin, x_end) of row y */
+void raster_span_horizontal(const raster_target_ts * p_target, int x_begin, int x_end, int y, client_pixel_rgba_ts color)
+{
+  const SDL_Rect * const p_clip_rect = &p_target->clip_rect;
+  if (y < p_clip_rect->y || y >= p_clip_rect->y + p_clip_rect->h)
+    return;
+
+  x_begin = SDL_max(x_begin, p_clip_rect->x);
+  x_end = SDL_min(x_end, p_clip_rect->x + p_clip_rect->w);
+  if (x_begin >= x_end)
+    return;
+
+  raster_fill_pixels(client_framebuffer_row(&p_target->framebuffer, y) + x_begin, x_end - x_begin, color);
+}
+
+/* Fills the pixels [y_begin, y_end) of column x */
+void raster_span_vertical(const raster_target_ts * p_target, int x, int y_begin, int y_end, client_pixel_rgba_ts color)
+{
+  const SDL_Rect * const p_clip_rect = &p_target->clip_rect;
+  if (x < p_clip_rect->x || x >= p_clip_rect->x + p_clip_rect->w)
+    return;
+
+  y_begin = SDL_max(y_begin, p_clip_rect->y);
+  y_end = SDL_min(y_end, p_clip_rect->y + p_clip_rect->h);
+  if (y_begin >= y_end)
+    return;
+
+  uint8_t * p_pixel = (uint8_t *)(client_framebuffer_row(&p_target->framebuffer, y_begin) + x);
+  for (int y = y_begin; y < y_end; y++)
+  {
+    *(client_pixel_rgba_ts *)p_pixel = color;
+    p_pixel += p_target->framebuffer.pitch;
+  }
+}
+
+void raster_point(const raster_target_ts * p_target, int x, int y, client_pixel_rgba_ts color)
+{
+  raster_span_horizontal(p_target, x, x + 1, y, color);
+}
+
+/*
+    Draws the line between both end points, inclusive, with the pixels of Bresenham's algorithm.
+
+    Along the major axis, step i of the line lies at minor offset (2 * minor_length * i + major_length) / (2 * major_length),
+    rounded down, which is where Bresenham's error term steps the minor axis. This turns every run of pixels sharing a minor
+    coordinate into a closed-form range of steps, so the line is clipped to the clip rectangle before drawing and only the
+    runs inside it are visited, however far the end points lie outside
+*/
+void raster_line(const raster_target_ts * p_target, int x0, int y0, int x1, int y1, client_pixel_rgba_ts color)
+{
+  const SDL_Rect * const p_clip_rect = &p_target->clip_rect;
+  if (SDL_max(x0, x1) < p_clip_rect->x || SDL_min(x0, x1) >= p_clip_rect->x + p_clip_rect->w ||
+      SDL_max(y0, y1) < p_clip_rect->y || SDL_min(y0, y1) >= p_clip_rect->y + p_clip_rect->h)
+    return;
+
+  const int shallow = (SDL_abs(x1 - x0) >= SDL_abs(y1 - y0));
+  const int64_t major_begin = shallow ? x0 : y0;
+  const int64_t minor_begin = shallow ? y0 : x0;
+  const int64_t major_length = SDL_abs(shallow ? (x1 - x0) : (y1 - y0));
+  const int64_t minor_length = SDL_abs(shallow ? (y1 - y0) : (x1 - x0));
+  const int major_step = (shallow ? (x0 < x1) : (y0 < y1)) ? 1 : -1;
+  const int minor_step = (shallow ? (y0 < y1) : (x0 < x1)) ? 1 : -1;
+  const int64_t major_clip_begin = shallow ? p_clip_rect->x : p_clip_rect->y;
+  const int64_t major_clip_end = major_clip_begin + (shallow ? p_clip_rect->w : p_clip_rect->h);
+  const int64_t minor_clip_begin = shallow ? p_clip_rect->y : p_clip_rect->x;
+  const int64_t minor_clip_end = minor_clip_begin + (shallow ? p_clip_rect->h : p_clip_rect->w);
+
+  /* Steps and minor offsets [first, last] inside the clip rectangle */
+  int64_t step_first = (major_step > 0) ? major_clip_begin - major_begin : major_begin - (major_clip_end - 1);
+  int64_t step_last = (major_step > 0) ? (major_clip_end - 1) - major_begin : major_begin - major_clip_begin;
+  step_first = SDL_max(step_first, 0);
+  step_last = SDL_min(step_last, major_length);
+  int64_t offset_first = (minor_step > 0) ? minor_clip_begin - minor_begin : minor_begin - (minor_clip_end - 1);
+  int64_t offset_last = (minor_step > 0) ? (minor_clip_end - 1) - minor_begin : minor_begin - minor_clip_begin;
+  if (major_length > 0)
+  {
+    offset_first = SDL_max(offset_first, ((2 * minor_length * step_first) + major_length) / (2 * major_length));
+    offset_last = SDL_min(offset_last, ((2 * minor_length * step_last) + major_length) / (2 * major_length));
+  }
+  else
+  {
+    offset_first = SDL_max(offset_first, 0);
+    offset_last = SDL_min(offset_last, 0);
+  }
+
+  for (int64_t offset = offset_first; offset <= offset_last; offset++)
+  {
+    /* The first step at which the minor offset reaches the offset, and the last one before it passes it */
+    int64_t run_first = step_first;
+    int64_t run_last = step_last;
+    if (minor_length > 0)
+    {
+      if (offset > 0)
+        run_first = SDL_max(run_first, raster_ceil_div((2 * major_length * offset) - major_length, 2 * minor_length));
+      if (offset < minor_length)
+        run_last = SDL_min(run_last, raster_ceil_div((2 * major_length * (offset + 1)) - major_length, 2 * minor_length) - 1);
+    }
+    if (run_first > run_last)
+      continue;
+
+    const int minor = (int)(minor_begin + (minor_step * offset));
+    const int major_first = (int)(major_begin + (major_step * run_first));
+    const int major_last = (int)(major_begin + (major_step * run_last));
+    if (shallow)
+      raster_span_horizontal(p_target, SDL_min(major_first, major_last), SDL_max(major_first, major_last) + 1, minor, color);
+    else
+      raster_span_vertical(p_target, minor, SDL_min(major_first, major_last), SDL_max(major_first, major_last) + 1, color);
+  }
+}
+
+void raster_rect_fill(const raster_target_ts * p_target, const SDL_Rect * p_rect, client_pixel_rgba_ts color)
+{
+  SDL_Rect fill_rect;
+  if (!SDL_IntersectRect(p_rect, &p_target->clip_rect, &fill_rect))
+    return;
+
+  for (int y = fill_rect.y; y < fill_rect.y + fill_rect.h; y++)
+  {
+    raster_fill_pixels(client_framebuffer_row(&p_target->framebuffer, y) + fill_rect.x, fill_rect.w, color);
+  }
+}
+
+/* Draws the one pixel wide border just inside the rectangle */
+void raster_rect_outline(const raster_target_ts * p_target, const SDL_Rect * p_rect, client_pixel_rgba_ts color)
+{
+  if (p_rect->w <= 0 || p_rect->h <= 0)
+    return;
+
+  const int x_end = p_rect->x + p_rect->w;
+  const int y_end = p_rect->y + p_rect->h;
+  raster_span_horizontal(p_target, p_rect->x, x_end, p_rect->y, color);
+  if (p_rect->h > 1)
+    raster_span_horizontal(p_target, p_rect->x, x_end, y_end - 1, color);
+
+  raster_span_vertical(p_target, p_rect->x, p_rect->y + 1, y_end - 1, color);
+  if (p_rect->w > 1)
+    raster_span_vertical(p_target, x_end - 1, p_rect->y + 1, y_end - 1, color);
+}
+
+/* Fills the circle row by row, with the half width of each row shrinking as the rows move away from the center */
+void raster_circle_fill(const raster_target_ts * p_target, int center_x, int center_y, int radius, client_pixel_rgba_ts color)
+{
+  if (radius < 0)
+    return;
+
+  int half_width = radius;
+  for (int row_offset = 0; row_offset <= radius; row_offset++)
+  {
+    half_width = raster_circle_half_width(half_width, row_offset, radius);
+    raster_span_horizontal(p_target, center_x - half_width, center_x + half_width + 1, center_y + row_offset, color);
+    if (row_offset > 0)
+      raster_span_horizontal(p_target, center_x - half_width, center_x + half_width + 1, center_y - row_offset, color);
+  }
+}
+
+/* Draws the circle with the midpoint algorithm, mirroring one octant into the other seven */
+void raster_circle_outline(const raster_target_ts * p_target, int center_x, int center_y, int radius, client_pixel_rgba_ts color)
+{
+  if (radius < 0)
+    return;
+
+  int offset_x = radius;
+  for (int offset_y = 0; offset_y <= offset_x; offset_y++)
+  {
+    offset_x = raster_circle_half_width(offset_x, offset_y, radius);
+    raster_point(p_target, center_x + offset_x, center_y + offset_y, color);
+    raster_point(p_target, center_x - offset_x, center_y + offset_y, color);
+    raster_point(p_target, center_x + offset_x, center_y - offset_y, color);
+    raster_point(p_target, center_x - offset_x, center_y - offset_y, color);
+    raster_point(p_target, center_x + offset_y, center_y + offset_x, color);
+    raster_point(p_target, center_x - offset_y, center_y + offset_x, color);
+    raster_point(p_target, center_x + offset_y, center_y - offset_x, color);
+    raster_point(p_target, center_x - offset_y, center_y - offset_x, color);
+  }
+}
+
+/*
+    Fills every pixel whose center lies inside the triangle, one span per row. Vertices lie on pixel
+    corners and the left and top edges are inclusive, so triangles sharing an edge never overlap or
+    leave gaps between them
+*/
+void raster_triangle_fill(const raster_target_ts * p_target, int x0, int y0, int x1, int y1, int x2, int y2, client_pixel_rgba_ts color)
+{
+  /* Sort the vertices from top to bottom */
+  if (y1 < y0)
+  {
+    SDL_Point swap = { x0, y0 };
+    x0 = x1; y0 = y1;
+    x1 = swap.x; y1 = swap.y;
+  }
+  if (y2 < y1)
+  {
+    SDL_Point swap = { x1, y1 };
+    x1 = x2; y1 = y2;
+    x2 = swap.x; y2 = swap.y;
+  }
+  if (y1 < y0)
+  {
+    SDL_Point swap = { x0, y0 };
+    x0 = x1; y0 = y1;
+    x1 = swap.x; y1 = swap.y;
+  }
+
+  const int y_begin = SDL_max(y0, p_target->clip_rect.y);
+  const int y_end = SDL_min(y2, p_target->clip_rect.y + p_target->clip_rect.h);
+  for (int y = y_begin; y < y_end; y++)
+  {
+    /* Every row crosses the long edge and one of the two short edges */
+    const int long_edge_x = raster_edge_column(x0, y0, x2, y2, y);
+    const int short_edge_x = (y < y1) ? raster_edge_column(x0, y0, x1, y1, y) : raster_edge_column(x1, y1, x2, y2, y);
+    raster_span_horizontal(p_target, SDL_min(long_edge_x, short_edge_x), SDL_max(long_edge_x, short_edge_x), y, color);
+  }
+}
+
+void raster_triangle_outline(const raster_target_ts * p_target, int x0, int y0, int x1, int y1, int x2, int y2, client_pixel_rgba_ts color)
+{
+  raster_line(p_target, x0, y0, x1, y1, color);
+  raster_line(p_target, x1, y1, x2, y2, color);
+  raster_line(p_target, x2, y2, x0, y0, color);
+}
+
+/*
+    Compares every primitive against a per-pixel reference, for spans of every length the wide stores split
+    into vectors and tails, coordinates far off the framebuffer, degenerate shapes and several clip rectangles.
+    The whole framebuffer is compared, including the padding past every row. Returns the number of failed primitives
+*/
+int raster_verify_primitives(void)
+{
+  enum { PRIMITIVE_SPANS = 0, PRIMITIVE_LINES, PRIMITIVE_RECTS, PRIMITIVE_CIRCLES, PRIMITIVE_TRIANGLES, PRIMITIVE_COUNT };
+  static const char * const primitive_names[PRIMITIVE_COUNT] = { "spans", "lines", "rects", "circles", "triangles" };
+  static client_pixel_rgba_ts drawn_pixels[RASTER_VERIFY_PITCH_PIXELS * RASTER_VERIFY_HEIGHT];
+  static client_pixel_rgba_ts reference_pixels[RASTER_VERIFY_PITCH_PIXELS * RASTER_VERIFY_HEIGHT];
+  const SDL_Rect clip_rects[] = {
+    { 0, 0, RASTER_VERIFY_WIDTH, RASTER_VERIFY_HEIGHT },
+    { 5, 3, RASTER_VERIFY_WIDTH - 11, RASTER_VERIFY_HEIGHT - 7 },
+    { -4, -6, 13, 11 },
+    { RASTER_VERIFY_WIDTH - 7, RASTER_VERIFY_HEIGHT - 2, 20, 20 },
+    { RASTER_VERIFY_WIDTH + 2, 0, 4, 4 }
+  };
+  const client_framebuffer_ts drawn_framebuffer = { drawn_pixels, RASTER_VERIFY_WIDTH, RASTER_VERIFY_HEIGHT, (int)sizeof(client_pixel_rgba_ts) * RASTER_VERIFY_PITCH_PIXELS };
+  const client_framebuffer_ts reference_framebuffer = { reference_pixels, RASTER_VERIFY_WIDTH, RASTER_VERIFY_HEIGHT, (int)sizeof(client_pixel_rgba_ts) * RASTER_VERIFY_PITCH_PIXELS };
+  const client_pixel_rgba_ts color = { 0xE1, 0x3C, 0x7A, 0xFF };
+
+  int failures = 0;
+  for (int primitive = 0; primitive < PRIMITIVE_COUNT; primitive++)
+  {
+    uint32_t random_state = 0x9E3779B9u + (uint32_t)primitive;
+    int failed_case = -1;
+    for (int case_index = 0; case_index < 4000 && failed_case < 0; case_index++)
+    {
+      raster_target_ts drawn_target;
+      raster_target_ts reference_target;
+      raster_target_init(&drawn_target, &drawn_framebuffer);
+      raster_target_init(&reference_target, &reference_framebuffer);
+      const SDL_Rect * const p_clip_rect = &clip_rects[case_index % SDL_arraysize(clip_rects)];
+      raster_target_set_clip(&drawn_target, p_clip_rect);
+      raster_target_set_clip(&reference_target, p_clip_rect);
+      SDL_memset(drawn_pixels, 0x5A, sizeof(drawn_pixels));
+      SDL_memset(reference_pixels, 0x5A, sizeof(reference_pixels));
+
+      /* Coordinates lie around the framebuffer or well past every edge, and every 16th case reaches far off it */
+      const int reach = (case_index % 16 == 15) ? 100000 : ((case_index / 2) % 2 == 0) ? 4 : 2 * RASTER_VERIFY_WIDTH;
+      const int x0 = raster_verify_random(&random_state, -reach, RASTER_VERIFY_WIDTH + reach);
+      const int y0 = raster_verify_random(&random_state, -reach, RASTER_VERIFY_HEIGHT + reach);
+      int x1 = raster_verify_random(&random_state, -reach, RASTER_VERIFY_WIDTH + reach);
+      int y1 = raster_verify_random(&random_state, -reach, RASTER_VERIFY_HEIGHT + reach);
+      int x2 = raster_verify_random(&random_state, -RASTER_VERIFY_WIDTH, 2 * RASTER_VERIFY_WIDTH);
+      int y2 = raster_verify_random(&random_state, -RASTER_VERIFY_HEIGHT, 2 * RASTER_VERIFY_HEIGHT);
+      switch (primitive)
+      {
+        case PRIMITIVE_SPANS:
+        {
+          /* Every length from empty to past two vectors, starting on and around the clip edges */
+          const int span_begin = (case_index % 13) - 4;
+          const int span_length = (case_index / 13) % 22;
+          const int row = raster_verify_random(&random_state, -2, RASTER_VERIFY_HEIGHT + 1);
+          const int column = raster_verify_random(&random_state, -2, RASTER_VERIFY_WIDTH + 1);
+          raster_span_horizontal(&drawn_target, span_begin, span_begin + span_length, row, color);
+          raster_span_horizontal(&drawn_target, RASTER_VERIFY_WIDTH - span_begin - span_length, RASTER_VERIFY_WIDTH - span_begin, row + 1, color);
+          raster_span_vertical(&drawn_target, column, span_begin, span_begin + span_length, color);
+          raster_point(&drawn_target, column, row, color);
+          for (int pixel = 0; pixel < span_length; pixel++)
+          {
+            raster_reference_point(&reference_target, span_begin + pixel, row, color);
+            raster_reference_point(&reference_target, RASTER_VERIFY_WIDTH - span_begin - span_length + pixel, row + 1, color);
+            raster_reference_point(&reference_target, column, span_begin + pixel, color);
+          }
+          raster_reference_point(&reference_target, column, row, color);
+          break;
+        }
+        case PRIMITIVE_LINES:
+          /* Short lines around the framebuffer and lines degenerated to a point or along an axis */
+          if (case_index % 4 == 1)
+          {
+            x1 = x0 + raster_verify_random(&random_state, -9, 9);
+            y1 = y0 + raster_verify_random(&random_state, -9, 9);
+          }
+          else if (case_index % 8 == 3)
+          {
+            x1 = (case_index % 16 == 3) ? x0 : x1;
+            y1 = (case_index % 16 == 11) ? y0 : y1;
+          }
+          raster_line(&drawn_target, x0, y0, x1, y1, color);
+          raster_reference_line(&reference_target, x0, y0, x1, y1, color);
+          break;
+        case PRIMITIVE_RECTS:
+        {
+          const SDL_Rect rect = { x2, y2, raster_verify_random(&random_state, -2, RASTER_VERIFY_WIDTH), raster_verify_random(&random_state, -2, RASTER_VERIFY_HEIGHT) };
+          if (case_index % 2 == 0)
+            raster_rect_fill(&drawn_target, &rect, color);
+          else
+            raster_rect_outline(&drawn_target, &rect, color);
+
+          for (int y = rect.y; y < rect.y + rect.h; y++)
+          {
+            for (int x = rect.x; x < rect.x + rect.w; x++)
+            {
+              const int border = (x == rect.x || y == rect.y || x == rect.x + rect.w - 1 || y == rect.y + rect.h - 1);
+              if (case_index % 2 == 0 || border)
+                raster_reference_point(&reference_target, x, y, color);
+            }
+          }
+          break;
+        }
+        case PRIMITIVE_CIRCLES:
+        {
+          const int radius = raster_verify_random(&random_state, -1, RASTER_VERIFY_WIDTH);
+          if (case_index % 2 == 0)
+            raster_circle_fill(&drawn_target, x2, y2, radius, color);
+          else
+            raster_circle_outline(&drawn_target, x2, y2, radius, color);
+          raster_reference_circle(&reference_target, x2, y2, radius, case_index % 2, color);
+          break;
+        }
+        case PRIMITIVE_TRIANGLES:
+        {
+          /* Besides general triangles, collapse vertices, flatten a side or line all three vertices up */
+          if (case_index % 5 == 1)
+          {
+            x1 = x0;
+            y1 = y0;
+          }
+          else if (case_index % 5 == 2)
+          {
+            y1 = y0;
+          }
+          else if (case_index % 5 == 3)
+          {
+            x2 = x0 + (2 * (x1 - x0));
+            y2 = y0 + (2 * (y1 - y0));
+          }
+          else if (case_index % 10 == 4)
+          {
+            y1 = y0;
+            y2 = y0;
+          }
+          const SDL_Point vertices[3] = { { x0, y0 }, { x1, y1 }, { x2, y2 } };
+          if (case_index % 2 == 0)
+          {
+            raster_triangle_fill(&drawn_target, x0, y0, x1, y1, x2, y2, color);
+            raster_reference_triangle(&reference_target, vertices, color);
+          }
+          else
+          {
+            raster_triangle_outline(&drawn_target, x0, y0, x1, y1, x2, y2, color);
+            for (int edge = 0; edge < 3; edge++)
+            {
+              raster_reference_line(&reference_target, vertices[edge].x, vertices[edge].y, vertices[(edge + 1) % 3].x, vertices[(edge + 1) % 3].y, color);
+            }
+          }
+          break;
+        }
+      }
+
+      if (SDL_memcmp(drawn_pixels, reference_pixels, sizeof(drawn_pixels)) != 0)
+        failed_case = case_index;
+    }
+
+    if (failed_case >= 0)
+    {
+      fprintf(stdout, "FAIL  raster %-10s case %d\n", primitive_names[primitive], failed_case);
+      failures++;
+    }
+    else
+    {
+      fprintf(stdout, "PASS  raster %s\n", primitive_names[primitive]);
+    }
+  }
+
+  return failures;
+}
@@ -0,0 +1,34 @@
+#ifndef RASTER_H
+#define RASTER_H
+
+#include <SDL.h>
+#include "client_pixels.h"
+
+/* Datatypes */
+
+/*
+    Client-side pixels to draw into, limited to a clip rectangle inside the framebuffer.
+    Every primitive only writes the pixels inside the clip rectangle, which also lets row band
+    jobs of the worker pool draw the same primitives into their own rows only
+*/
+typedef struct {
+  client_framebuffer_ts framebuffer;
+  SDL_Rect clip_rect;
+} raster_target_ts;
+
+/* Function prototypes */
+void raster_target_init(raster_target_ts * p_target, const client_framebuffer_ts * p_framebuffer);
+void raster_target_set_clip(raster_target_ts * p_target, const SDL_Rect * p_clip_rect);
+void raster_span_horizontal(const raster_target_ts * p_target, int x_begin, int x_end, int y, client_pixel_rgba_ts color);
+void raster_span_vertical(const raster_target_ts * p_target, int x, int y_begin, int y_end, client_pixel_rgba_ts color);
+void raster_point(const raster_target_ts * p_target, int x, int y, client_pixel_rgba_ts color);
+void raster_line(const raster_target_ts * p_target, int x0, int y0, int x1, int y1, client_pixel_rgba_ts color);
+void raster_rect_fill(const raster_target_ts * p_target, const SDL_Rect * p_rect, client_pixel_rgba_ts color);
+void raster_rect_outline(const raster_target_ts * p_target, const SDL_Rect * p_rect, client_pixel_rgba_ts color);
+void raster_circle_fill(const raster_target_ts * p_target, int center_x, int center_y, int radius, client_pixel_rgba_ts color);
+void raster_circle_outline(const raster_target_ts * p_target, int center_x, int center_y, int radius, client_pixel_rgba_ts color);
+void raster_triangle_fill(const raster_target_ts * p_target, int x0, int y0, int x1, int y1, int x2, int y2, client_pixel_rgba_ts color);
+void raster_triangle_outline(const raster_target_ts * p_target, int x0, int y0, int x1, int y1, int x2, int y2, client_pixel_rgba_ts color);
+int raster_verify_primitives(void);
+
+#endif
@@ -0,0 +1,253 @@
+#include <stdint.h>
+#include "render_stages.h"
+#include "blit.h"
+
+/* Constants */
+static const char * const UPLOAD_MODE_NAMES[UPLOAD_MODE_COUNT] = { "auto", "convert", "bulk", "rows", "update" };
+
+/* Datatypes */
+typedef struct {
+  const pixel_generator_ts * p_generator;
+  const client_framebuffer_ts * p_framebuffer;
+  const client_framebuffer_indexed_ts * p_indexed_framebuffer;
+  int row_offset;
+} fill_job_ts;
+
+typedef struct {
+  const pixel_converter_ts * p_converter;
+  uint8_t * p_texture_rows;
+  int texture_pitch;
+  const client_framebuffer_ts * p_framebuffer;
+  SDL_Rect rect;
+} convert_job_ts;
+
+typedef struct {
+  const palette_ts * p_palette;
+  uint8_t * p_texture_rows;
+  int texture_pitch;
+  const client_framebuffer_indexed_ts * p_framebuffer;
+  SDL_Rect rect;
+} expand_job_ts;
+
+static void fill_rows_job(void * p_job_data, int row_begin, int row_end)
+{
+  const fill_job_ts * const p_job = (const fill_job_ts *)p_job_data;
+  if (p_job->p_indexed_framebuffer != NULL)
+    p_job->p_generator->fill_index_rows(p_job->p_generator, p_job->p_indexed_framebuffer, p_job->row_offset + row_begin, p_job->row_offset + row_end);
+  else
+    p_job->p_generator->fill_rows(p_job->p_generator, p_job->p_framebuffer, p_job->row_offset + row_begin, p_job->row_offset + row_end);
+}
+
+static void convert_blit_row(const void * p_context, void * p_destination_row, const void * p_source_row, int texel_count)
+{
+  const pixel_converter_ts * const p_converter = (const pixel_converter_ts *)p_context;
+  p_converter->convert_row(p_converter, p_destination_row, (const client_pixel_rgba_ts *)p_source_row, texel_count);
+}
+
+static void expand_blit_row(const void * p_context, void * p_destination_row, const void * p_source_row, int texel_count)
+{
+  const palette_ts * const p_palette = (const palette_ts *)p_context;
+  p_palette->expand_row(p_palette, p_destination_row, (const uint8_t *)p_source_row, texel_count);
+}
+
+static void convert_rows_job(void * p_job_data, int row_begin, int row_end)
+{
+  const convert_job_ts * const p_job = (const convert_job_ts *)p_job_data;
+  blit_rows(
+    p_job->p_texture_rows + ((ptrdiff_t)p_job->texture_pitch * row_begin),
+    p_job->texture_pitch,
+    client_framebuffer_row(p_job->p_framebuffer, p_job->rect.y + row_begin) + p_job->rect.x,
+    p_job->p_framebuffer->pitch,
+    row_end - row_begin,
+    p_job->rect.w,
+    convert_blit_row,
+    p_job->p_converter
+  );
+}
+
+static void expand_rows_job(void * p_job_data, int row_begin, int row_end)
+{
+  const expand_job_ts * const p_job = (const expand_job_ts *)p_job_data;
+  blit_rows(
+    p_job->p_texture_rows + ((ptrdiff_t)p_job->texture_pitch * row_begin),
+    p_job->texture_pitch,
+    client_framebuffer_indexed_row(p_job->p_framebuffer, p_job->rect.y + row_begin) + p_job->rect.x,
+    p_job->p_framebuffer->pitch,
+    row_end - row_begin,
+    p_job->rect.w,
+    expand_blit_row,
+    p_job->p_palette
+  );
+}
+
+/*
+    Fills only the rows touched by the damaged rectangles, relying on the generator to leave every
+    other pixel unchanged. Overlapping row ranges are merged first so that no row is filled twice
+*/
+static void fill_damaged_rows(worker_pool_ts * p_pool, fill_job_ts * p_fill_job, const damage_tracker_ts * p_damage)
+{
+  /* Sort the row ranges by their first row, there are only a handful of them */
+  SDL_Rect row_ranges[DAMAGE_MAX_RECTS];
+  int range_count = 0;
+  for (int rect_index = 0; rect_index < p_damage->rect_count; rect_index++)
+  {
+    const SDL_Rect row_range = p_damage->rects[rect_index];
+    int insert_index = range_count;
+    while (insert_index > 0 && row_ranges[insert_index - 1].y > row_range.y)
+    {
+      row_ranges[insert_index] = row_ranges[insert_index - 1];
+      insert_index--;
+    }
+    row_ranges[insert_index] = row_range;
+    range_count++;
+  }
+
+  int range_index = 0;
+  while (range_index < range_count)
+  {
+    const int row_begin = row_ranges[range_index].y;
+    int row_end = row_begin + row_ranges[range_index].h;
+    for (range_index++; range_index < range_count && row_ranges[range_index].y <= row_end; range_index++)
+    {
+      row_end = SDL_max(row_end, row_ranges[range_index].y + row_ranges[range_index].h);
+    }
+
+    p_fill_job->row_offset = row_begin;
+    worker_pool_for_rows(p_pool, row_end - row_begin, fill_rows_job, p_fill_job);
+  }
+}
+
+/* Function definitions */
+void render_stage_fill(worker_pool_ts * p_pool, const pixel_generator_ts * p_generator, const client_framebuffer_ts * p_framebuffer)
+{
+  fill_job_ts fill_job = { p_generator, p_framebuffer, NULL, 0 };
+  worker_pool_for_rows(p_pool, p_framebuffer->height, fill_rows_job, &fill_job);
+}
+
+void render_stage_fill_indexed(worker_pool_ts * p_pool, const pixel_generator_ts * p_generator, const client_framebuffer_indexed_ts * p_framebuffer)
+{
+  fill_job_ts fill_job = { p_generator, NULL, p_framebuffer, 0 };
+  worker_pool_for_rows(p_pool, p_framebuffer->height, fill_rows_job, &fill_job);
+}
+
+void render_stage_fill_damage(
+  worker_pool_ts * p_pool,
+  const pixel_generator_ts * p_generator,
+  const client_framebuffer_ts * p_framebuffer,
+  const damage_tracker_ts * p_damage
+)
+{
+  fill_job_ts fill_job = { p_generator, p_framebuffer, NULL, 0 };
+  fill_damaged_rows(p_pool, &fill_job, p_damage);
+}
+
+void render_stage_fill_indexed_damage(
+  worker_pool_ts * p_pool,
+  const pixel_generator_ts * p_generator,
+  const client_framebuffer_indexed_ts * p_framebuffer,
+  const damage_tracker_ts * p_damage
+)
+{
+  fill_job_ts fill_job = { p_generator, NULL, p_framebuffer, 0 };
+  fill_damaged_rows(p_pool, &fill_job, p_damage);
+}
+
+/*
+    Converts the client-side pixels into texture pixels with the same dimensions, honoring the texture pitch.
+    With a rectangle only that region is converted, and the texture pixels point at its top-left texel as
+    returned by SDL_LockTexture for the same rectangle. Returns once every row is converted, so the texture
+    can be unlocked right away
+*/
+void render_stage_convert(
+  worker_pool_ts * p_pool,
+  const pixel_converter_ts * p_converter,
+  void * p_texture_pixels,
+  int texture_pitch,
+  const client_framebuffer_ts * p_framebuffer,
+  const SDL_Rect * p_rect
+)
+{
+  convert_job_ts convert_job = { p_converter, (uint8_t *)p_texture_pixels, texture_pitch, p_framebuffer, { 0, 0, p_framebuffer->width, p_framebuffer->height } };
+  if (p_rect != NULL)
+    convert_job.rect = *p_rect;
+
+  worker_pool_for_rows(p_pool, convert_job.rect.h, convert_rows_job, &convert_job);
+}
+
+/* Expands palette indices into texture pixels, with the same rectangle and texture pixel conventions as the conversion */
+void render_stage_expand(
+  worker_pool_ts * p_pool,
+  const palette_ts * p_palette,
+  void * p_texture_pixels,
+  int texture_pitch,
+  const client_framebuffer_indexed_ts * p_framebuffer,
+  const SDL_Rect * p_rect
+)
+{
+  expand_job_ts expand_job = { p_palette, (uint8_t *)p_texture_pixels, texture_pitch, p_framebuffer, { 0, 0, p_framebuffer->width, p_framebuffer->height } };
+  if (p_rect != NULL)
+    expand_job.rect = *p_rect;
+
+  worker_pool_for_rows(p_pool, expand_job.rect.h, expand_rows_job, &expand_job);
+}
+
+/*
+    Copies the client-side pixels into texture pixels laid out exactly like them, with the same rectangle and
+    texture pixel conventions as the conversion. Rows that are contiguous in both buffers, which requires a
+    full width rectangle and equal pitches, are copied at once, otherwise the copy falls back to one per row
+*/
+void render_stage_copy_bulk(void * p_texture_pixels, int texture_pitch, const client_framebuffer_ts * p_framebuffer, const SDL_Rect * p_rect)
+{
+  const SDL_Rect rect = (p_rect != NULL) ? *p_rect : (SDL_Rect){ 0, 0, p_framebuffer->width, p_framebuffer->height };
+  blit_rows_copy_bulk(
+    p_texture_pixels,
+    texture_pitch,
+    client_framebuffer_row(p_framebuffer, rect.y) + rect.x,
+    p_framebuffer->pitch,
+    rect.h,
+    sizeof(client_pixel_rgba_ts) * (size_t)rect.w
+  );
+}
+
+/* Copies the client-side pixels into texture pixels laid out exactly like them one row at a time, honoring both pitches */
+void render_stage_copy_rows(void * p_texture_pixels, int texture_pitch, const client_framebuffer_ts * p_framebuffer, const SDL_Rect * p_rect)
+{
+  const SDL_Rect rect = (p_rect != NULL) ? *p_rect : (SDL_Rect){ 0, 0, p_framebuffer->width, p_framebuffer->height };
+  blit_rows_copy(
+    p_texture_pixels,
+    texture_pitch,
+    client_framebuffer_row(p_framebuffer, rect.y) + rect.x,
+    p_framebuffer->pitch,
+    rect.h,
+    sizeof(client_pixel_rgba_ts) * (size_t)rect.w
+  );
+}
+
+/*
+    Uploads the client-side pixels of the rectangle straight from the client-side buffer, without locking.
+    Renderers with textures in video memory can upload from there directly instead of going through the
+    staging pixels of a lock. Returns 0 on success and -1 on failure
+*/
+int render_stage_update(SDL_Texture * p_texture, const client_framebuffer_ts * p_framebuffer, const SDL_Rect * p_rect)
+{
+  const SDL_Rect rect = (p_rect != NULL) ? *p_rect : (SDL_Rect){ 0, 0, p_framebuffer->width, p_framebuffer->height };
+  return SDL_UpdateTexture(p_texture, &rect, client_framebuffer_row(p_framebuffer, rect.y) + rect.x, p_framebuffer->pitch);
+}
+
+const char * upload_mode_name(upload_mode_te upload_mode)
+{
+  return ((int)upload_mode >= 0 && upload_mode < UPLOAD_MODE_COUNT) ? UPLOAD_MODE_NAMES[upload_mode] : "unknown";
+}
+
+int upload_mode_from_name(const char * p_mode_name, upload_mode_te * p_upload_mode)
+{
+  for (int upload_mode = 0; upload_mode < UPLOAD_MODE_COUNT; upload_mode++)
+  {
+    if (SDL_strcmp(p_mode_name, UPLOAD_MODE_NAMES[upload_mode]) == 0)
+    {
+      *p_upload_mode = (upload_mode_te)upload_mode;
+      return 0;
+    }
+  }
+  return -1;
+}
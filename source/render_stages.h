@@ -0,0 +1,59 @@
+#ifndef RENDER_STAGES_H
+#define RENDER_STAGES_H
+
+#include <SDL.h>
+#include "client_pixels.h"
+#include "pixel_convert.h"
+#include "pixel_generator.h"
+#include "worker_pool.h"
+#include "damage.h"
+#include "palette.h"
+
+/* Datatypes */
+typedef enum {
+  UPLOAD_MODE_AUTO = 0,
+  UPLOAD_MODE_CONVERT,
+  UPLOAD_MODE_BULK,
+  UPLOAD_MODE_ROWS,
+  UPLOAD_MODE_UPDATE,
+  UPLOAD_MODE_COUNT
+} upload_mode_te;
+
+/* Function prototypes */
+void render_stage_fill(worker_pool_ts * p_pool, const pixel_generator_ts * p_generator, const client_framebuffer_ts * p_framebuffer);
+void render_stage_fill_indexed(worker_pool_ts * p_pool, const pixel_generator_ts * p_generator, const client_framebuffer_indexed_ts * p_framebuffer);
+void render_stage_fill_damage(
+  worker_pool_ts * p_pool,
+  const pixel_generator_ts * p_generator,
+  const client_framebuffer_ts * p_framebuffer,
+  const damage_tracker_ts * p_damage
+);
+void render_stage_fill_indexed_damage(
+  worker_pool_ts * p_pool,
+  const pixel_generator_ts * p_generator,
+  const client_framebuffer_indexed_ts * p_framebuffer,
+  const damage_tracker_ts * p_damage
+);
+void render_stage_convert(
+  worker_pool_ts * p_pool,
+  const pixel_converter_ts * p_converter,
+  void * p_texture_pixels,
+  int texture_pitch,
+  const client_framebuffer_ts * p_framebuffer,
+  const SDL_Rect * p_rect
+);
+void render_stage_expand(
+  worker_pool_ts * p_pool,
+  const palette_ts * p_palette,
+  void * p_texture_pixels,
+  int texture_pitch,
+  const client_framebuffer_indexed_ts * p_framebuffer,
+  const SDL_Rect * p_rect
+);
+void render_stage_copy_bulk(void * p_texture_pixels, int texture_pitch, const client_framebuffer_ts * p_framebuffer, const SDL_Rect * p_rect);
+void render_stage_copy_rows(void * p_texture_pixels, int texture_pitch, const client_framebuffer_ts * p_framebuffer, const SDL_Rect * p_rect);
+int render_stage_update(SDL_Texture * p_texture, const client_framebuffer_ts * p_framebuffer, const SDL_Rect * p_rect);
+const char * upload_mode_name(upload_mode_te upload_mode);
+int upload_mode_from_name(const char * p_mode_name, upload_mode_te * p_upload_mode);
+
+#endif
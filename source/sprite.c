@@ -0,0 +1,418 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <SDL.h>
+#include "sprite.h"
+
+static int sprite_pixel_opaque(client_pixel_rgba_ts pixel, sprite_transparency_te transparency, client_pixel_rgba_ts color_key)
+{
+  switch (transparency)
+  {
+    case SPRITE_TRANSPARENCY_COLOR_KEY:
+      return pixel.red != color_key.red || pixel.green != color_key.green || pixel.blue != color_key.blue;
+    case SPRITE_TRANSPARENCY_MASK:
+      /* The top bit of the alpha channel is the 1-bit mask */
+      return (pixel.alpha & 0x80) != 0;
+    default:
+      return 1;
+  }
+}
+
+/* Finds the opaque runs of every atlas row, only counting them when there is no span storage yet */
+static int sprite_atlas_find_spans(sprite_atlas_ts * p_atlas, sprite_transparency_te transparency, client_pixel_rgba_ts color_key)
+{
+  int span_count = 0;
+  for (int row = 0; row < p_atlas->pixels.height; row++)
+  {
+    const client_pixel_rgba_ts * const p_row = client_framebuffer_row(&p_atlas->pixels, row);
+    if (p_atlas->p_row_spans != NULL)
+      p_atlas->p_row_spans[row] = span_count;
+
+    int pixel_x = 0;
+    while (pixel_x < p_atlas->pixels.width)
+    {
+      while (pixel_x < p_atlas->pixels.width && !sprite_pixel_opaque(p_row[pixel_x], transparency, color_key))
+        pixel_x++;
+
+      const int x_begin = pixel_x;
+      while (pixel_x < p_atlas->pixels.width && sprite_pixel_opaque(p_row[pixel_x], transparency, color_key))
+        pixel_x++;
+
+      if (pixel_x > x_begin)
+      {
+        if (p_atlas->p_spans != NULL)
+        {
+          p_atlas->p_spans[span_count].x_begin = x_begin;
+          p_atlas->p_spans[span_count].x_end = pixel_x;
+        }
+        span_count++;
+      }
+    }
+  }
+
+  if (p_atlas->p_row_spans != NULL)
+    p_atlas->p_row_spans[p_atlas->pixels.height] = span_count;
+  return span_count;
+}
+
+/* Copies the atlas pixels [source_x, source_x + pixel_count) into the destination in reverse order */
+static void sprite_copy_reversed(client_pixel_rgba_ts * p_destination, const client_pixel_rgba_ts * p_source, int pixel_count)
+{
+  for (int pixel_x = 0; pixel_x < pixel_count; pixel_x++)
+  {
+    p_destination[pixel_x] = p_source[pixel_count - 1 - pixel_x];
+  }
+}
+
+/* Verification atlas and target, both with padding past every row */
+#define SPRITE_VERIFY_ATLAS_WIDTH (24)
+#define SPRITE_VERIFY_ATLAS_HEIGHT (16)
+#define SPRITE_VERIFY_ATLAS_PITCH_PIXELS (SPRITE_VERIFY_ATLAS_WIDTH + 2)
+#define SPRITE_VERIFY_TARGET_WIDTH (31)
+#define SPRITE_VERIFY_TARGET_HEIGHT (21)
+#define SPRITE_VERIFY_TARGET_PITCH_PIXELS (SPRITE_VERIFY_TARGET_WIDTH + 3)
+
+/*
+    Reference blit testing every pixel of the requested rectangle on its own. Pixel (u, v) of the rectangle is drawn at
+    (x + u, y + v), mirrored within the rectangle by the flips, if it lies inside the atlas, is opaque and lands in the clip rectangle
+*/
+static void sprite_reference_blit(const raster_target_ts * p_target, const client_framebuffer_ts * p_atlas_pixels, sprite_transparency_te transparency, client_pixel_rgba_ts color_key, const SDL_Rect * p_source_rect, int x, int y, int flip)
+{
+  const SDL_Rect * const p_clip_rect = &p_target->clip_rect;
+  for (int v = 0; v < p_source_rect->h; v++)
+  {
+    for (int u = 0; u < p_source_rect->w; u++)
+    {
+      const int atlas_x = p_source_rect->x + u;
+      const int atlas_y = p_source_rect->y + v;
+      const int target_x = x + ((flip & SPRITE_FLIP_HORIZONTAL) ? p_source_rect->w - 1 - u : u);
+      const int target_y = y + ((flip & SPRITE_FLIP_VERTICAL) ? p_source_rect->h - 1 - v : v);
+      if (atlas_x < 0 || atlas_x >= p_atlas_pixels->width || atlas_y < 0 || atlas_y >= p_atlas_pixels->height)
+        continue;
+      if (target_x < p_clip_rect->x || target_x >= p_clip_rect->x + p_clip_rect->w || target_y < p_clip_rect->y || target_y >= p_clip_rect->y + p_clip_rect->h)
+        continue;
+
+      /* Color keys compare the color channels only, masks keep pixels with an alpha of at least half */
+      const client_pixel_rgba_ts pixel = client_framebuffer_row(p_atlas_pixels, atlas_y)[atlas_x];
+      const int keyed = (pixel.red == color_key.red && pixel.green == color_key.green && pixel.blue == color_key.blue);
+      if ((transparency == SPRITE_TRANSPARENCY_COLOR_KEY && keyed) || (transparency == SPRITE_TRANSPARENCY_MASK && pixel.alpha < 0x80))
+        continue;
+
+      client_framebuffer_row(&p_target->framebuffer, target_y)[target_x] = pixel;
+    }
+  }
+}
+
+/* Next value of the deterministic pseudo-random verification cases, in [minimum, maximum] */
+static int sprite_verify_random(uint32_t * p_random_state, int minimum, int maximum)
+{
+  *p_random_state = (*p_random_state * 1664525u) + 1013904223u;
+  return minimum + (int)((*p_random_state >> 8) % (uint32_t)(maximum - minimum + 1));
+}
+
+/* Function definitions */
+
+/*
+    Prepares the atlas for blitting. The atlas refers to the pixels rather than copying them, so they
+    must outlive the atlas and must not change their transparency afterwards. Returns 0 on success and -1 on failure
+*/
+int sprite_atlas_init(sprite_atlas_ts * p_atlas, const client_framebuffer_ts * p_pixels, sprite_transparency_te transparency, client_pixel_rgba_ts color_key)
+{
+  p_atlas->pixels = *p_pixels;
+  p_atlas->p_spans = NULL;
+  p_atlas->p_row_spans = NULL;
+
+  const int span_count = sprite_atlas_find_spans(p_atlas, transparency, color_key);
+  p_atlas->p_spans = malloc(sizeof(sprite_span_ts) * (size_t)SDL_max(1, span_count));
+  p_atlas->p_row_spans = malloc(sizeof(int) * ((size_t)p_pixels->height + 1));
+  if (p_atlas->p_spans == NULL || p_atlas->p_row_spans == NULL)
+  {
+    fprintf(stderr, "\nCould not allocate sprite atlas spans - Error: Malloc failed");
+    sprite_atlas_free(p_atlas);
+    return -1;
+  }
+
+  sprite_atlas_find_spans(p_atlas, transparency, color_key);
+  return 0;
+}
+
+void sprite_atlas_free(sprite_atlas_ts * p_atlas)
+{
+  free(p_atlas->p_spans);
+  free(p_atlas->p_row_spans);
+  p_atlas->p_spans = NULL;
+  p_atlas->p_row_spans = NULL;
+}
+
+/* Returns the rectangle of a square tile, with the tiles numbered row by row across the atlas */
+SDL_Rect sprite_atlas_tile_rect(const sprite_atlas_ts * p_atlas, int tile_index, int tile_size)
+{
+  const int tiles_per_row = SDL_max(1, p_atlas->pixels.width / tile_size);
+  const SDL_Rect tile_rect = { (tile_index % tiles_per_row) * tile_size, (tile_index / tiles_per_row) * tile_size, tile_size, tile_size };
+  return tile_rect;
+}
+
+/*
+    Draws the opaque pixels of the atlas rectangle with its top-left corner at (x, y), flipped as requested.
+    Clipping is resolved once per blit into the visible rows and the matching atlas columns, after which
+    every opaque run of an atlas row is intersected with those columns and copied as a whole
+*/
+void sprite_blit(const raster_target_ts * p_target, const sprite_atlas_ts * p_atlas, const SDL_Rect * p_source_rect, int x, int y, int flip)
+{
+  const SDL_Rect atlas_rect = { 0, 0, p_atlas->pixels.width, p_atlas->pixels.height };
+  SDL_Rect source_rect;
+  if (!SDL_IntersectRect(p_source_rect, &atlas_rect, &source_rect))
+    return;
+
+  /* Parts of the requested rectangle outside the atlas stay where they would have been drawn */
+  const int sprite_x = x + ((flip & SPRITE_FLIP_HORIZONTAL) ? (p_source_rect->x + p_source_rect->w) - (source_rect.x + source_rect.w) : source_rect.x - p_source_rect->x);
+  const int sprite_y = y + ((flip & SPRITE_FLIP_VERTICAL) ? (p_source_rect->y + p_source_rect->h) - (source_rect.y + source_rect.h) : source_rect.y - p_source_rect->y);
+  const SDL_Rect sprite_rect = { sprite_x, sprite_y, source_rect.w, source_rect.h };
+  SDL_Rect visible_rect;
+  if (!SDL_IntersectRect(&sprite_rect, &p_target->clip_rect, &visible_rect))
+    return;
+
+  /* Atlas columns [column_begin, column_end) land on the visible columns, mirrored for horizontal flips */
+  const int horizontal_flip = (flip & SPRITE_FLIP_HORIZONTAL) != 0;
+  const int column_offset = visible_rect.x - sprite_rect.x;
+  const int column_begin = horizontal_flip
+    ? source_rect.x + source_rect.w - column_offset - visible_rect.w
+    : source_rect.x + column_offset;
+  const int column_end = column_begin + visible_rect.w;
+
+  for (int row = visible_rect.y; row < visible_rect.y + visible_rect.h; row++)
+  {
+    const int atlas_row = (flip & SPRITE_FLIP_VERTICAL)
+      ? source_rect.y + source_rect.h - 1 - (row - sprite_rect.y)
+      : source_rect.y + (row - sprite_rect.y);
+    const client_pixel_rgba_ts * const p_atlas_row = client_framebuffer_row(&p_atlas->pixels, atlas_row);
+    client_pixel_rgba_ts * const p_target_row = client_framebuffer_row(&p_target->framebuffer, row);
+
+    const sprite_span_ts * const p_spans_end = p_atlas->p_spans + p_atlas->p_row_spans[atlas_row + 1];
+    for (const sprite_span_ts * p_span = p_atlas->p_spans + p_atlas->p_row_spans[atlas_row]; p_span < p_spans_end; p_span++)
+    {
+      const int span_begin = SDL_max(p_span->x_begin, column_begin);
+      const int span_end = SDL_min(p_span->x_end, column_end);
+      if (span_begin >= span_end)
+        continue;
+
+      if (horizontal_flip)
+      {
+        const int target_x = sprite_rect.x + (source_rect.x + source_rect.w - span_end);
+        sprite_copy_reversed(p_target_row + target_x, p_atlas_row + span_begin, span_end - span_begin);
+      }
+      else
+      {
+        const int target_x = sprite_rect.x + (span_begin - source_rect.x);
+        SDL_memcpy(p_target_row + target_x, p_atlas_row + span_begin, sizeof(client_pixel_rgba_ts) * (size_t)(span_end - span_begin));
+      }
+    }
+  }
+}
+
+/* Returns 0 on success and -1 on failure */
+int sprite_draw_list_init(sprite_draw_list_ts * p_draw_list, const sprite_atlas_ts * p_atlas, int draw_capacity)
+{
+  p_draw_list->p_atlas = p_atlas;
+  p_draw_list->draw_count = 0;
+  p_draw_list->draw_capacity = SDL_max(1, draw_capacity);
+  p_draw_list->p_draws = malloc(sizeof(sprite_draw_ts) * (size_t)p_draw_list->draw_capacity);
+  if (p_draw_list->p_draws == NULL)
+  {
+    fprintf(stderr, "\nCould not allocate sprite draw list - Error: Malloc failed");
+    p_draw_list->draw_capacity = 0;
+    return -1;
+  }
+  return 0;
+}
+
+void sprite_draw_list_free(sprite_draw_list_ts * p_draw_list)
+{
+  free(p_draw_list->p_draws);
+  p_draw_list->p_draws = NULL;
+  p_draw_list->draw_count = 0;
+  p_draw_list->draw_capacity = 0;
+}
+
+void sprite_draw_list_clear(sprite_draw_list_ts * p_draw_list)
+{
+  p_draw_list->draw_count = 0;
+}
+
+/* Appends a sprite, growing the list as needed. Returns 0 on success and -1 on failure */
+int sprite_draw_list_add(sprite_draw_list_ts * p_draw_list, const SDL_Rect * p_source_rect, int x, int y, int flip)
+{
+  if (p_draw_list->draw_count == p_draw_list->draw_capacity)
+  {
+    const int draw_capacity = SDL_max(1, p_draw_list->draw_capacity * 2);
+    sprite_draw_ts * const p_draws = realloc(p_draw_list->p_draws, sizeof(sprite_draw_ts) * (size_t)draw_capacity);
+    if (p_draws == NULL)
+    {
+      fprintf(stderr, "\nCould not grow sprite draw list - Error: Realloc failed");
+      return -1;
+    }
+    p_draw_list->p_draws = p_draws;
+    p_draw_list->draw_capacity = draw_capacity;
+  }
+
+  sprite_draw_ts * const p_draw = &p_draw_list->p_draws[p_draw_list->draw_count++];
+  p_draw->source_rect = *p_source_rect;
+  p_draw->x = x;
+  p_draw->y = y;
+  p_draw->flip = flip;
+  return 0;
+}
+
+/*
+    Draws every sprite of the list in order. Only the target is written, so row band jobs may render the
+    same list at the same time into disjoint clip rectangles, each skipping the sprites outside its band
+*/
+void sprite_draw_list_render(const sprite_draw_list_ts * p_draw_list, const raster_target_ts * p_target)
+{
+  const SDL_Rect * const p_clip_rect = &p_target->clip_rect;
+  for (int draw_index = 0; draw_index < p_draw_list->draw_count; draw_index++)
+  {
+    const sprite_draw_ts * const p_draw = &p_draw_list->p_draws[draw_index];
+    if (p_draw->y >= p_clip_rect->y + p_clip_rect->h || p_draw->y + p_draw->source_rect.h <= p_clip_rect->y)
+      continue;
+
+    sprite_blit(p_target, p_draw_list->p_atlas, &p_draw->source_rect, p_draw->x, p_draw->y, p_draw->flip);
+  }
+}
+
+/*
+    Compares blits against the per-pixel reference blit for every transparency mode and all four flips, with sprites
+    clipped by every edge of the target and of a clip rectangle, sprites fully off the target and rectangles reaching
+    past the atlas. Draw lists are rendered in row bands and compared with blitting their sprites in order.
+    The whole target is compared, including the padding past every row. Returns the number of failed checks
+*/
+int sprite_verify_blits(void)
+{
+  static const char * const transparency_names[] = { "opaque", "color-key", "mask" };
+  static client_pixel_rgba_ts atlas_pixels[SPRITE_VERIFY_ATLAS_PITCH_PIXELS * SPRITE_VERIFY_ATLAS_HEIGHT];
+  static client_pixel_rgba_ts drawn_pixels[SPRITE_VERIFY_TARGET_PITCH_PIXELS * SPRITE_VERIFY_TARGET_HEIGHT];
+  static client_pixel_rgba_ts reference_pixels[SPRITE_VERIFY_TARGET_PITCH_PIXELS * SPRITE_VERIFY_TARGET_HEIGHT];
+  const client_framebuffer_ts atlas_framebuffer = { atlas_pixels, SPRITE_VERIFY_ATLAS_WIDTH, SPRITE_VERIFY_ATLAS_HEIGHT, (int)sizeof(client_pixel_rgba_ts) * SPRITE_VERIFY_ATLAS_PITCH_PIXELS };
+  const client_framebuffer_ts drawn_framebuffer = { drawn_pixels, SPRITE_VERIFY_TARGET_WIDTH, SPRITE_VERIFY_TARGET_HEIGHT, (int)sizeof(client_pixel_rgba_ts) * SPRITE_VERIFY_TARGET_PITCH_PIXELS };
+  const client_framebuffer_ts reference_framebuffer = { reference_pixels, SPRITE_VERIFY_TARGET_WIDTH, SPRITE_VERIFY_TARGET_HEIGHT, (int)sizeof(client_pixel_rgba_ts) * SPRITE_VERIFY_TARGET_PITCH_PIXELS };
+  const SDL_Rect clip_rects[] = {
+    { 0, 0, SPRITE_VERIFY_TARGET_WIDTH, SPRITE_VERIFY_TARGET_HEIGHT },
+    { 4, 3, SPRITE_VERIFY_TARGET_WIDTH - 9, SPRITE_VERIFY_TARGET_HEIGHT - 7 }
+  };
+  const client_pixel_rgba_ts color_key = { 0xFF, 0x00, 0xFF, 0xFF };
+
+  /* Runs of color key pixels, cleared mask bits and opaque pixels of varying lengths, with padding pixels that must never be drawn */
+  uint32_t random_state = 0x68E31DA4u;
+  int run_length = 0;
+  int run_transparent = 0;
+  for (int pixel = 0; pixel < SPRITE_VERIFY_ATLAS_PITCH_PIXELS * SPRITE_VERIFY_ATLAS_HEIGHT; pixel++)
+  {
+    if (run_length-- <= 0)
+    {
+      run_length = sprite_verify_random(&random_state, 0, 6);
+      run_transparent = sprite_verify_random(&random_state, 0, 2) == 0;
+    }
+    random_state = (random_state * 1664525u) + 1013904223u;
+    client_pixel_rgba_ts * const p_pixel = &atlas_pixels[pixel];
+    p_pixel->red = (uint8_t)(random_state >> 24);
+    p_pixel->green = (uint8_t)(random_state >> 16);
+    p_pixel->blue = (uint8_t)(random_state >> 8);
+    p_pixel->alpha = (uint8_t)((random_state & 0x7Fu) | (run_transparent ? 0x00u : 0x80u));
+    if (run_transparent && (random_state & 0x100u) != 0)
+      *p_pixel = color_key;
+
+    /* Opaque pixels that miss the color key by a single channel */
+    if (!run_transparent && (random_state & 0x600u) == 0)
+    {
+      const uint8_t alpha = p_pixel->alpha;
+      *p_pixel = color_key;
+      p_pixel->alpha = alpha;
+      (&p_pixel->red)[(random_state >> 12) % 3u] ^= 0x01;
+    }
+    if (pixel % SPRITE_VERIFY_ATLAS_PITCH_PIXELS >= SPRITE_VERIFY_ATLAS_WIDTH)
+      SDL_memset(p_pixel, 0xEE, sizeof(client_pixel_rgba_ts));
+  }
+
+  int failures = 0;
+  for (int transparency = SPRITE_TRANSPARENCY_NONE; transparency <= SPRITE_TRANSPARENCY_MASK; transparency++)
+  {
+    sprite_atlas_ts atlas;
+    if (sprite_atlas_init(&atlas, &atlas_framebuffer, (sprite_transparency_te)transparency, color_key) != 0)
+      return failures + 1;
+
+    sprite_draw_list_ts draw_list;
+    if (sprite_draw_list_init(&draw_list, &atlas, 1) != 0)
+    {
+      sprite_atlas_free(&atlas);
+      return failures + 1;
+    }
+
+    int failed_case = -1;
+    for (int case_index = 0; case_index < 3000 && failed_case < 0; case_index++)
+    {
+      raster_target_ts drawn_target;
+      raster_target_ts reference_target;
+      raster_target_init(&drawn_target, &drawn_framebuffer);
+      raster_target_init(&reference_target, &reference_framebuffer);
+      raster_target_set_clip(&reference_target, &clip_rects[(case_index / 4) % SDL_arraysize(clip_rects)]);
+      SDL_memset(drawn_pixels, 0x5A, sizeof(drawn_pixels));
+      SDL_memset(reference_pixels, 0x5A, sizeof(reference_pixels));
+
+      /* Every fourth case renders a draw list of a few sprites band by band, the others blit a single sprite */
+      const int draw_count = (case_index % 4 == 3) ? sprite_verify_random(&random_state, 0, 6) : 1;
+      sprite_draw_list_clear(&draw_list);
+      for (int draw_index = 0; draw_index < draw_count; draw_index++)
+      {
+        /* Mostly rectangles inside the atlas, sometimes reaching past its edges or empty */
+        const int reach_past_atlas = sprite_verify_random(&random_state, 0, 7) == 0;
+        SDL_Rect source_rect;
+        source_rect.x = sprite_verify_random(&random_state, reach_past_atlas ? -6 : 0, SPRITE_VERIFY_ATLAS_WIDTH - 1);
+        source_rect.y = sprite_verify_random(&random_state, reach_past_atlas ? -6 : 0, SPRITE_VERIFY_ATLAS_HEIGHT - 1);
+        source_rect.w = sprite_verify_random(&random_state, 0, reach_past_atlas ? SPRITE_VERIFY_ATLAS_WIDTH + 6 : SPRITE_VERIFY_ATLAS_WIDTH - source_rect.x);
+        source_rect.h = sprite_verify_random(&random_state, 0, reach_past_atlas ? SPRITE_VERIFY_ATLAS_HEIGHT + 6 : SPRITE_VERIFY_ATLAS_HEIGHT - source_rect.y);
+
+        /* Positions from fully off the left and top edges to fully off the right and bottom edges */
+        const int x = sprite_verify_random(&random_state, -source_rect.w - 2, SPRITE_VERIFY_TARGET_WIDTH + 1);
+        const int y = sprite_verify_random(&random_state, -source_rect.h - 2, SPRITE_VERIFY_TARGET_HEIGHT + 1);
+        const int flip = (case_index + draw_index) % 4;
+        sprite_draw_list_add(&draw_list, &source_rect, x, y, flip);
+        sprite_reference_blit(&reference_target, &atlas_framebuffer, (sprite_transparency_te)transparency, color_key, &source_rect, x, y, flip);
+      }
+
+      if (case_index % 4 == 3)
+      {
+        /* Bands of uneven heights covering the clip rectangle, like the row band jobs of the worker pool */
+        const SDL_Rect * const p_clip_rect = &reference_target.clip_rect;
+        for (int band_y = p_clip_rect->y; band_y < p_clip_rect->y + p_clip_rect->h; band_y += 5)
+        {
+          const SDL_Rect band_rect = { p_clip_rect->x, band_y, p_clip_rect->w, SDL_min(5, p_clip_rect->y + p_clip_rect->h - band_y) };
+          raster_target_set_clip(&drawn_target, &band_rect);
+          sprite_draw_list_render(&draw_list, &drawn_target);
+        }
+      }
+      else
+      {
+        const sprite_draw_ts * const p_draw = &draw_list.p_draws[0];
+        raster_target_set_clip(&drawn_target, &reference_target.clip_rect);
+        sprite_blit(&drawn_target, &atlas, &p_draw->source_rect, p_draw->x, p_draw->y, p_draw->flip);
+      }
+
+      if (SDL_memcmp(drawn_pixels, reference_pixels, sizeof(drawn_pixels)) != 0)
+        failed_case = case_index;
+    }
+
+    if (failed_case >= 0)
+    {
+      fprintf(stdout, "FAIL  sprite %-10s case %d\n", transparency_names[transparency], failed_case);
+      failures++;
+    }
+    else
+    {
+      fprintf(stdout, "PASS  sprite %s\n", transparency_names[transparency]);
+    }
+
+    sprite_draw_list_free(&draw_list);
+    sprite_atlas_free(&atlas);
+  }
+
+  return failures;
+}
@@ -0,0 +1,65 @@
+#ifndef SPRITE_H
+#define SPRITE_H
+
+#include <SDL.h>
+#include "client_pixels.h"
+#include "raster.h"
+
+/* Datatypes */
+typedef enum {
+  SPRITE_TRANSPARENCY_NONE = 0,
+  SPRITE_TRANSPARENCY_COLOR_KEY,
+  SPRITE_TRANSPARENCY_MASK
+} sprite_transparency_te;
+
+typedef enum {
+  SPRITE_FLIP_NONE = 0x0,
+  SPRITE_FLIP_HORIZONTAL = 0x1,
+  SPRITE_FLIP_VERTICAL = 0x2
+} sprite_flip_te;
+
+/* Run of opaque atlas pixels [x_begin, x_end) within one atlas row */
+typedef struct {
+  int x_begin;
+  int x_end;
+} sprite_span_ts;
+
+/*
+    Sprite and tile pixels with the opaque runs of every row precomputed, so blitting copies whole
+    runs instead of testing every pixel. The spans of row y are p_spans[p_row_spans[y]] up to
+    p_spans[p_row_spans[y + 1]]
+*/
+typedef struct {
+  client_framebuffer_ts pixels;
+  sprite_span_ts * p_spans;
+  int * p_row_spans;
+} sprite_atlas_ts;
+
+typedef struct {
+  SDL_Rect source_rect;
+  int x;
+  int y;
+  int flip;
+} sprite_draw_ts;
+
+/* Sprites of one atlas to draw in order, later sprites over earlier ones */
+typedef struct {
+  const sprite_atlas_ts * p_atlas;
+  sprite_draw_ts * p_draws;
+  int draw_count;
+  int draw_capacity;
+} sprite_draw_list_ts;
+
+/* Function prototypes */
+int sprite_atlas_init(sprite_atlas_ts * p_atlas, const client_framebuffer_ts * p_pixels, sprite_transparency_te transparency, client_pixel_rgba_ts color_key);
+void sprite_atlas_free(sprite_atlas_ts * p_atlas);
+SDL_Rect sprite_atlas_tile_rect(const sprite_atlas_ts * p_atlas, int tile_index, int tile_size);
+void sprite_blit(const raster_target_ts * p_target, const sprite_atlas_ts * p_atlas, const SDL_Rect * p_source_rect, int x, int y, int flip);
+int sprite_draw_list_init(sprite_draw_list_ts * p_draw_list, const sprite_atlas_ts * p_atlas, int draw_capacity);
+void sprite_draw_list_free(sprite_draw_list_ts * p_draw_list);
+void sprite_draw_list_clear(sprite_draw_list_ts * p_draw_list);
+int sprite_draw_list_add(sprite_draw_list_ts * p_draw_list, const SDL_Rect * p_source_rect, int x, int y, int flip);
+void sprite_draw_list_render(const sprite_draw_list_ts * p_draw_list, const raster_target_ts * p_target);
+int sprite_verify_blits(void);
+
+#endif
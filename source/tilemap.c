@@ -0,0 +1,513 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <SDL.h>
+#include "tilemap.h"
+
+/* Defines */
+
+/* Verification layers and target, the target with padding past every row. The narrowest layer wraps more than once per scanline */
+#define TILEMAP_VERIFY_TILE_COUNT (29)
+#define TILEMAP_VERIFY_LAYER_COUNT (3)
+#define TILEMAP_VERIFY_TARGET_WIDTH (45)
+#define TILEMAP_VERIFY_TARGET_HEIGHT (27)
+#define TILEMAP_VERIFY_TARGET_PITCH_PIXELS (TILEMAP_VERIFY_TARGET_WIDTH + 3)
+#define TILEMAP_VERIFY_CASES (2000)
+
+/* Datatypes */
+
+/* Raster effect of the verification, which shears and bounces every layer and hides it on some scanlines */
+typedef struct {
+  int shear_x[TILEMAP_MAX_LAYERS];
+  int bounce_y[TILEMAP_MAX_LAYERS];
+  int hide_period[TILEMAP_MAX_LAYERS];
+} tilemap_verify_effect_ts;
+
+/* Wraps a coordinate into [0, size), also for negative coordinates */
+static int tilemap_wrap(int coordinate, int size)
+{
+  const int wrapped = coordinate % size;
+  return (wrapped < 0) ? wrapped + size : wrapped;
+}
+
+/* Decodes the tile data of a range of tiles into their cached pixels and opaque runs */
+static void tilemap_decode_tiles(tilemap_ts * p_tilemap, int first_tile, int tile_count)
+{
+  for (int tile = first_tile; tile < first_tile + tile_count; tile++)
+  {
+    const uint8_t * const p_data = &p_tilemap->p_tile_data[(size_t)tile * TILEMAP_TILE_DATA_SIZE];
+    for (int tile_y = 0; tile_y < TILEMAP_TILE_SIZE; tile_y++)
+    {
+      const size_t row_index = ((size_t)tile * TILEMAP_TILE_SIZE) + (size_t)tile_y;
+      client_pixel_rgba_ts * const p_row_pixels = &p_tilemap->p_tile_pixels[row_index * TILEMAP_TILE_SIZE];
+      tilemap_tile_row_ts * const p_row = &p_tilemap->p_tile_rows[row_index];
+      const uint8_t low_plane = p_data[tile_y * 2];
+      const uint8_t high_plane = p_data[(tile_y * 2) + 1];
+
+      p_row->run_count = 0;
+      int run_begin = -1;
+      for (int tile_x = 0; tile_x <= TILEMAP_TILE_SIZE; tile_x++)
+      {
+        int color = 0;
+        if (tile_x < TILEMAP_TILE_SIZE)
+        {
+          const int bit = (TILEMAP_TILE_SIZE - 1) - tile_x;
+          color = ((low_plane >> bit) & 0x1) | (((high_plane >> bit) & 0x1) << 1);
+          p_row_pixels[tile_x] = p_tilemap->palette[color];
+        }
+
+        if (color != 0 && run_begin < 0)
+        {
+          run_begin = tile_x;
+        }
+        else if (color == 0 && run_begin >= 0)
+        {
+          p_row->runs[p_row->run_count][0] = (uint8_t)run_begin;
+          p_row->runs[p_row->run_count][1] = (uint8_t)tile_x;
+          p_row->run_count++;
+          run_begin = -1;
+        }
+      }
+    }
+  }
+  p_tilemap->tiles_decoded += (uint64_t)tile_count;
+}
+
+/* Draws one layer across the whole scanline, with the layer scrolled to the given position */
+static void tilemap_render_layer_span(
+  const tilemap_ts * p_tilemap,
+  const tilemap_layer_ts * p_layer,
+  client_pixel_rgba_ts * p_scanline_pixels,
+  int width,
+  int scroll_x,
+  int scroll_y,
+  int scanline
+)
+{
+  const int map_width = p_layer->columns * TILEMAP_TILE_SIZE;
+  const int map_y = tilemap_wrap(scanline + scroll_y, p_layer->rows * TILEMAP_TILE_SIZE);
+  const uint16_t * const p_map_row = &p_layer->p_tiles[(size_t)(map_y / TILEMAP_TILE_SIZE) * (size_t)p_layer->columns];
+  const int tile_y = map_y % TILEMAP_TILE_SIZE;
+
+  /* Walk the scanline one tile at a time, where only the first and last tiles may be partially visible */
+  int map_x = tilemap_wrap(scroll_x, map_width);
+  int pixel_x = 0;
+  while (pixel_x < width)
+  {
+    const int tile_x = map_x % TILEMAP_TILE_SIZE;
+    const int pixel_count = SDL_min(TILEMAP_TILE_SIZE - tile_x, width - pixel_x);
+    const size_t row_index = ((size_t)p_map_row[map_x / TILEMAP_TILE_SIZE] * TILEMAP_TILE_SIZE) + (size_t)tile_y;
+    const client_pixel_rgba_ts * const p_row_pixels = &p_tilemap->p_tile_pixels[row_index * TILEMAP_TILE_SIZE];
+
+    if (!p_layer->transparent)
+    {
+      SDL_memcpy(p_scanline_pixels + pixel_x, p_row_pixels + tile_x, sizeof(client_pixel_rgba_ts) * (size_t)pixel_count);
+    }
+    else
+    {
+      const tilemap_tile_row_ts * const p_row = &p_tilemap->p_tile_rows[row_index];
+      for (int run = 0; run < p_row->run_count; run++)
+      {
+        const int run_begin = SDL_max((int)p_row->runs[run][0], tile_x);
+        const int run_end = SDL_min((int)p_row->runs[run][1], tile_x + pixel_count);
+        if (run_begin < run_end)
+          SDL_memcpy(p_scanline_pixels + pixel_x + (run_begin - tile_x), p_row_pixels + run_begin, sizeof(client_pixel_rgba_ts) * (size_t)(run_end - run_begin));
+      }
+    }
+
+    pixel_x += pixel_count;
+    map_x += pixel_count;
+    if (map_x >= map_width)
+      map_x -= map_width;
+  }
+}
+
+static void tilemap_verify_scanline_hook(const tilemap_ts * p_tilemap, int scanline, tilemap_scanline_ts * p_scanline, const void * p_hook_data)
+{
+  const tilemap_verify_effect_ts * const p_effect = (const tilemap_verify_effect_ts *)p_hook_data;
+  for (int layer = 0; layer < p_tilemap->layer_count; layer++)
+  {
+    p_scanline->scroll_x[layer] += p_effect->shear_x[layer] * scanline;
+    p_scanline->scroll_y[layer] -= p_effect->bounce_y[layer] * (scanline % 5);
+    if (p_effect->hide_period[layer] > 0 && scanline % p_effect->hide_period[layer] == 0)
+      p_scanline->visible[layer] = 0;
+  }
+}
+
+/*
+    Reference rendering decoding every pixel from its own copy of the bitplanes and palette. Pixel x of a scanline shows
+    pixel (x + scroll_x, scanline + scroll_y) of every visible layer, wrapped around the layer edges, unless the layer
+    is transparent and the pixel has color 0. Without a hook every layer is visible at its own scroll position
+*/
+static void tilemap_reference_render_rows(
+  const tilemap_ts * p_tilemap,
+  const uint8_t * p_tile_data,
+  const client_pixel_rgba_ts * p_palette,
+  const tilemap_verify_effect_ts * p_effect,
+  const client_framebuffer_ts * p_framebuffer,
+  int row_begin,
+  int row_end
+)
+{
+  for (int scanline = row_begin; scanline < row_end; scanline++)
+  {
+    client_pixel_rgba_ts * const p_row = client_framebuffer_row(p_framebuffer, scanline);
+    for (int layer = 0; layer < p_tilemap->layer_count; layer++)
+    {
+      const tilemap_layer_ts * const p_layer = &p_tilemap->layers[layer];
+      int scroll_x = p_layer->scroll_x;
+      int scroll_y = p_layer->scroll_y;
+      if (p_effect != NULL)
+      {
+        if (p_effect->hide_period[layer] > 0 && scanline % p_effect->hide_period[layer] == 0)
+          continue;
+        scroll_x += p_effect->shear_x[layer] * scanline;
+        scroll_y -= p_effect->bounce_y[layer] * (scanline % 5);
+      }
+
+      const int map_width = p_layer->columns * TILEMAP_TILE_SIZE;
+      const int map_height = p_layer->rows * TILEMAP_TILE_SIZE;
+      const int map_y = (((scanline + scroll_y) % map_height) + map_height) % map_height;
+      for (int x = 0; x < p_framebuffer->width; x++)
+      {
+        const int map_x = (((x + scroll_x) % map_width) + map_width) % map_width;
+        const int tile = p_layer->p_tiles[((map_y / TILEMAP_TILE_SIZE) * p_layer->columns) + (map_x / TILEMAP_TILE_SIZE)];
+        const uint8_t * const p_planes = &p_tile_data[(tile * TILEMAP_TILE_DATA_SIZE) + ((map_y % TILEMAP_TILE_SIZE) * 2)];
+        const int bit = 7 - (map_x % TILEMAP_TILE_SIZE);
+        const int color = ((p_planes[0] >> bit) & 0x1) | (((p_planes[1] >> bit) & 0x1) << 1);
+        if (color != 0 || !p_layer->transparent)
+          p_row[x] = p_palette[color];
+      }
+    }
+  }
+}
+
+/* Next value of the deterministic pseudo-random verification cases, in [minimum, maximum] */
+static int tilemap_verify_random(uint32_t * p_random_state, int minimum, int maximum)
+{
+  *p_random_state = (*p_random_state * 1664525u) + 1013904223u;
+  return minimum + (int)((*p_random_state >> 8) % (uint32_t)(maximum - minimum + 1));
+}
+
+/* Fills tile data with blank, solid and random tiles, where random tiles get runs of color 0 of varying lengths */
+static void tilemap_verify_random_tiles(uint32_t * p_random_state, uint8_t * p_tile_data, int tile_count)
+{
+  for (int tile = 0; tile < tile_count; tile++)
+  {
+    const int kind = tilemap_verify_random(p_random_state, 0, 5);
+    for (int tile_y = 0; tile_y < TILEMAP_TILE_SIZE; tile_y++)
+    {
+      uint8_t * const p_planes = &p_tile_data[(tile * TILEMAP_TILE_DATA_SIZE) + (tile_y * 2)];
+      const uint8_t opaque_mask = (uint8_t)tilemap_verify_random(p_random_state, 0, 0xFF);
+      p_planes[0] = (kind == 0) ? 0x00 : (kind == 1) ? 0xFF : (uint8_t)(tilemap_verify_random(p_random_state, 0, 0xFF) & opaque_mask);
+      p_planes[1] = (kind == 0) ? 0x00 : (kind == 1) ? 0xFF : (uint8_t)(tilemap_verify_random(p_random_state, 0, 0xFF) & opaque_mask);
+    }
+  }
+}
+
+/* Function definitions */
+
+/*
+    Creates a tilemap of blank tiles without layers, with the palette of TILEMAP_COLOR_COUNT colors.
+    Layers store tile indices in 16 bits, so at most TILEMAP_MAX_TILES tiles are supported
+*/
+tilemap_ts * tilemap_create(int tile_count, const client_pixel_rgba_ts * p_palette)
+{
+  if (tile_count > TILEMAP_MAX_TILES)
+  {
+    fprintf(stderr, "\nCould not create tilemap of %d tiles - Error: At most %d tiles are supported", tile_count, TILEMAP_MAX_TILES);
+    return NULL;
+  }
+
+  tilemap_ts * const p_tilemap = calloc(1, sizeof(tilemap_ts));
+  if (p_tilemap == NULL)
+  {
+    fprintf(stderr, "\nCould not allocate tilemap - Error: Calloc failed");
+    return NULL;
+  }
+
+  p_tilemap->tile_count = SDL_max(1, tile_count);
+  p_tilemap->p_tile_data = calloc((size_t)p_tilemap->tile_count, TILEMAP_TILE_DATA_SIZE);
+  p_tilemap->p_tile_pixels = malloc(sizeof(client_pixel_rgba_ts) * (size_t)p_tilemap->tile_count * TILEMAP_TILE_SIZE * TILEMAP_TILE_SIZE);
+  p_tilemap->p_tile_rows = malloc(sizeof(tilemap_tile_row_ts) * (size_t)p_tilemap->tile_count * TILEMAP_TILE_SIZE);
+  if (p_tilemap->p_tile_data == NULL || p_tilemap->p_tile_pixels == NULL || p_tilemap->p_tile_rows == NULL)
+  {
+    fprintf(stderr, "\nCould not allocate tilemap tiles - Error: Malloc failed");
+    tilemap_destroy(p_tilemap);
+    return NULL;
+  }
+
+  tilemap_set_palette(p_tilemap, p_palette);
+  return p_tilemap;
+}
+
+void tilemap_destroy(tilemap_ts * p_tilemap)
+{
+  if (p_tilemap == NULL)
+    return;
+
+  for (int layer = 0; layer < p_tilemap->layer_count; layer++)
+  {
+    free(p_tilemap->layers[layer].p_tiles);
+  }
+  free(p_tilemap->p_tile_rows);
+  free(p_tilemap->p_tile_pixels);
+  free(p_tilemap->p_tile_data);
+  free(p_tilemap);
+}
+
+/* Replaces the palette, which decodes every tile again */
+void tilemap_set_palette(tilemap_ts * p_tilemap, const client_pixel_rgba_ts * p_palette)
+{
+  SDL_memcpy(p_tilemap->palette, p_palette, sizeof(p_tilemap->palette));
+  tilemap_decode_tiles(p_tilemap, 0, p_tilemap->tile_count);
+}
+
+/* Replaces the data of a range of tiles, which only decodes those tiles again */
+void tilemap_set_tile_data(tilemap_ts * p_tilemap, int first_tile, int tile_count, const uint8_t * p_tile_data)
+{
+  if (first_tile < 0 || tile_count <= 0 || first_tile + tile_count > p_tilemap->tile_count)
+    return;
+
+  SDL_memcpy(&p_tilemap->p_tile_data[(size_t)first_tile * TILEMAP_TILE_DATA_SIZE], p_tile_data, (size_t)tile_count * TILEMAP_TILE_DATA_SIZE);
+  tilemap_decode_tiles(p_tilemap, first_tile, tile_count);
+}
+
+/*
+    Adds a layer of tile 0 on top of the existing layers. Pixels of color 0 let the layers below show through
+    transparent layers. Returns the index of the layer, or -1 on failure
+*/
+int tilemap_add_layer(tilemap_ts * p_tilemap, int columns, int rows, int transparent)
+{
+  if (p_tilemap->layer_count == TILEMAP_MAX_LAYERS || columns <= 0 || rows <= 0)
+  {
+    fprintf(stderr, "\nTilemaps support up to %d layers of at least one tile", TILEMAP_MAX_LAYERS);
+    return -1;
+  }
+
+  tilemap_layer_ts * const p_layer = &p_tilemap->layers[p_tilemap->layer_count];
+  p_layer->p_tiles = calloc((size_t)columns * (size_t)rows, sizeof(uint16_t));
+  if (p_layer->p_tiles == NULL)
+  {
+    fprintf(stderr, "\nCould not allocate tilemap layer - Error: Calloc failed");
+    return -1;
+  }
+  p_layer->columns = columns;
+  p_layer->rows = rows;
+  p_layer->scroll_x = 0;
+  p_layer->scroll_y = 0;
+  p_layer->transparent = transparent;
+  return p_tilemap->layer_count++;
+}
+
+void tilemap_set_tile(tilemap_ts * p_tilemap, int layer, int column, int row, int tile)
+{
+  if (layer < 0 || layer >= p_tilemap->layer_count || tile < 0 || tile >= p_tilemap->tile_count)
+    return;
+
+  tilemap_layer_ts * const p_layer = &p_tilemap->layers[layer];
+  if (column < 0 || column >= p_layer->columns || row < 0 || row >= p_layer->rows)
+    return;
+
+  p_layer->p_tiles[((size_t)row * (size_t)p_layer->columns) + (size_t)column] = (uint16_t)tile;
+}
+
+/* Scrolls the layer so that its pixel (scroll_x, scroll_y) is drawn at the top-left corner, wrapping around its edges */
+void tilemap_set_scroll(tilemap_ts * p_tilemap, int layer, int scroll_x, int scroll_y)
+{
+  if (layer < 0 || layer >= p_tilemap->layer_count)
+    return;
+
+  p_tilemap->layers[layer].scroll_x = scroll_x;
+  p_tilemap->layers[layer].scroll_y = scroll_y;
+}
+
+void tilemap_set_scanline_hook(tilemap_ts * p_tilemap, tilemap_scanline_hook_tf scanline_hook, const void * p_hook_data)
+{
+  p_tilemap->scanline_hook = scanline_hook;
+  p_tilemap->p_hook_data = p_hook_data;
+}
+
+/*
+    Draws the scanlines [row_begin, row_end) of every layer into the framebuffer. Scanlines only read the
+    tilemap, so disjoint row ranges may be drawn at the same time. Pixels no opaque layer covers are left untouched
+*/
+void tilemap_render_rows(const tilemap_ts * p_tilemap, const client_framebuffer_ts * p_framebuffer, int row_begin, int row_end)
+{
+  for (int scanline = row_begin; scanline < row_end; scanline++)
+  {
+    tilemap_scanline_ts scanline_state;
+    for (int layer = 0; layer < p_tilemap->layer_count; layer++)
+    {
+      scanline_state.scroll_x[layer] = p_tilemap->layers[layer].scroll_x;
+      scanline_state.scroll_y[layer] = p_tilemap->layers[layer].scroll_y;
+      scanline_state.visible[layer] = 1;
+    }
+
+    if (p_tilemap->scanline_hook != NULL)
+      p_tilemap->scanline_hook(p_tilemap, scanline, &scanline_state, p_tilemap->p_hook_data);
+
+    client_pixel_rgba_ts * const p_scanline_pixels = client_framebuffer_row(p_framebuffer, scanline);
+    for (int layer = 0; layer < p_tilemap->layer_count; layer++)
+    {
+      if (!scanline_state.visible[layer])
+        continue;
+
+      tilemap_render_layer_span(
+        p_tilemap,
+        &p_tilemap->layers[layer],
+        p_scanline_pixels,
+        p_framebuffer->width,
+        scanline_state.scroll_x[layer],
+        scanline_state.scroll_y[layer],
+        scanline
+      );
+    }
+  }
+}
+
+/*
+    Compares tilemap rendering against the per-pixel reference decoding the bitplanes, for an opaque layer under two
+    transparent ones, with negative scroll positions and positions wrapping the layers many times over. Rows are drawn
+    in bands in any order, sometimes only part of the target. Checks a scanline hook shearing, bouncing and hiding layers,
+    including the opaque one, and that replacing tile data decodes exactly the given range of tiles again and rejects
+    ranges outside the tilemap. The whole target is compared, including the padding past every row. Returns the number of failed checks
+*/
+int tilemap_verify_rendering(void)
+{
+  static const char * const check_names[] = { "layers", "scanline-hook", "tile-data" };
+  static const int layer_columns[TILEMAP_VERIFY_LAYER_COUNT] = { 5, 7, 3 };
+  static const int layer_rows[TILEMAP_VERIFY_LAYER_COUNT] = { 3, 4, 6 };
+  static client_pixel_rgba_ts drawn_pixels[TILEMAP_VERIFY_TARGET_PITCH_PIXELS * TILEMAP_VERIFY_TARGET_HEIGHT];
+  static client_pixel_rgba_ts reference_pixels[TILEMAP_VERIFY_TARGET_PITCH_PIXELS * TILEMAP_VERIFY_TARGET_HEIGHT];
+  const client_framebuffer_ts drawn_framebuffer = { drawn_pixels, TILEMAP_VERIFY_TARGET_WIDTH, TILEMAP_VERIFY_TARGET_HEIGHT, (int)sizeof(client_pixel_rgba_ts) * TILEMAP_VERIFY_TARGET_PITCH_PIXELS };
+  const client_framebuffer_ts reference_framebuffer = { reference_pixels, TILEMAP_VERIFY_TARGET_WIDTH, TILEMAP_VERIFY_TARGET_HEIGHT, (int)sizeof(client_pixel_rgba_ts) * TILEMAP_VERIFY_TARGET_PITCH_PIXELS };
+  uint8_t tile_data[TILEMAP_VERIFY_TILE_COUNT * TILEMAP_TILE_DATA_SIZE];
+  uint8_t replaced_tile_data[(TILEMAP_VERIFY_TILE_COUNT + 2) * TILEMAP_TILE_DATA_SIZE];
+  client_pixel_rgba_ts palette[TILEMAP_COLOR_COUNT];
+
+  uint32_t random_state = 0x2F6B49D1u;
+  for (int color = 0; color < TILEMAP_COLOR_COUNT; color++)
+  {
+    random_state = (random_state * 1664525u) + 1013904223u;
+    SDL_memcpy(&palette[color], &random_state, sizeof(client_pixel_rgba_ts));
+  }
+  tilemap_verify_random_tiles(&random_state, tile_data, TILEMAP_VERIFY_TILE_COUNT);
+
+  tilemap_ts * const p_tilemap = tilemap_create(TILEMAP_VERIFY_TILE_COUNT, palette);
+  if (p_tilemap == NULL)
+    return 1;
+
+  tilemap_set_tile_data(p_tilemap, 0, TILEMAP_VERIFY_TILE_COUNT, tile_data);
+  for (int layer = 0; layer < TILEMAP_VERIFY_LAYER_COUNT; layer++)
+  {
+    if (tilemap_add_layer(p_tilemap, layer_columns[layer], layer_rows[layer], layer > 0) < 0)
+    {
+      tilemap_destroy(p_tilemap);
+      return 1;
+    }
+  }
+
+  int failures = 0;
+  for (int check = 0; check < (int)SDL_arraysize(check_names); check++)
+  {
+    tilemap_verify_effect_ts effect;
+    tilemap_set_scanline_hook(p_tilemap, (check == 1) ? tilemap_verify_scanline_hook : NULL, &effect);
+
+    int failed_case = -1;
+    for (int case_index = 0; case_index < TILEMAP_VERIFY_CASES && failed_case < 0; case_index++)
+    {
+      /* A few new tiles per case, and scroll positions mostly within a few wraps of the layer, sometimes far out */
+      for (int layer = 0; layer < TILEMAP_VERIFY_LAYER_COUNT; layer++)
+      {
+        for (int tile_change = 0; tile_change < 3; tile_change++)
+        {
+          const int column = tilemap_verify_random(&random_state, 0, layer_columns[layer] - 1);
+          const int row = tilemap_verify_random(&random_state, 0, layer_rows[layer] - 1);
+          tilemap_set_tile(p_tilemap, layer, column, row, tilemap_verify_random(&random_state, 0, TILEMAP_VERIFY_TILE_COUNT - 1));
+        }
+
+        const int far_scroll = tilemap_verify_random(&random_state, 0, 7) == 0;
+        const int scroll_reach_x = far_scroll ? 1000000 : 3 * layer_columns[layer] * TILEMAP_TILE_SIZE;
+        const int scroll_reach_y = far_scroll ? 1000000 : 3 * layer_rows[layer] * TILEMAP_TILE_SIZE;
+        tilemap_set_scroll(
+          p_tilemap,
+          layer,
+          tilemap_verify_random(&random_state, -scroll_reach_x, scroll_reach_x),
+          tilemap_verify_random(&random_state, -scroll_reach_y, scroll_reach_y)
+        );
+
+        effect.shear_x[layer] = tilemap_verify_random(&random_state, -3, 3);
+        effect.bounce_y[layer] = tilemap_verify_random(&random_state, -2, 2);
+        effect.hide_period[layer] = tilemap_verify_random(&random_state, 0, 4);
+      }
+
+      /* Palette changes decode every tile again */
+      if (check == 0 && case_index % 16 == 15)
+      {
+        palette[case_index % TILEMAP_COLOR_COUNT].green ^= (uint8_t)case_index;
+        tilemap_set_palette(p_tilemap, palette);
+      }
+
+      /*
+          Replaces a range of tiles, sometimes reaching outside the tilemap, which must change nothing. A tile outside the range
+          gets a marked decoded pixel, which decoding it again would overwrite
+      */
+      if (check == 2)
+      {
+        const int first_tile = tilemap_verify_random(&random_state, -1, TILEMAP_VERIFY_TILE_COUNT - 1);
+        const int tile_count = tilemap_verify_random(&random_state, 0, TILEMAP_VERIFY_TILE_COUNT - first_tile + 1);
+        const int range_valid = first_tile >= 0 && tile_count > 0 && first_tile + tile_count <= TILEMAP_VERIFY_TILE_COUNT;
+        tilemap_verify_random_tiles(&random_state, replaced_tile_data, tile_count);
+
+        const int marked_tile = tilemap_verify_random(&random_state, 0, TILEMAP_VERIFY_TILE_COUNT - 1);
+        const int marked_tile_replaced = range_valid && marked_tile >= first_tile && marked_tile < first_tile + tile_count;
+        client_pixel_rgba_ts * const p_marked_pixel = &p_tilemap->p_tile_pixels[(size_t)marked_tile * TILEMAP_TILE_SIZE * TILEMAP_TILE_SIZE];
+        const client_pixel_rgba_ts decoded_pixel = *p_marked_pixel;
+        const client_pixel_rgba_ts marked_pixel = { (uint8_t)~decoded_pixel.red, 0x5A, 0xA5, (uint8_t)case_index };
+        if (!marked_tile_replaced)
+          *p_marked_pixel = marked_pixel;
+
+        const uint64_t tiles_decoded = p_tilemap->tiles_decoded;
+        tilemap_set_tile_data(p_tilemap, first_tile, tile_count, replaced_tile_data);
+        if (range_valid)
+          SDL_memcpy(&tile_data[first_tile * TILEMAP_TILE_DATA_SIZE], replaced_tile_data, (size_t)tile_count * TILEMAP_TILE_DATA_SIZE);
+
+        if (p_tilemap->tiles_decoded - tiles_decoded != (uint64_t)(range_valid ? tile_count : 0))
+          failed_case = case_index;
+        if (!marked_tile_replaced)
+        {
+          if (SDL_memcmp(p_marked_pixel, &marked_pixel, sizeof(marked_pixel)) != 0)
+            failed_case = case_index;
+          *p_marked_pixel = decoded_pixel;
+        }
+      }
+
+      /* Mostly every row, sometimes only some, drawn in two bands with the lower one first */
+      const int partial_rows = tilemap_verify_random(&random_state, 0, 3) == 0;
+      const int row_begin = partial_rows ? tilemap_verify_random(&random_state, 0, TILEMAP_VERIFY_TARGET_HEIGHT) : 0;
+      const int row_end = partial_rows ? tilemap_verify_random(&random_state, row_begin, TILEMAP_VERIFY_TARGET_HEIGHT) : TILEMAP_VERIFY_TARGET_HEIGHT;
+      const int row_split = tilemap_verify_random(&random_state, row_begin, row_end);
+      SDL_memset(drawn_pixels, 0x5A, sizeof(drawn_pixels));
+      SDL_memset(reference_pixels, 0x5A, sizeof(reference_pixels));
+      tilemap_render_rows(p_tilemap, &drawn_framebuffer, row_split, row_end);
+      tilemap_render_rows(p_tilemap, &drawn_framebuffer, row_begin, row_split);
+      tilemap_reference_render_rows(p_tilemap, tile_data, palette, (check == 1) ? &effect : NULL, &reference_framebuffer, row_begin, row_end);
+
+      if (SDL_memcmp(drawn_pixels, reference_pixels, sizeof(drawn_pixels)) != 0)
+        failed_case = case_index;
+    }
+
+    if (failed_case >= 0)
+    {
+      fprintf(stdout, "FAIL  tilemap %-13s case %d\n", check_names[check], failed_case);
+      failures++;
+    }
+    else
+    {
+      fprintf(stdout, "PASS  tilemap %s\n", check_names[check]);
+    }
+  }
+
+  tilemap_destroy(p_tilemap);
+  return failures;
+}
@@ -0,0 +1,76 @@
+#ifndef TILEMAP_H
+#define TILEMAP_H
+
+#include <stdint.h>
+#include "client_pixels.h"
+
+/* Defines */
+#define TILEMAP_TILE_SIZE (8)
+#define TILEMAP_TILE_DATA_SIZE (16)
+#define TILEMAP_COLOR_COUNT (4)
+#define TILEMAP_MAX_LAYERS (4)
+#define TILEMAP_MAX_TILES (65536)
+#define TILEMAP_MAX_ROW_RUNS (TILEMAP_TILE_SIZE / 2)
+
+/* Datatypes */
+typedef struct tilemap_s tilemap_ts;
+
+/* Runs of opaque pixels [begin, end) of one decoded tile row, where pixels of color 0 are transparent */
+typedef struct {
+  uint8_t run_count;
+  uint8_t runs[TILEMAP_MAX_ROW_RUNS][2];
+} tilemap_tile_row_ts;
+
+typedef struct {
+  uint16_t * p_tiles;
+  int columns;
+  int rows;
+  int scroll_x;
+  int scroll_y;
+  int transparent;
+} tilemap_layer_ts;
+
+/* Layer state of one scanline, which starts out as the layer state of the tilemap */
+typedef struct {
+  int scroll_x[TILEMAP_MAX_LAYERS];
+  int scroll_y[TILEMAP_MAX_LAYERS];
+  int visible[TILEMAP_MAX_LAYERS];
+} tilemap_scanline_ts;
+
+/*
+    Adjusts the layer state right before a scanline is drawn, for raster effects. Scanlines may be drawn
+    in any order and at the same time, so the hook must only depend on the scanline and its own data
+*/
+typedef void (* tilemap_scanline_hook_tf)(const tilemap_ts * p_tilemap, int scanline, tilemap_scanline_ts * p_scanline, const void * p_hook_data);
+
+/*
+    Layers of tiles, drawn bottom to top. Tile data uses 2 bits per pixel, stored as two bitplanes per row with
+    the leftmost pixel in the most significant bit. Every tile is decoded once into client-side pixels and
+    opaque runs, and only decoded again when its data or the palette changes
+*/
+struct tilemap_s {
+  int tile_count;
+  uint8_t * p_tile_data;
+  client_pixel_rgba_ts palette[TILEMAP_COLOR_COUNT];
+  client_pixel_rgba_ts * p_tile_pixels;
+  tilemap_tile_row_ts * p_tile_rows;
+  uint64_t tiles_decoded;
+  tilemap_layer_ts layers[TILEMAP_MAX_LAYERS];
+  int layer_count;
+  tilemap_scanline_hook_tf scanline_hook;
+  const void * p_hook_data;
+};
+
+/* Function prototypes */
+tilemap_ts * tilemap_create(int tile_count, const client_pixel_rgba_ts * p_palette);
+void tilemap_destroy(tilemap_ts * p_tilemap);
+void tilemap_set_palette(tilemap_ts * p_tilemap, const client_pixel_rgba_ts * p_palette);
+void tilemap_set_tile_data(tilemap_ts * p_tilemap, int first_tile, int tile_count, const uint8_t * p_tile_data);
+int tilemap_add_layer(tilemap_ts * p_tilemap, int columns, int rows, int transparent);
+void tilemap_set_tile(tilemap_ts * p_tilemap, int layer, int column, int row, int tile);
+void tilemap_set_scroll(tilemap_ts * p_tilemap, int layer, int scroll_x, int scroll_y);
+void tilemap_set_scanline_hook(tilemap_ts * p_tilemap, tilemap_scanline_hook_tf scanline_hook, const void * p_hook_data);
+void tilemap_render_rows(const tilemap_ts * p_tilemap, const client_framebuffer_ts * p_framebuffer, int row_begin, int row_end);
+int tilemap_verify_rendering(void);
+
+#endif
@@ -0,0 +1,184 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <SDL.h>
+#include "video_stream.h"
+
+/*
+    POSIX systems gather the rows of a frame into a single writev call, so pixels go from the client-side
+    buffer straight to the pipe without being copied into a stdio buffer first. Other systems write row by row
+*/
+#if defined(_WIN32)
+#include <io.h>
+#define VIDEO_STREAM_STDOUT_FILENO (1)
+#else
+#include <unistd.h>
+#include <signal.h>
+#include <sys/uio.h>
+#define VIDEO_STREAM_WRITEV
+#define VIDEO_STREAM_STDOUT_FILENO STDOUT_FILENO
+#endif
+
+/* Defines */
+#define VIDEO_STREAM_MAX_VECTORS (64)
+
+#ifdef VIDEO_STREAM_WRITEV
+/* Writes all vectors, continuing after partial writes and interrupted calls. Returns 0 on success and -1 on failure */
+static int video_stream_write_vectors(int file_descriptor, struct iovec * p_vectors, int vector_count)
+{
+  while (vector_count > 0)
+  {
+    const ssize_t bytes_written = writev(file_descriptor, p_vectors, vector_count);
+    if (bytes_written < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      return -1;
+    }
+
+    /* Skip the vectors written completely and advance into the first one written partially */
+    size_t bytes_remaining = (size_t)bytes_written;
+    while (vector_count > 0 && bytes_remaining >= p_vectors->iov_len)
+    {
+      bytes_remaining -= p_vectors->iov_len;
+      p_vectors++;
+      vector_count--;
+    }
+    if (vector_count > 0)
+    {
+      p_vectors->iov_base = (char *)p_vectors->iov_base + bytes_remaining;
+      p_vectors->iov_len -= bytes_remaining;
+    }
+  }
+  return 0;
+}
+#else
+static int video_stream_write_bytes(int file_descriptor, const void * p_bytes, size_t size)
+{
+  while (size > 0)
+  {
+    const int bytes_written = _write(file_descriptor, p_bytes, (unsigned int)SDL_min(size, (size_t)0x40000000));
+    if (bytes_written <= 0)
+      return -1;
+
+    p_bytes = (const char *)p_bytes + bytes_written;
+    size -= (size_t)bytes_written;
+  }
+  return 0;
+}
+#endif
+
+/* Function definitions */
+
+/* Returns whether the path stands for the standard output */
+int video_stream_is_stdout(const char * p_path)
+{
+  return SDL_strcmp(p_path, "-") == 0;
+}
+
+/*
+    Opens the standard output for the path "-", or else creates the file or opens the named pipe at the path,
+    which waits for a reader to open the pipe. The path must outlive the stream. Returns NULL on failure
+*/
+video_stream_ts * video_stream_open(const char * p_path)
+{
+  video_stream_ts * const p_stream = calloc(1, sizeof(video_stream_ts));
+  if (p_stream == NULL)
+  {
+    fprintf(stderr, "\nCould not allocate video stream - Error: Calloc failed");
+    return NULL;
+  }
+  p_stream->p_path = p_path;
+
+  if (video_stream_is_stdout(p_path))
+  {
+    fflush(stdout);
+    p_stream->file_descriptor = VIDEO_STREAM_STDOUT_FILENO;
+#if defined(_WIN32)
+    _setmode(p_stream->file_descriptor, _O_BINARY);
+#endif
+  }
+  else
+  {
+#if defined(_WIN32)
+    p_stream->file_descriptor = _open(p_path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, 0644);
+#else
+    p_stream->file_descriptor = open(p_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+    if (p_stream->file_descriptor < 0)
+    {
+      fprintf(stderr, "\nCould not open video stream '%s' - Error: %s", p_path, strerror(errno));
+      free(p_stream);
+      return NULL;
+    }
+    p_stream->owns_file = 1;
+  }
+
+#ifdef VIDEO_STREAM_WRITEV
+  /* A reader closing the pipe fails the next write instead of terminating the process */
+  signal(SIGPIPE, SIG_IGN);
+#endif
+  return p_stream;
+}
+
+void video_stream_close(video_stream_ts * p_stream)
+{
+  if (p_stream == NULL)
+    return;
+
+#if defined(_WIN32)
+  if (p_stream->owns_file)
+    _close(p_stream->file_descriptor);
+#else
+  if (p_stream->owns_file)
+    close(p_stream->file_descriptor);
+#endif
+  free(p_stream);
+}
+
+/* Writes the framebuffer as one frame of tightly packed RGBA rows. Returns 0 on success and -1 on failure */
+int video_stream_write_frame(video_stream_ts * p_stream, const client_framebuffer_ts * p_framebuffer)
+{
+  const size_t row_size = sizeof(client_pixel_rgba_ts) * (size_t)p_framebuffer->width;
+  int write_result = 0;
+
+#ifdef VIDEO_STREAM_WRITEV
+  /* Contiguous rows are a single vector, padded rows are gathered in batches */
+  struct iovec vectors[VIDEO_STREAM_MAX_VECTORS];
+  if ((size_t)p_framebuffer->pitch == row_size)
+  {
+    vectors[0].iov_base = p_framebuffer->p_pixels;
+    vectors[0].iov_len = row_size * (size_t)p_framebuffer->height;
+    write_result = video_stream_write_vectors(p_stream->file_descriptor, vectors, 1);
+  }
+  else
+  {
+    for (int row_begin = 0; row_begin < p_framebuffer->height && write_result == 0; row_begin += VIDEO_STREAM_MAX_VECTORS)
+    {
+      const int row_count = SDL_min(VIDEO_STREAM_MAX_VECTORS, p_framebuffer->height - row_begin);
+      for (int vector_index = 0; vector_index < row_count; vector_index++)
+      {
+        vectors[vector_index].iov_base = client_framebuffer_row(p_framebuffer, row_begin + vector_index);
+        vectors[vector_index].iov_len = row_size;
+      }
+      write_result = video_stream_write_vectors(p_stream->file_descriptor, vectors, row_count);
+    }
+  }
+#else
+  for (int row = 0; row < p_framebuffer->height && write_result == 0; row++)
+  {
+    write_result = video_stream_write_bytes(p_stream->file_descriptor, client_framebuffer_row(p_framebuffer, row), row_size);
+  }
+#endif
+
+  if (write_result != 0)
+  {
+    fprintf(stderr, "\nCould not write frame %llu to video stream '%s' - Error: %s", (unsigned long long)p_stream->frames_written, p_stream->p_path, strerror(errno));
+    return -1;
+  }
+
+  p_stream->frames_written++;
+  return 0;
+}
@@ -0,0 +1,27 @@
+#ifndef VIDEO_STREAM_H
+#define VIDEO_STREAM_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "client_pixels.h"
+
+/* Datatypes */
+
+/*
+    Headerless stream of RGBA frames, as read by ffmpeg -f rawvideo -pixel_format rgba.
+    Frames are written synchronously, so a slow reader paces the render loop instead of losing frames
+*/
+typedef struct {
+  const char * p_path;
+  int file_descriptor;
+  int owns_file;
+  uint64_t frames_written;
+} video_stream_ts;
+
+/* Function prototypes */
+video_stream_ts * video_stream_open(const char * p_path);
+void video_stream_close(video_stream_ts * p_stream);
+int video_stream_write_frame(video_stream_ts * p_stream, const client_framebuffer_ts * p_framebuffer);
+int video_stream_is_stdout(const char * p_path);
+
+#endif
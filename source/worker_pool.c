@@ -0,0 +1,206 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <SDL.h>
+#include "worker_pool.h"
+
+/* Constants */
+static const int WORKER_POOL_JOBS_PER_THREAD = 4;
+
+/*
+    Claims and runs jobs until every queue is exhausted. A participant drains its own
+    queue first and then steals the remaining jobs of the other participants in turn
+*/
+static void worker_pool_participate(worker_pool_ts * p_pool, int participant, worker_rows_tf rows_function, void * p_job_data, int row_count, int rows_per_job)
+{
+  for (int queue_offset = 0; queue_offset < p_pool->thread_count; queue_offset++)
+  {
+    worker_queue_ts * const p_queue = &p_pool->queues[(participant + queue_offset) % p_pool->thread_count];
+    for (;;)
+    {
+      const int job = SDL_AtomicAdd(&p_queue->next_job, 1);
+      if (job >= p_queue->end_job)
+        break;
+
+      const int row_begin = job * rows_per_job;
+      const int row_end = SDL_min(row_begin + rows_per_job, row_count);
+      rows_function(p_job_data, row_begin, row_end);
+    }
+  }
+}
+
+static int worker_thread_main(void * p_thread_data)
+{
+  worker_thread_ts * const p_worker = (worker_thread_ts *)p_thread_data;
+  worker_pool_ts * const p_pool = p_worker->p_pool;
+  uint32_t generation_seen = 0;
+
+  SDL_LockMutex(p_pool->p_mutex);
+  for (;;)
+  {
+    /* Sleep until a new run is published or the pool shuts down */
+    while (p_pool->generation == generation_seen && !p_pool->quit_requested)
+    {
+      SDL_CondWait(p_pool->p_work_available, p_pool->p_mutex);
+    }
+
+    if (p_pool->quit_requested)
+      break;
+
+    /* Take a consistent copy of the run, the publisher waits for all active workers before changing it */
+    generation_seen = p_pool->generation;
+    p_pool->active_workers++;
+    const worker_rows_tf rows_function = p_pool->rows_function;
+    void * const p_job_data = p_pool->p_job_data;
+    const int row_count = p_pool->row_count;
+    const int rows_per_job = p_pool->rows_per_job;
+    SDL_UnlockMutex(p_pool->p_mutex);
+
+    worker_pool_participate(p_pool, p_worker->participant, rows_function, p_job_data, row_count, rows_per_job);
+
+    SDL_LockMutex(p_pool->p_mutex);
+    p_pool->active_workers--;
+    if (p_pool->active_workers == 0)
+      SDL_CondBroadcast(p_pool->p_workers_idle);
+  }
+  SDL_UnlockMutex(p_pool->p_mutex);
+
+  return 0;
+}
+
+static void worker_pool_wait_idle(worker_pool_ts * p_pool)
+{
+  while (p_pool->active_workers > 0)
+  {
+    SDL_CondWait(p_pool->p_workers_idle, p_pool->p_mutex);
+  }
+}
+
+/* Function definitions */
+worker_pool_ts * worker_pool_create(int thread_count)
+{
+  /* Zero selects one thread per logical CPU */
+  if (thread_count <= 0)
+    thread_count = SDL_GetCPUCount();
+  thread_count = SDL_max(1, SDL_min(thread_count, WORKER_POOL_MAX_THREADS));
+
+  worker_pool_ts * const p_pool = calloc(1, sizeof(worker_pool_ts));
+  if (p_pool == NULL)
+  {
+    fprintf(stderr, "\nCould not allocate worker pool - Error: Calloc failed");
+    return NULL;
+  }
+
+  /* The calling thread is participant zero, so only the remaining participants need a thread */
+  p_pool->thread_count = 1;
+  p_pool->p_run_mutex = SDL_CreateMutex();
+  p_pool->p_mutex = SDL_CreateMutex();
+  p_pool->p_work_available = SDL_CreateCond();
+  p_pool->p_workers_idle = SDL_CreateCond();
+  if (p_pool->p_run_mutex == NULL || p_pool->p_mutex == NULL || p_pool->p_work_available == NULL || p_pool->p_workers_idle == NULL)
+  {
+    fprintf(stderr, "\nWorker pool synchronization primitives could not be created - Error: %s", SDL_GetError());
+    worker_pool_destroy(p_pool);
+    return NULL;
+  }
+
+  for (int participant = 1; participant < thread_count; participant++)
+  {
+    worker_thread_ts * const p_worker = &p_pool->workers[participant];
+    p_worker->p_pool = p_pool;
+    p_worker->participant = participant;
+    p_worker->p_thread = SDL_CreateThread(worker_thread_main, "worker", p_worker);
+    if (p_worker->p_thread == NULL)
+    {
+      fprintf(stderr, "\nWorker thread could not be created - Error: %s", SDL_GetError());
+      worker_pool_destroy(p_pool);
+      return NULL;
+    }
+    p_pool->thread_count = participant + 1;
+  }
+
+  return p_pool;
+}
+
+void worker_pool_destroy(worker_pool_ts * p_pool)
+{
+  if (p_pool == NULL)
+    return;
+
+  if (p_pool->p_mutex != NULL)
+  {
+    SDL_LockMutex(p_pool->p_mutex);
+    p_pool->quit_requested = 1;
+    if (p_pool->p_work_available != NULL)
+      SDL_CondBroadcast(p_pool->p_work_available);
+    SDL_UnlockMutex(p_pool->p_mutex);
+  }
+
+  for (int participant = 1; participant < p_pool->thread_count; participant++)
+  {
+    SDL_WaitThread(p_pool->workers[participant].p_thread, NULL);
+  }
+
+  if (p_pool->p_workers_idle != NULL)
+    SDL_DestroyCond(p_pool->p_workers_idle);
+  if (p_pool->p_work_available != NULL)
+    SDL_DestroyCond(p_pool->p_work_available);
+  if (p_pool->p_mutex != NULL)
+    SDL_DestroyMutex(p_pool->p_mutex);
+  if (p_pool->p_run_mutex != NULL)
+    SDL_DestroyMutex(p_pool->p_run_mutex);
+  free(p_pool);
+}
+
+int worker_pool_thread_count(const worker_pool_ts * p_pool)
+{
+  return (p_pool != NULL) ? p_pool->thread_count : 1;
+}
+
+/*
+    Runs the rows function over [0, row_count) split into row bands, with the calling thread taking part.
+    Returns only after every band is processed, which makes it the barrier of the stage.
+    Several threads may start runs on the same pool, which then take turns
+*/
+void worker_pool_for_rows(worker_pool_ts * p_pool, int row_count, worker_rows_tf rows_function, void * p_job_data)
+{
+  if (p_pool == NULL || p_pool->thread_count <= 1 || row_count <= 1)
+  {
+    rows_function(p_job_data, 0, row_count);
+    return;
+  }
+
+  /* Several bands per participant leave room for stealing when bands take uneven time */
+  const int jobs_wanted = p_pool->thread_count * WORKER_POOL_JOBS_PER_THREAD;
+  const int rows_per_job = SDL_max(1, (row_count + jobs_wanted - 1) / jobs_wanted);
+  const int job_count = (row_count + rows_per_job - 1) / rows_per_job;
+
+  SDL_LockMutex(p_pool->p_run_mutex);
+  SDL_LockMutex(p_pool->p_mutex);
+
+  /* Workers still scanning the queues of the previous run must leave before the queues are reused */
+  worker_pool_wait_idle(p_pool);
+
+  for (int participant = 0; participant < p_pool->thread_count; participant++)
+  {
+    SDL_AtomicSet(&p_pool->queues[participant].next_job, (job_count * participant) / p_pool->thread_count);
+    p_pool->queues[participant].end_job = (job_count * (participant + 1)) / p_pool->thread_count;
+  }
+  p_pool->rows_function = rows_function;
+  p_pool->p_job_data = p_job_data;
+  p_pool->row_count = row_count;
+  p_pool->rows_per_job = rows_per_job;
+  p_pool->generation++;
+  SDL_CondBroadcast(p_pool->p_work_available);
+  SDL_UnlockMutex(p_pool->p_mutex);
+
+  worker_pool_participate(p_pool, 0, rows_function, p_job_data, row_count, rows_per_job);
+
+  /*
+      Every job is claimed once the calling thread runs out of work, and every claimed job
+      completes before its worker becomes idle again
+  */
+  SDL_LockMutex(p_pool->p_mutex);
+  worker_pool_wait_idle(p_pool);
+  SDL_UnlockMutex(p_pool->p_mutex);
+  SDL_UnlockMutex(p_pool->p_run_mutex);
+}
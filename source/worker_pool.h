@@ -0,0 +1,56 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <SDL.h>
+
+/* Defines */
+#define WORKER_POOL_MAX_THREADS (64)
+
+/* Datatypes */
+typedef void (* worker_rows_tf)(void * p_job_data, int row_begin, int row_end);
+
+/* Job range of one participant, padded to a cache line so participants do not contend on neighbouring cursors */
+typedef struct {
+  SDL_atomic_t next_job;
+  int end_job;
+  char padding[64 - sizeof(SDL_atomic_t) - sizeof(int)];
+} worker_queue_ts;
+
+typedef struct worker_pool_s worker_pool_ts;
+
+typedef struct {
+  worker_pool_ts * p_pool;
+  int participant;
+  SDL_Thread * p_thread;
+} worker_thread_ts;
+
+struct worker_pool_s {
+  int thread_count;
+  worker_thread_ts workers[WORKER_POOL_MAX_THREADS];
+  worker_queue_ts queues[WORKER_POOL_MAX_THREADS];
+
+  /* Serializes runs started by different calling threads, which share the queues */
+  SDL_mutex * p_run_mutex;
+
+  /* Run state, guarded by the mutex */
+  SDL_mutex * p_mutex;
+  SDL_cond * p_work_available;
+  SDL_cond * p_workers_idle;
+  uint32_t generation;
+  int active_workers;
+  int quit_requested;
+
+  /* Job description of the current run */
+  worker_rows_tf rows_function;
+  void * p_job_data;
+  int row_count;
+  int rows_per_job;
+};
+
+/* Function prototypes */
+worker_pool_ts * worker_pool_create(int thread_count);
+void worker_pool_destroy(worker_pool_ts * p_pool);
+int worker_pool_thread_count(const worker_pool_ts * p_pool);
+void worker_pool_for_rows(worker_pool_ts * p_pool, int row_count, worker_rows_tf rows_function, void * p_job_data);
+
+#endif